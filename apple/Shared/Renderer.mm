@@ -15,6 +15,18 @@
 @property (nonatomic, strong) id <MTLCommandQueue> commandQueue;
 @end
 
+// The view we render into, woken up by App::RequestRedraw
+static __weak MTKView *RedrawView = nil;
+
+static void SetViewNeedsDisplay(MTKView *view)
+{
+#if TARGET_OS_OSX
+    view.needsDisplay = YES;
+#else
+    [view setNeedsDisplay];
+#endif
+}
+
 @implementation Renderer
 
 -(nonnull instancetype)initWithView:(nonnull MTKView *)view;
@@ -34,7 +46,20 @@
         io.FontAllowUserScaling = true;
 
         ImGui_ImplMetal_Init(_device);
-        
+
+        // Only draw when something changed rather than continuously at the display refresh rate
+        view.paused = YES;
+        view.enableSetNeedsDisplay = YES;
+        RedrawView = view;
+        App::SetRedrawCallback([]() {
+            // Redraw requests may come from worker threads
+            dispatch_async(dispatch_get_main_queue(), ^{
+                if (MTKView *view = RedrawView)
+                {
+                    SetViewNeedsDisplay(view);
+                }
+            });
+        });
     }
 
     return self;
@@ -76,7 +101,7 @@
 #endif
         ImGui::NewFrame();
 
-        bool appContinue = RenderWindow();
+        bool appContinue = App::RenderWindow();
 
         // Rendering
         ImGui::Render();
@@ -90,6 +115,17 @@
     }
 
     [commandBuffer commit];
+
+    // Schedule the next frame, if the app wants one before the next input event
+    const double redrawTimeout = App::GetRedrawTimeout();
+    if (redrawTimeout == 0.0)
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{ SetViewNeedsDisplay(view); });
+    }
+    else if (redrawTimeout > 0.0)
+    {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(redrawTimeout * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{ SetViewNeedsDisplay(view); });
+    }
 }
 
 - (void)mtkView:(MTKView *)view drawableSizeWillChange:(CGSize)size
@@ -1,6 +1,7 @@
 #import "ViewController.h"
 #import "Renderer.h"
 #include "imgui.h"
+#include "app.h"
 
 #if TARGET_OS_OSX
 #include "imgui_impl_osx.h"
@@ -50,6 +51,7 @@
     NSEventMask eventMask = NSEventMaskKeyDown | NSEventMaskKeyUp | NSEventMaskFlagsChanged | NSEventTypeScrollWheel;
     [NSEvent addLocalMonitorForEventsMatchingMask:eventMask handler:^NSEvent * _Nullable(NSEvent *event) {
         BOOL wantsCapture = ImGui_ImplOSX_HandleEvent(event, self.view);
+        App::RequestRedraw();
         if (event.type == NSEventTypeKeyDown && wantsCapture) {
             return nil;
         } else {
@@ -66,22 +68,27 @@
 
 - (void)mouseMoved:(NSEvent *)event {
     ImGui_ImplOSX_HandleEvent(event, self.view);
+    App::RequestRedraw();
 }
 
 - (void)mouseDown:(NSEvent *)event {
     ImGui_ImplOSX_HandleEvent(event, self.view);
+    App::RequestRedraw();
 }
 
 - (void)mouseUp:(NSEvent *)event {
     ImGui_ImplOSX_HandleEvent(event, self.view);
+    App::RequestRedraw();
 }
 
 - (void)mouseDragged:(NSEvent *)event {
     ImGui_ImplOSX_HandleEvent(event, self.view);
+    App::RequestRedraw();
 }
 
 - (void)scrollWheel:(NSEvent *)event {
     ImGui_ImplOSX_HandleEvent(event, self.view);
+    App::RequestRedraw();
 }
 
 #elif TARGET_OS_IOS
@@ -105,6 +112,7 @@
         }
     }
     io.MouseDown[0] = hasActiveTouch;
+    App::RequestRedraw();
 }
 
 - (void)touchesBegan:(NSSet<UITouch *> *)touches withEvent:(UIEvent *)event {
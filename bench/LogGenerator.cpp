@@ -0,0 +1,226 @@
+#include "LogGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static const char* KnownCategories[] =
+{
+	"LogTemp", "LogNet", "LogNetTraffic", "LogStreaming", "LogLoad", "LogInit", "LogOnline", "LogPlayerController",
+	"LogAI", "LogAudio", "LogRHI", "LogSlate", "LogWorld", "LogGameMode", "LogPhysics", "LogAnimation",
+	"LogHttp", "LogConfig", "LogPakFile", "LogShaderCompilers", "LogGarbage", "LogCharacter", "LogReplicationGraph", "LogBlueprint"
+};
+
+static const char* MessageTemplates[] =
+{
+	"Took %f seconds to load %s",
+	"Player %s (id %d) joined the session",
+	"Actor %s_%d at (X=%f,Y=%f,Z=%f)",
+	"Ping: %d",
+	"Mem: %d MB",
+	"LoadMap: /Game/Maps/%s",
+	"Replicated %d properties for %s_%d",
+	"Spawned actor %s_%d in %f ms",
+	"Connection %g closed: %s",
+	"GC took %f ms, purged %d objects",
+	"Failed to find object '%s_%d' in package /Game/%s",
+	"Tick group %s took %f ms",
+};
+
+static const char* Names[] =
+{
+	"Alpha", "Bravo", "Charlie", "Delta", "Echo", "Foxtrot", "Golf", "Hotel", "India", "Juliet",
+	"BP_PlayerCharacter", "BP_Projectile", "StaticMeshActor", "PointLight", "Landscape", "NavMesh", "Entry", "Arena",
+};
+
+static const char* Modules[] = { "Core", "CoreUObject", "Engine", "Renderer", "RHI", "Slate", "OnlineSubsystem", "Game" };
+
+FLogGenerator::FLogGenerator(const FLogGeneratorSettings& InSettings)
+	: Settings(InSettings)
+	, RandomState(InSettings.Seed)
+	, NumCategories(std::max(1, std::min(InSettings.NumCategories, 256)))
+{
+	const int NumKnownCategories = sizeof(KnownCategories) / sizeof(KnownCategories[0]);
+	double TotalWeight = 0.0;
+	for (int CategoryIdx = 0; CategoryIdx < NumCategories; ++CategoryIdx)
+	{
+		if (CategoryIdx < NumKnownCategories)
+		{
+			CategoryNames[CategoryIdx] = KnownCategories[CategoryIdx];
+		}
+		else
+		{
+			CategoryNames[CategoryIdx] = "LogGame" + std::to_string(CategoryIdx);
+		}
+		TotalWeight += 1.0 / pow(CategoryIdx + 1, Settings.CategorySkew);
+		CategoryCdf[CategoryIdx] = TotalWeight;
+	}
+	for (int CategoryIdx = 0; CategoryIdx < NumCategories; ++CategoryIdx)
+	{
+		CategoryCdf[CategoryIdx] /= TotalWeight;
+	}
+}
+
+uint64_t FLogGenerator::NextRandom()
+{
+	// splitmix64, so the output does not depend on the standard library implementation
+	uint64_t Z = (RandomState += 0x9E3779B97F4A7C15ull);
+	Z = (Z ^ (Z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	Z = (Z ^ (Z >> 27)) * 0x94D049BB133111EBull;
+	return Z ^ (Z >> 31);
+}
+
+double FLogGenerator::NextUnit()
+{
+	return (NextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+int FLogGenerator::PickCategory()
+{
+	const double Value = NextUnit();
+	return int(std::lower_bound(CategoryCdf, CategoryCdf + NumCategories - 1, Value) - CategoryCdf);
+}
+
+void FLogGenerator::AppendPrefix(std::string& OutText)
+{
+	// Days to civil date, from Howard Hinnant's date algorithms
+	const uint64_t BaseEpochSeconds = 1586946153; // 2020.04.15-10.22.33
+	const uint64_t Seconds = BaseEpochSeconds + TimeMs / 1000;
+	const int64_t Days = Seconds / 86400;
+	const int SecondOfDay = int(Seconds % 86400);
+	const int64_t Z = Days + 719468;
+	const int64_t Era = Z / 146097;
+	const int DayOfEra = int(Z - Era * 146097);
+	const int YearOfEra = (DayOfEra - DayOfEra / 1460 + DayOfEra / 36524 - DayOfEra / 146096) / 365;
+	const int DayOfYear = DayOfEra - (365 * YearOfEra + YearOfEra / 4 - YearOfEra / 100);
+	const int MonthPrime = (5 * DayOfYear + 2) / 153;
+	const int Day = DayOfYear - (153 * MonthPrime + 2) / 5 + 1;
+	const int Month = MonthPrime < 10 ? MonthPrime + 3 : MonthPrime - 9;
+	const int Year = int(YearOfEra + Era * 400) + (Month <= 2);
+
+	char Buffer[64];
+	snprintf(Buffer, sizeof(Buffer), "[%04d.%02d.%02d-%02d.%02d.%02d:%03d][%3d]", Year, Month, Day,
+		SecondOfDay / 3600, (SecondOfDay / 60) % 60, SecondOfDay % 60, int(TimeMs % 1000), int(FrameCounter % 1000));
+	OutText += Buffer;
+}
+
+void FLogGenerator::AppendMessage(std::string& OutText, int Category)
+{
+	const int NumTemplates = sizeof(MessageTemplates) / sizeof(MessageTemplates[0]);
+	const int NumNames = sizeof(Names) / sizeof(Names[0]);
+
+	// Each category mostly logs a handful of its own messages
+	const int TemplateIdx = int((NextUnit() < 0.8 ? Category + NextRandom() % 3 : NextRandom()) % NumTemplates);
+	char Buffer[64];
+	for (const char* Char = MessageTemplates[TemplateIdx]; *Char; ++Char)
+	{
+		if (Char[0] != '%' || !Char[1])
+		{
+			OutText += *Char;
+			continue;
+		}
+		switch (*++Char)
+		{
+		case 'd': snprintf(Buffer, sizeof(Buffer), "%d", int(NextRandom() % 100000)); break;
+		case 'f': snprintf(Buffer, sizeof(Buffer), "%.3f", NextUnit() * 1000.0); break;
+		case 's': snprintf(Buffer, sizeof(Buffer), "%s", Names[NextRandom() % NumNames]); break;
+		case 'g': snprintf(Buffer, sizeof(Buffer), "%016llX%016llX", (unsigned long long)NextRandom(), (unsigned long long)NextRandom()); break;
+		default: Buffer[0] = *Char; Buffer[1] = 0; break;
+		}
+		OutText += Buffer;
+	}
+
+	if (NextUnit() < Settings.LongLineFraction)
+	{
+		OutText += " Assets:";
+		const int NumAssets = 50 + int(NextRandom() % 200);
+		for (int AssetIdx = 0; AssetIdx < NumAssets; ++AssetIdx)
+		{
+			snprintf(Buffer, sizeof(Buffer), " /Game/Content/%s/%s_%d,", Names[NextRandom() % NumNames], Names[NextRandom() % NumNames], AssetIdx);
+			OutText += Buffer;
+		}
+	}
+}
+
+void FLogGenerator::AppendCallstackLine(std::string& OutText)
+{
+	const int NumModules = sizeof(Modules) / sizeof(Modules[0]);
+	const char* Module = Modules[NextRandom() % NumModules];
+	char Buffer[256];
+	snprintf(Buffer, sizeof(Buffer), "[Callstack] 0x%016llx UE4Editor-%s.dll!F%sFunction%d() [D:\\Build\\++UE4\\Sync\\Engine\\Source\\Runtime\\%s\\Private\\File%d.cpp:%d]",
+		(unsigned long long)(0x00007ff600000000ull + (NextRandom() & 0xffffffffull)), Module, Module, CallstackDepth, Module, int(NextRandom() % 100), int(NextRandom() % 3000));
+	OutText += Buffer;
+	++CallstackDepth;
+}
+
+void FLogGenerator::AppendLine(std::string& OutText)
+{
+	if (!bWroteHeader)
+	{
+		OutText += "Log file open, 04/15/20 10:22:33";
+		bWroteHeader = true;
+		return;
+	}
+
+	if (PendingCallstackLines > 0)
+	{
+		--PendingCallstackLines;
+		AppendCallstackLine(OutText);
+		return;
+	}
+
+	// Advance the simulated clock
+	TimeMs += uint64_t(NextUnit() * 2.0 / Settings.LinesPerMillisecond);
+	if (NextUnit() * Settings.LinesPerFrame < 1.0) ++FrameCounter;
+
+	AppendPrefix(OutText);
+	if (NumMessages > 0 && NextUnit() < Settings.RepeatedMessageFraction)
+	{
+		OutText += RecentMessages[NextRandom() % std::min<uint64_t>(NumMessages, NumRecentMessages)];
+		return;
+	}
+	const size_t MessageStart = OutText.size();
+	const int Category = PickCategory();
+	OutText += CategoryNames[Category];
+	OutText += ": ";
+
+	double Verbosity = NextUnit();
+	if ((Verbosity -= Settings.ErrorFraction) < 0.0)
+	{
+		OutText += "Error: ";
+		if (NextUnit() < Settings.CallstackFraction)
+		{
+			PendingCallstackLines = 8 + int(NextRandom() % 16);
+			CallstackDepth = 0;
+		}
+	}
+	else if ((Verbosity -= Settings.WarningFraction) < 0.0) OutText += "Warning: ";
+	else if ((Verbosity -= Settings.VerboseFraction) < 0.0) OutText += "Verbose: ";
+	else if ((Verbosity -= Settings.VeryVerboseFraction) < 0.0) OutText += "VeryVerbose: ";
+
+	AppendMessage(OutText, Category);
+	RecentMessages[NumMessages++ % NumRecentMessages].assign(OutText, MessageStart, std::string::npos);
+}
+
+bool FLogGenerator::WriteFile(const std::string& FilePath, uint64_t NumBytes)
+{
+	FILE* File = fopen(FilePath.c_str(), "wb");
+	if (!File) return false;
+
+	std::string Buffer;
+	Buffer.reserve(1 << 21);
+	uint64_t NumWritten = 0;
+	bool bSuccess = true;
+	while (bSuccess && NumWritten < NumBytes)
+	{
+		while (Buffer.size() < (1 << 20))
+		{
+			AppendLine(Buffer);
+			Buffer += '\n';
+		}
+		bSuccess = fwrite(Buffer.data(), 1, Buffer.size(), File) == Buffer.size();
+		NumWritten += Buffer.size();
+		Buffer.clear();
+	}
+	return fclose(File) == 0 && bSuccess;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/** Settings for generating a synthetic log that looks like Unreal Engine output */
+struct FLogGeneratorSettings
+{
+	uint64_t Seed = 1;
+
+	// Number of categories, picked with a Zipf distribution so a few categories dominate the log
+	int NumCategories = 64;
+	double CategorySkew = 1.1;
+
+	// Verbosity mix, the remainder is plain Log lines
+	double ErrorFraction = 0.01;
+	double WarningFraction = 0.05;
+	double VerboseFraction = 0.08;
+	double VeryVerboseFraction = 0.03;
+
+	// Chance of a line being very long (a few KB), e.g. dumped config or asset lists
+	double LongLineFraction = 0.005;
+
+	// Chance of an error being followed by a multi-line callstack without timestamps
+	double CallstackFraction = 0.2;
+
+	// Chance of a line repeating one of the recent messages word for word, as servers spamming the same warning do
+	double RepeatedMessageFraction = 0.0;
+
+	// Average number of lines logged per frame and per millisecond of log time
+	double LinesPerFrame = 6.0;
+	double LinesPerMillisecond = 0.5;
+};
+
+/** Generates an endless stream of synthetic log lines. Deterministic for a given seed on every platform. */
+class FLogGenerator
+{
+public:
+	FLogGenerator(const FLogGeneratorSettings& InSettings);
+
+	/** Appends the next line, without its line terminator, to OutText */
+	void AppendLine(std::string& OutText);
+
+	/** Writes a log of at least the given size in bytes, returns false if the file could not be written */
+	bool WriteFile(const std::string& FilePath, uint64_t NumBytes);
+
+private:
+	uint64_t NextRandom();
+	double NextUnit();
+	int PickCategory();
+	void AppendPrefix(std::string& OutText);
+	void AppendMessage(std::string& OutText, int Category);
+	void AppendCallstackLine(std::string& OutText);
+
+	FLogGeneratorSettings Settings;
+	uint64_t RandomState;
+	std::string CategoryNames[256];
+	double CategoryCdf[256];
+	int NumCategories;
+
+	// Simulated clock
+	uint64_t TimeMs = 0;
+	uint64_t FrameCounter = 0;
+	int PendingCallstackLines = 0;
+	int CallstackDepth = 0;
+	bool bWroteHeader = false;
+
+	// Recent messages after the prefix, for RepeatedMessageFraction
+	static const int NumRecentMessages = 256;
+	std::string RecentMessages[NumRecentMessages];
+	uint64_t NumMessages = 0;
+};
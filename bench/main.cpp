@@ -0,0 +1,349 @@
+// Microbenchmarks for the core paths of the log viewer, run against a synthetic Unreal Engine log.
+//
+// Usage: bench [--size MB] [--seed N] [--repeat FRACTION] [--reps N] [--filter NAME] [--log PATH] [--json PATH]
+//   --size    size of the generated log in megabytes (default 64)
+//   --seed    seed for the log generator (default 1)
+//   --repeat  chance of a line repeating one of the recent messages word for word, from 0 to 1 (default 0)
+//   --reps    repetitions per benchmark, the median and minimum are reported (default 5)
+//   --filter  only run benchmarks whose name contains this string
+//   --log     where to write the generated log and keep it afterwards, or an existing log to use with --size 0
+//   --json    also write the results as JSON
+
+#include "FileUtils.h"
+#include "GlobalSearch.h"
+#include "LogDiff.h"
+#include "LogFile.h"
+#include "LogGenerator.h"
+#include "LogTemplates.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct FBenchResult
+{
+	std::string Name;
+	int NumReps = 0;
+	double MinMs = 0.0;
+	double MedianMs = 0.0;
+	uint64_t NumLines = 0;
+	uint64_t NumBytes = 0;
+};
+
+// Benchmarks add their results in here so the optimizer cannot drop the work
+static volatile uint64_t Sink = 0;
+
+static std::vector<FBenchResult> Results;
+static std::string NameFilter;
+static int NumReps = 5;
+
+static void RunBenchmark(const std::string& Name, uint64_t NumLines, uint64_t NumBytes, const std::function<uint64_t()>& Func)
+{
+	if (!NameFilter.empty() && Name.find(NameFilter) == std::string::npos) return;
+
+	std::vector<double> TimesMs;
+	for (int RepIdx = 0; RepIdx < NumReps; ++RepIdx)
+	{
+		const auto StartTime = std::chrono::steady_clock::now();
+		Sink += Func();
+		TimesMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count());
+	}
+	std::sort(TimesMs.begin(), TimesMs.end());
+
+	FBenchResult Result;
+	Result.Name = Name;
+	Result.NumReps = NumReps;
+	Result.MinMs = TimesMs.front();
+	Result.MedianMs = TimesMs[TimesMs.size() / 2];
+	Result.NumLines = NumLines;
+	Result.NumBytes = NumBytes;
+	Results.push_back(Result);
+
+	const double Seconds = Result.MedianMs / 1000.0;
+	printf("%-48s %10.2f ms %10.2f ms %9.1f Mlines/s %9.1f MB/s\n", Name.c_str(), Result.MedianMs, Result.MinMs,
+		NumLines / Seconds / 1e6, NumBytes / Seconds / (1024.0 * 1024.0));
+	fflush(stdout);
+}
+
+static bool WriteJson(const std::string& FilePath, const std::string& LogPath, uint64_t Seed)
+{
+	FILE* Out = fopen(FilePath.c_str(), "w");
+	if (!Out) return false;
+	fprintf(Out, "{\n  \"log\": \"%s\",\n  \"seed\": %llu,\n  \"reps\": %d,\n  \"results\": [\n", LogPath.c_str(), (unsigned long long)Seed, NumReps);
+	for (size_t ResultIdx = 0; ResultIdx < Results.size(); ++ResultIdx)
+	{
+		const FBenchResult& Result = Results[ResultIdx];
+		fprintf(Out, "    { \"name\": \"%s\", \"median_ms\": %.4f, \"min_ms\": %.4f, \"lines\": %llu, \"bytes\": %llu }%s\n",
+			Result.Name.c_str(), Result.MedianMs, Result.MinMs, (unsigned long long)Result.NumLines, (unsigned long long)Result.NumBytes,
+			ResultIdx + 1 < Results.size() ? "," : "");
+	}
+	fprintf(Out, "  ]\n}\n");
+	return fclose(Out) == 0;
+}
+
+static FLineFilter MakeTextFilter(EFilterType Type, const std::string& Token, bool bCaseMatch)
+{
+	FLineFilter Filter;
+	Filter.Type = Type;
+	Filter.TextData.Token = Token;
+	Filter.TextData.bCaseMatch = bCaseMatch;
+	Filter.bEnable = true;
+	return Filter;
+}
+
+static FLineFilter MakeCategoryFilter(const std::string& Category, ELogVerbosity Verbosity)
+{
+	FLineFilter Filter;
+	Filter.Type = EFilterType::LogCategory;
+	Filter.LogCategoryData.Category = Category;
+	Filter.LogCategoryData.Verbosity = Verbosity;
+	Filter.bEnable = true;
+	return Filter;
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t SizeMB = 64;
+	FLogGeneratorSettings Settings;
+	std::string LogPath;
+	std::string JsonPath;
+
+	for (int ArgIdx = 1; ArgIdx < argc; ++ArgIdx)
+	{
+		const std::string Arg = argv[ArgIdx];
+		const bool bHasValue = ArgIdx + 1 < argc;
+		if (Arg == "--size" && bHasValue) SizeMB = strtoull(argv[++ArgIdx], nullptr, 10);
+		else if (Arg == "--seed" && bHasValue) Settings.Seed = strtoull(argv[++ArgIdx], nullptr, 10);
+		else if (Arg == "--repeat" && bHasValue) Settings.RepeatedMessageFraction = atof(argv[++ArgIdx]);
+		else if (Arg == "--reps" && bHasValue) NumReps = std::max(1, atoi(argv[++ArgIdx]));
+		else if (Arg == "--filter" && bHasValue) NameFilter = argv[++ArgIdx];
+		else if (Arg == "--log" && bHasValue) LogPath = argv[++ArgIdx];
+		else if (Arg == "--json" && bHasValue) JsonPath = argv[++ArgIdx];
+		else
+		{
+			fprintf(stderr, "Usage: %s [--size MB] [--seed N] [--repeat FRACTION] [--reps N] [--filter NAME] [--log PATH] [--json PATH]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const bool bKeepLog = !LogPath.empty();
+	if (LogPath.empty())
+	{
+		LogPath = "ulv_bench_" + std::to_string(Settings.Seed) + ".log";
+	}
+	if (SizeMB > 0)
+	{
+		printf("Generating %llu MB log with seed %llu to %s\n", (unsigned long long)SizeMB, (unsigned long long)Settings.Seed, LogPath.c_str());
+		if (!FLogGenerator(Settings).WriteFile(LogPath, SizeMB * 1024 * 1024))
+		{
+			fprintf(stderr, "Failed to write %s\n", LogPath.c_str());
+			return 1;
+		}
+	}
+
+	const FLineStore Lines = FileUtils::ReadFileContents(LogPath);
+	uint64_t NumBytes = 0;
+	Lines.ForEachLine(0, Lines.Num(), [&](uint64_t, FStringView Line) { NumBytes += Line.Size + 1; });
+	const uint64_t NumLines = Lines.Num();
+	printf("%llu lines, %.1f MB\n\n", (unsigned long long)NumLines, NumBytes / (1024.0 * 1024.0));
+	printf("%-48s %13s %13s %18s %14s\n", "Benchmark", "Median", "Min", "Throughput", "");
+
+	RunBenchmark("FileUtils::ReadFileContents", NumLines, NumBytes, [&]()
+	{
+		return (uint64_t)FileUtils::ReadFileContents(LogPath).Num();
+	});
+
+	RunBenchmark("FileUtils::ReadFileContents/Paged", NumLines, NumBytes, [&]()
+	{
+		return (uint64_t)FileUtils::ReadFileContents(LogPath, ELineStorage::Paged).Num();
+	});
+
+	RunBenchmark("FileUtils::ReadFileContents/Compressed", NumLines, NumBytes, [&]()
+	{
+		return (uint64_t)FileUtils::ReadFileContents(LogPath, ELineStorage::Compressed).Num();
+	});
+
+	RunBenchmark("FLogLineMetadata", NumLines, NumBytes, [&]()
+	{
+		uint64_t NumErrors = 0;
+		Lines.ForEachLine(0, Lines.Num(), [&](uint64_t, FStringView Line)
+		{
+			NumErrors += FLogLineMetadata(Line).LineType == ELogLineType::Error;
+		});
+		return NumErrors;
+	});
+
+	struct FFilterBenchmark
+	{
+		const char* Name;
+		FLineFilter Filter;
+	};
+	const FFilterBenchmark FilterBenchmarks[] =
+	{
+		{ "TextInclude/CaseSensitive", MakeTextFilter(EFilterType::TextInclude, "Player", true) },
+		{ "TextInclude/CaseInsensitive", MakeTextFilter(EFilterType::TextInclude, "player", false) },
+		{ "TextExclude/CaseSensitive", MakeTextFilter(EFilterType::TextExclude, "Verbose", true) },
+		{ "TextExclude/CaseInsensitive", MakeTextFilter(EFilterType::TextExclude, "verbose", false) },
+		{ "LogCategory/Off", MakeCategoryFilter("LogNet", ELogVerbosity::Off) },
+		{ "LogCategory/Error", MakeCategoryFilter("LogNet", ELogVerbosity::Error) },
+		{ "LogCategory/Warning", MakeCategoryFilter("LogNet", ELogVerbosity::Warning) },
+		{ "LogCategory/Log", MakeCategoryFilter("LogNet", ELogVerbosity::Log) },
+		{ "LogCategory/Verbose", MakeCategoryFilter("LogNet", ELogVerbosity::Verbose) },
+	};
+	for (const FFilterBenchmark& Benchmark : FilterBenchmarks)
+	{
+		const std::vector<FLineFilter> Filters(1, Benchmark.Filter);
+		RunBenchmark(std::string("DoFilterLine/") + Benchmark.Name, NumLines, NumBytes, [&]()
+		{
+			uint64_t NumIncluded = 0;
+			Lines.ForEachLine(0, Lines.Num(), [&](uint64_t, FStringView Line)
+			{
+				NumIncluded += DoFilterLine(Filters, Line);
+			});
+			return NumIncluded;
+		});
+	}
+
+	struct FSearchBenchmark
+	{
+		const char* Name;
+		FSearchQuery Query;
+	};
+	const FSearchBenchmark SearchBenchmarks[] =
+	{
+		{ "CaseSensitive", { "Player", true, false } },
+		{ "CaseInsensitive", { "player", false, false } },
+		{ "Regex", { "BP_Player[A-Za-z]+", true, true } },
+	};
+	for (const FSearchBenchmark& Benchmark : SearchBenchmarks)
+	{
+		// The same text four times over, as if four logs were open
+		const std::vector<const FLineStore*> Files(4, &Lines);
+		RunBenchmark(std::string("FGlobalSearch/") + Benchmark.Name, NumLines * 4, NumBytes * 4, [&]()
+		{
+			FGlobalSearch Search;
+			Search.Start(Files, Benchmark.Query, nullptr);
+			Search.Wait();
+			return Search.GetFileHits(0).Num();
+		});
+	}
+
+	FLogFile LogFile(LogPath, FLineStore(Lines));
+	struct FDisplayLinesBenchmark
+	{
+		const char* Name;
+		std::vector<FLineFilter> Filters;
+	};
+	const FDisplayLinesBenchmark DisplayLinesBenchmarks[] =
+	{
+		{ "Unfiltered", {} },
+		{ "Include", { MakeTextFilter(EFilterType::TextInclude, "Player", true) } },
+		{ "IncludeExcludeCategory", {
+			MakeTextFilter(EFilterType::TextInclude, "actor", false),
+			MakeTextFilter(EFilterType::TextExclude, "Verbose", true),
+			MakeCategoryFilter("LogTemp", ELogVerbosity::Warning) } },
+	};
+	for (const FDisplayLinesBenchmark& Benchmark : DisplayLinesBenchmarks)
+	{
+		LogFile.Filters = Benchmark.Filters;
+		RunBenchmark(std::string("FLogFile::GetDisplayLines/") + Benchmark.Name, NumLines, NumBytes, [&]()
+		{
+			LogFile.bDisplayTextDirty = true;
+			return (uint64_t)LogFile.GetDisplayLines().Num();
+		});
+	}
+
+	// Streams the text back from the file through a page cache much smaller than the log
+	FLogFile PagedLogFile(LogPath, FileUtils::ReadFileContents(LogPath, ELineStorage::Paged));
+	PagedLogFile.Lines.SetCacheBudget(16 * 1024 * 1024);
+	PagedLogFile.Filters = DisplayLinesBenchmarks[1].Filters;
+	RunBenchmark("FLogFile::GetDisplayLines/Paged/Include", NumLines, NumBytes, [&]()
+	{
+		PagedLogFile.bDisplayTextDirty = true;
+		return (uint64_t)PagedLogFile.GetDisplayLines().Num();
+	});
+
+	FLogFile CompressedLogFile(LogPath, FileUtils::ReadFileContents(LogPath, ELineStorage::Compressed));
+	CompressedLogFile.Lines.SetCacheBudget(16 * 1024 * 1024);
+	CompressedLogFile.Lines.Trim(0);
+	printf("%-48s %10.1f MB compressed, %.2fx\n", "Compressed text", CompressedLogFile.Lines.GetTextBytes() / (1024.0 * 1024.0),
+		double(NumBytes) / CompressedLogFile.Lines.GetTextBytes());
+	CompressedLogFile.Filters = DisplayLinesBenchmarks[1].Filters;
+	RunBenchmark("FLogFile::GetDisplayLines/Compressed/Include", NumLines, NumBytes, [&]()
+	{
+		CompressedLogFile.bDisplayTextDirty = true;
+		return (uint64_t)CompressedLogFile.GetDisplayLines().Num();
+	});
+
+	FLogFile DeduplicatedLogFile(LogPath, FileUtils::ReadFileContents(LogPath, ELineStorage::Deduplicated));
+	DeduplicatedLogFile.Lines.SetCacheBudget(16 * 1024 * 1024);
+	DeduplicatedLogFile.Lines.Trim(0);
+	printf("%-48s %10.1f MB in %u distinct bodies\n", "Deduplicated text", DeduplicatedLogFile.Lines.GetTextBytes() / (1024.0 * 1024.0),
+		DeduplicatedLogFile.Lines.NumBodies());
+	RunBenchmark("FileUtils::ReadFileContents/Deduplicated", NumLines, NumBytes, [&]()
+	{
+		return (uint64_t)FileUtils::ReadFileContents(LogPath, ELineStorage::Deduplicated).Num();
+	});
+	DeduplicatedLogFile.Filters = DisplayLinesBenchmarks[1].Filters;
+	RunBenchmark("FLogFile::GetDisplayLines/Deduplicated/Include", NumLines, NumBytes, [&]()
+	{
+		DeduplicatedLogFile.bDisplayTextDirty = true;
+		return (uint64_t)DeduplicatedLogFile.GetDisplayLines().Num();
+	});
+
+	RunBenchmark("FLogTemplates::Update", NumLines, NumBytes, [&]()
+	{
+		FLogTemplates Templates;
+		Templates.Update(Lines);
+		return (uint64_t)Templates.Num();
+	});
+	RunBenchmark("FLogTemplates::Update/Deduplicated", NumLines, NumBytes, [&]()
+	{
+		FLogTemplates Templates;
+		Templates.Update(DeduplicatedLogFile.Lines);
+		return (uint64_t)Templates.Num();
+	});
+
+	// Diffs the log against a copy with about one line in a thousand dropped and one in a thousand added, like two runs of the same test
+	FLineStore EditedLines;
+	uint64_t EditSeed = Settings.Seed;
+	Lines.ForEachLine(0, Lines.Num(), [&](uint64_t LineIdx, FStringView Line)
+	{
+		EditSeed = EditSeed * 6364136223846793005ull + 1442695040888963407ull;
+		const uint64_t Edit = (EditSeed >> 33) % 1000;
+		if (Edit == 0) return;
+		if (Edit == 1) EditedLines.AddLine("LogTemp: Warning: Added line " + std::to_string(LineIdx));
+		EditedLines.AddLine(Line);
+	});
+	EditedLines.Finish();
+	FDiffOptions KeepNumbersOptions;
+	KeepNumbersOptions.bIgnoreNumbers = false;
+	RunBenchmark("LogDiff::HashNormalizedLines", NumLines, NumBytes, [&]()
+	{
+		return (uint64_t)HashNormalizedLines(Lines, KeepNumbersOptions).size();
+	});
+	RunBenchmark("LogDiff::HashNormalizedLines/IgnoreNumbers", NumLines, NumBytes, [&]()
+	{
+		return (uint64_t)HashNormalizedLines(Lines, FDiffOptions()).size();
+	});
+	const std::vector<uint64_t> LeftHashes = HashNormalizedLines(Lines, KeepNumbersOptions);
+	const std::vector<uint64_t> RightHashes = HashNormalizedLines(EditedLines, KeepNumbersOptions);
+	RunBenchmark("LogDiff::DiffLineHashes", NumLines + EditedLines.Num(), 0, [&]()
+	{
+		return (uint64_t)DiffLineHashes(LeftHashes, RightHashes).size();
+	});
+
+	if (!JsonPath.empty() && !WriteJson(JsonPath, LogPath, Settings.Seed))
+	{
+		fprintf(stderr, "Failed to write %s\n", JsonPath.c_str());
+	}
+	if (!bKeepLog)
+	{
+		remove(LogPath.c_str());
+	}
+	return Sink == 0xFFFFFFFFFFFFFFFFull ? 2 : 0;
+}
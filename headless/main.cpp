@@ -0,0 +1,463 @@
+// Headless host for the app core. Renders through a null renderer so UI-side performance can be
+// measured on machines without a GPU. Runs a script of interactions against the given logs and
+// reports per-frame CPU time, draw list sizes and allocations as JSON.
+//
+// Usage: headless [--size WxH] [--script "cmd; cmd; ..."] [--out report.json] [--trace trace.json]
+//                 [--storage Auto|Memory|Paged|Compressed|Deduplicated] [--memory-budget MB] [--index-cache On|Off] <log files...>
+//
+// Script commands:
+//   frames N                  render N frames
+//   scroll LINES FRAMES       scroll the text windows by LINES every frame for FRAMES frames
+//   resize WxH                change the display size
+//   wrap on|off               toggle word wrap
+//   merged on|off             show or hide the merged view of all files
+//   sync on|off               keep every view scrolled to the same time
+//   collapse on|off           show runs of duplicate lines in the text windows as one row
+//   timeline on|off [STACK]   show the timeline strips, STACK is Verbosity or Category
+//   diff LEFT RIGHT           compare two files, numbered from 1 in the order they were given, and render frames until it finishes
+//   search TEXT [OPT]         search every file and render frames until it finishes, OPT is "case" or "regex"
+//   patterns FILE             show the templates of a file, numbered from 1, and render frames until they are mined
+//   fields FILE ANCHOR [TYPE] show statistics of the values after ANCHOR in a file and render frames until they are extracted,
+//                             TYPE is Number or Integer
+//   bookmark FILE LINE        add or remove a bookmark, files and lines are numbered from 1
+//   filter TYPE VALUE [OPT]   add a filter to every file, TYPE is include, exclude, category, time, frames or region.
+//                             OPT is "case" for text filters, a verbosity name for category filters,
+//                             the end time for time filters, times are written YYYY.MM.DD-HH.MM.SS:mmm,
+//                             the last frame for frame filters, or the end marker for region filters.
+//                             Frames are relative: they count on from the first line's 3 digit frame column, which wraps
+//                             at 1000, so they only match the engine's frame counter if the log starts before frame 1000
+//   context BEFORE AFTER      show lines around the matches of the last filter added
+
+#include "imgui/imgui.h"
+#include "app.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Allocation counters, fed by both the global operator new and ImGui's allocator
+static std::atomic<size_t> NumAllocations(0);
+static std::atomic<size_t> NumAllocatedBytes(0);
+
+void* operator new(size_t Size)
+{
+	++NumAllocations;
+	NumAllocatedBytes += Size;
+	if (void* Ptr = malloc(Size ? Size : 1)) return Ptr;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t Size)
+{
+	return operator new(Size);
+}
+
+// The nothrow forms must come from the same allocator, or their deletes would free memory malloc never handed out
+void* operator new(size_t Size, const std::nothrow_t&) noexcept
+{
+	++NumAllocations;
+	NumAllocatedBytes += Size;
+	return malloc(Size ? Size : 1);
+}
+
+void* operator new[](size_t Size, const std::nothrow_t& Tag) noexcept
+{
+	return operator new(Size, Tag);
+}
+
+void operator delete(void* Ptr) noexcept
+{
+	free(Ptr);
+}
+
+void operator delete[](void* Ptr) noexcept
+{
+	free(Ptr);
+}
+
+void operator delete(void* Ptr, size_t) noexcept
+{
+	free(Ptr);
+}
+
+void operator delete[](void* Ptr, size_t) noexcept
+{
+	free(Ptr);
+}
+
+void operator delete(void* Ptr, const std::nothrow_t&) noexcept
+{
+	free(Ptr);
+}
+
+void operator delete[](void* Ptr, const std::nothrow_t&) noexcept
+{
+	free(Ptr);
+}
+
+static void* ImGuiAlloc(size_t Size, void*)
+{
+	++NumAllocations;
+	NumAllocatedBytes += Size;
+	return malloc(Size);
+}
+
+static void ImGuiFree(void* Ptr, void*)
+{
+	free(Ptr);
+}
+
+struct FFrameStats
+{
+	double CpuMs = 0.0;
+	int NumVertices = 0;
+	int NumIndices = 0;
+	int NumDrawLists = 0;
+	size_t NumAllocations = 0;
+	size_t NumAllocatedBytes = 0;
+};
+
+struct FStepStats
+{
+	std::string Command;
+	std::vector<FFrameStats> Frames;
+};
+
+static FFrameStats RenderFrame(float DeltaTime)
+{
+	FFrameStats Stats;
+	const size_t AllocationsBefore = NumAllocations;
+	const size_t AllocatedBytesBefore = NumAllocatedBytes;
+	const auto StartTime = std::chrono::steady_clock::now();
+
+	ImGui::GetIO().DeltaTime = DeltaTime;
+	ImGui::NewFrame();
+	App::RenderWindow();
+	ImGui::Render();
+
+	const auto EndTime = std::chrono::steady_clock::now();
+	Stats.CpuMs = std::chrono::duration<double, std::milli>(EndTime - StartTime).count();
+	Stats.NumAllocations = NumAllocations - AllocationsBefore;
+	Stats.NumAllocatedBytes = NumAllocatedBytes - AllocatedBytesBefore;
+
+	const ImDrawData* DrawData = ImGui::GetDrawData();
+	Stats.NumVertices = DrawData->TotalVtxCount;
+	Stats.NumIndices = DrawData->TotalIdxCount;
+	Stats.NumDrawLists = DrawData->CmdListsCount;
+	return Stats;
+}
+
+static bool ParseSize(const std::string& Text, ImVec2& OutSize)
+{
+	int Width = 0, Height = 0;
+	if (sscanf(Text.c_str(), "%dx%d", &Width, &Height) != 2 || Width <= 0 || Height <= 0) return false;
+	OutSize = ImVec2((float)Width, (float)Height);
+	return true;
+}
+
+static std::vector<std::string> SplitScript(const std::string& Script)
+{
+	std::vector<std::string> Commands;
+	std::stringstream Stream(Script);
+	std::string Command;
+	while (std::getline(Stream, Command, ';'))
+	{
+		Command.erase(0, Command.find_first_not_of(" \t"));
+		Command.erase(Command.find_last_not_of(" \t") + 1);
+		if (!Command.empty()) Commands.push_back(Command);
+	}
+	return Commands;
+}
+
+/** Runs one script command, rendering however many frames it asks for. Returns false on a malformed command. */
+static bool RunCommand(const std::string& Command, FStepStats& OutStats)
+{
+	const float DeltaTime = 1.0f / 60.0f;
+	std::stringstream Stream(Command);
+	std::string Verb;
+	Stream >> Verb;
+
+	int NumFrames = 1;
+	float ScrollLines = 0.0f;
+	// Keeps rendering past NumFrames while this returns true
+	bool (*WaitWhile)() = nullptr;
+	if (Verb == "frames")
+	{
+		if (!(Stream >> NumFrames)) return false;
+	}
+	else if (Verb == "scroll")
+	{
+		if (!(Stream >> ScrollLines >> NumFrames)) return false;
+	}
+	else if (Verb == "resize")
+	{
+		std::string Size;
+		Stream >> Size;
+		if (!ParseSize(Size, ImGui::GetIO().DisplaySize)) return false;
+	}
+	else if (Verb == "wrap")
+	{
+		std::string Value;
+		Stream >> Value;
+		if (Value != "on" && Value != "off") return false;
+		App::SetWordWrap(Value == "on");
+	}
+	else if (Verb == "merged")
+	{
+		std::string Value;
+		Stream >> Value;
+		if (Value != "on" && Value != "off") return false;
+		App::SetShowMergedView(Value == "on");
+	}
+	else if (Verb == "diff")
+	{
+		int LeftFile = 0, RightFile = 0;
+		Stream >> LeftFile >> RightFile;
+		if (!App::ShowDiff(LeftFile - 1, RightFile - 1)) return false;
+		WaitWhile = &App::IsComparing;
+	}
+	else if (Verb == "search")
+	{
+		std::string Text, Option;
+		Stream >> Text >> Option;
+		if (Text.empty() || (!Option.empty() && Option != "case" && Option != "regex")) return false;
+		if (!App::Search(Text, Option == "case", Option == "regex")) return false;
+		WaitWhile = &App::IsSearching;
+	}
+	else if (Verb == "collapse")
+	{
+		std::string Value;
+		Stream >> Value;
+		if (Value != "on" && Value != "off") return false;
+		App::SetCollapseDuplicates(Value == "on");
+	}
+	else if (Verb == "timeline")
+	{
+		std::string Value, Stack;
+		Stream >> Value >> Stack;
+		if (Value != "on" && Value != "off") return false;
+		App::SetShowTimeline(Value == "on", Stack);
+	}
+	else if (Verb == "bookmark")
+	{
+		int File = 0;
+		uint64_t Line = 0;
+		Stream >> File >> Line;
+		if (Line == 0 || !App::ToggleBookmark(File - 1, Line - 1)) return false;
+	}
+	else if (Verb == "patterns")
+	{
+		int File = 0;
+		Stream >> File;
+		if (!App::ShowPatterns(File - 1)) return false;
+		WaitWhile = &App::IsMiningPatterns;
+	}
+	else if (Verb == "fields")
+	{
+		int File = 0;
+		std::string Anchor, Type;
+		Stream >> File >> Anchor >> Type;
+		if (!App::ExtractField(File - 1, Anchor, Type.empty() ? "Number" : Type)) return false;
+		WaitWhile = &App::IsExtractingFields;
+	}
+	else if (Verb == "sync")
+	{
+		std::string Value;
+		Stream >> Value;
+		if (Value != "on" && Value != "off") return false;
+		App::SetSyncScrolling(Value == "on");
+	}
+	else if (Verb == "filter")
+	{
+		std::string Type, Value, Option;
+		Stream >> Type >> Value >> Option;
+		const char* TypeName = Type == "include" ? "Text Include" : Type == "exclude" ? "Text Exclude" : Type == "category" ? "Log Category" : Type == "time" ? "Time Range" : Type == "frames" ? "Frame Range" : Type == "region" ? "Region" : nullptr;
+		if (!TypeName || Value.empty() || !App::AddFilter(TypeName, Value, Option)) return false;
+	}
+	else if (Verb == "context")
+	{
+		int Before = -1, After = -1;
+		Stream >> Before >> After;
+		if (Before < 0 || After < 0 || !App::SetFilterContext(Before, After)) return false;
+	}
+	else
+	{
+		return false;
+	}
+
+	for (int FrameIdx = 0; FrameIdx < NumFrames || (WaitWhile && WaitWhile()); ++FrameIdx)
+	{
+		if (ScrollLines != 0.0f) App::ScrollTextWindows(ScrollLines);
+		OutStats.Frames.push_back(RenderFrame(DeltaTime));
+	}
+	return true;
+}
+
+static double Percentile(std::vector<double> Values, double Fraction)
+{
+	if (Values.empty()) return 0.0;
+	std::sort(Values.begin(), Values.end());
+	const size_t Index = std::min(Values.size() - 1, (size_t)(Fraction * (Values.size() - 1) + 0.5));
+	return Values[Index];
+}
+
+static void WriteFrameSummary(FILE* Out, const std::vector<FFrameStats>& Frames, const char* Indent)
+{
+	std::vector<double> CpuMs;
+	double TotalMs = 0.0;
+	size_t MaxVertices = 0, TotalAllocations = 0, TotalAllocatedBytes = 0;
+	for (const FFrameStats& Frame : Frames)
+	{
+		CpuMs.push_back(Frame.CpuMs);
+		TotalMs += Frame.CpuMs;
+		MaxVertices = std::max(MaxVertices, (size_t)Frame.NumVertices);
+		TotalAllocations += Frame.NumAllocations;
+		TotalAllocatedBytes += Frame.NumAllocatedBytes;
+	}
+	const size_t NumFrames = std::max<size_t>(Frames.size(), 1);
+
+	fprintf(Out, "%s\"frames\": %zu,\n", Indent, Frames.size());
+	fprintf(Out, "%s\"cpu_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n", Indent,
+		TotalMs / NumFrames, Percentile(CpuMs, 0.5), Percentile(CpuMs, 0.9), Percentile(CpuMs, 0.99), Percentile(CpuMs, 1.0));
+	fprintf(Out, "%s\"vertices\": { \"last\": %d, \"max\": %zu },\n", Indent, Frames.empty() ? 0 : Frames.back().NumVertices, MaxVertices);
+	fprintf(Out, "%s\"allocations_per_frame\": %.1f,\n", Indent, (double)TotalAllocations / NumFrames);
+	fprintf(Out, "%s\"allocated_bytes_per_frame\": %.1f\n", Indent, (double)TotalAllocatedBytes / NumFrames);
+}
+
+static void WriteJsonString(FILE* Out, const std::string& Text)
+{
+	fputc('"', Out);
+	for (char Char : Text)
+	{
+		if (Char == '"' || Char == '\\') fputc('\\', Out);
+		fputc(Char, Out);
+	}
+	fputc('"', Out);
+}
+
+static void WriteReport(FILE* Out, const std::vector<std::string>& FilePaths, const std::vector<FStepStats>& Steps, double StartupMs)
+{
+	std::vector<FFrameStats> AllFrames;
+	for (const FStepStats& Step : Steps)
+	{
+		AllFrames.insert(AllFrames.end(), Step.Frames.begin(), Step.Frames.end());
+	}
+
+	fprintf(Out, "{\n  \"files\": [");
+	for (size_t FileIdx = 0; FileIdx < FilePaths.size(); ++FileIdx)
+	{
+		if (FileIdx) fprintf(Out, ", ");
+		WriteJsonString(Out, FilePaths[FileIdx]);
+	}
+	fprintf(Out, "],\n  \"startup_ms\": %.3f,\n  \"total\": {\n", StartupMs);
+	WriteFrameSummary(Out, AllFrames, "    ");
+	fprintf(Out, "  },\n  \"steps\": [\n");
+	for (size_t StepIdx = 0; StepIdx < Steps.size(); ++StepIdx)
+	{
+		fprintf(Out, "    {\n      \"command\": ");
+		WriteJsonString(Out, Steps[StepIdx].Command);
+		fprintf(Out, ",\n");
+		WriteFrameSummary(Out, Steps[StepIdx].Frames, "      ");
+		fprintf(Out, "    }%s\n", StepIdx + 1 < Steps.size() ? "," : "");
+	}
+	fprintf(Out, "  ]\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+	ImVec2 DisplaySize(1280.0f, 800.0f);
+	std::string Script = "frames 60; scroll 20 120; scroll -20 60; wrap off; scroll 50 120; resize 1920x1080; frames 60; "
+		"filter include Error; frames 60; filter exclude Warning; scroll 10 60; wrap on; frames 60";
+	std::string OutPath;
+	// Options passed through to App::Startup
+	std::vector<std::string> AppArgs;
+	std::vector<std::string> FilePaths;
+
+	for (int ArgIdx = 1; ArgIdx < argc; ++ArgIdx)
+	{
+		const std::string Arg = argv[ArgIdx];
+		const bool bHasValue = ArgIdx + 1 < argc;
+		if (Arg == "--size" && bHasValue)
+		{
+			if (!ParseSize(argv[++ArgIdx], DisplaySize))
+			{
+				fprintf(stderr, "Invalid size '%s'\n", argv[ArgIdx]);
+				return 1;
+			}
+		}
+		else if (Arg == "--script" && bHasValue) Script = argv[++ArgIdx];
+		else if (Arg == "--out" && bHasValue) OutPath = argv[++ArgIdx];
+		else if ((Arg == "--trace" || Arg == "--storage" || Arg == "--memory-budget" || Arg == "--index-cache") && bHasValue)
+		{
+			AppArgs.push_back(Arg);
+			AppArgs.push_back(argv[++ArgIdx]);
+		}
+		else if (Arg.compare(0, 2, "--") == 0)
+		{
+			fprintf(stderr, "Usage: %s [--size WxH] [--script \"cmd; cmd; ...\"] [--out report.json] [--trace trace.json] "
+				"[--storage Auto|Memory|Paged|Compressed|Deduplicated] [--memory-budget MB] [--index-cache On|Off] <log files...>\n", argv[0]);
+			return 1;
+		}
+		else FilePaths.push_back(Arg);
+	}
+
+	ImGui::SetAllocatorFunctions(ImGuiAlloc, ImGuiFree);
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO();
+	io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+	io.IniFilename = nullptr;
+	io.BackendPlatformName = "headless";
+	io.BackendRendererName = "null";
+	io.DisplaySize = DisplaySize;
+	ImGui::StyleColorsDark();
+
+	// Null renderer, we only need the font atlas built so ImGui can lay out text
+	unsigned char* FontPixels = nullptr;
+	int FontWidth = 0, FontHeight = 0;
+	io.Fonts->GetTexDataAsRGBA32(&FontPixels, &FontWidth, &FontHeight);
+	io.Fonts->TexID = (ImTextureID)(intptr_t)1;
+
+	// Startup expects argv in the same shape as the real hosts
+	std::vector<char*> StartupArgs;
+	StartupArgs.push_back(argv[0]);
+	for (std::string& AppArg : AppArgs) StartupArgs.push_back(&AppArg[0]);
+	for (std::string& FilePath : FilePaths) StartupArgs.push_back(&FilePath[0]);
+
+	const auto StartupStart = std::chrono::steady_clock::now();
+	App::Startup((int)StartupArgs.size(), StartupArgs.data());
+	const double StartupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartupStart).count();
+	App::SetShowDemoWindow(false);
+
+	std::vector<FStepStats> Steps;
+	for (const std::string& Command : SplitScript(Script))
+	{
+		Steps.emplace_back();
+		Steps.back().Command = Command;
+		if (!RunCommand(Command, Steps.back()))
+		{
+			fprintf(stderr, "Invalid script command '%s'\n", Command.c_str());
+			ImGui::DestroyContext();
+			return 1;
+		}
+	}
+
+	FILE* Out = OutPath.empty() ? stdout : fopen(OutPath.c_str(), "w");
+	if (!Out)
+	{
+		fprintf(stderr, "Could not open '%s' for writing\n", OutPath.c_str());
+		ImGui::DestroyContext();
+		return 1;
+	}
+	WriteReport(Out, FilePaths, Steps, StartupMs);
+	if (Out != stdout) fclose(Out);
+
+	ImGui::DestroyContext();
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include "DensityMap.h"
+#include "Jobs.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+const char* EDensityLayerStrings[(int)EDensityLayer::MAX + 1] =
+{
+	"Errors",
+	"Warnings",
+	"Search Hits",
+	"Bookmarks"
+};
+
+void FDensityMap::SetDisplayLines(std::shared_ptr<const FDisplayLines> InDisplayLines, uint64_t InDisplayLinesVersion, int InNumBins)
+{
+	if (DisplayLines && InDisplayLinesVersion == DisplayLinesVersion && InNumBins == NumBins) return;
+	DisplayLines = std::move(InDisplayLines);
+	DisplayLinesVersion = InDisplayLinesVersion;
+	NumBins = InNumBins;
+	++BinsVersion;
+}
+
+void FDensityMap::UpdateLayer(EDensityLayer LayerType, uint64_t LinesVersion, const std::function<std::vector<uint64_t>()>& GetLines, const std::function<void()>& OnDone)
+{
+	FLayer& Layer = Layers[(int)LayerType];
+	if (!StartUpdate(Layer, LinesVersion)) return;
+	std::shared_ptr<std::vector<uint64_t>> Lines = std::make_shared<std::vector<uint64_t>>(GetLines());
+	LaunchJob(Layer, [Lines]() { return std::move(*Lines); }, OnDone);
+}
+
+void FDensityMap::UpdateSearchHits(uint64_t HitsVersion, const std::function<FGlobalSearch::FFileHits()>& GetHits, const std::function<void()>& OnDone)
+{
+	FLayer& Layer = Layers[(int)EDensityLayer::SearchHits];
+	if (!StartUpdate(Layer, HitsVersion)) return;
+	const FGlobalSearch::FFileHits Hits = GetHits();
+	LaunchJob(Layer, [Hits]()
+	{
+		std::vector<uint64_t> HitLines(size_t(Hits.Num()));
+		for (uint64_t HitIdx = 0; HitIdx < Hits.Num(); ++HitIdx)
+		{
+			HitLines[size_t(HitIdx)] = Hits[HitIdx];
+		}
+		return HitLines;
+	}, OnDone);
+}
+
+bool FDensityMap::StartUpdate(FLayer& Layer, uint64_t LinesVersion)
+{
+	if (!DisplayLines || Layer.Job || (Layer.LinesVersion == LinesVersion && Layer.BinsVersion == BinsVersion)) return false;
+	Layer.LinesVersion = LinesVersion;
+	Layer.BinsVersion = BinsVersion;
+	return true;
+}
+
+void FDensityMap::LaunchJob(FLayer& Layer, std::function<std::vector<uint64_t>()> GetJobLines, const std::function<void()>& OnDone)
+{
+	std::shared_ptr<FJob> Job = std::make_shared<FJob>();
+	std::shared_ptr<const FDisplayLines> JobDisplayLines = DisplayLines;
+	const int JobNumBins = NumBins;
+	Layer.Job = Job;
+	Jobs::Launch([Job, JobDisplayLines, GetJobLines, JobNumBins, OnDone]()
+	{
+		ULV_PROFILE_SCOPE("FDensityMap bin layer");
+		const std::vector<uint64_t> Lines = GetJobLines();
+		Job->Bins.assign(size_t(JobNumBins), 0);
+		const uint64_t NumRows = JobDisplayLines->Num();
+		for (uint64_t LineIdx : Lines)
+		{
+			if (!JobDisplayLines->Contains(LineIdx)) continue;
+			++Job->Bins[size_t(JobDisplayLines->FindRow(LineIdx) * JobNumBins / NumRows)];
+		}
+		Job->bDone = true;
+		if (OnDone) OnDone();
+	});
+}
+
+void FDensityMap::Poll()
+{
+	for (FLayer& Layer : Layers)
+	{
+		if (!Layer.Job || !Layer.Job->bDone) continue;
+		Layer.Bins = std::move(Layer.Job->Bins);
+		Layer.MaxBin = Layer.Bins.empty() ? 0 : *std::max_element(Layer.Bins.begin(), Layer.Bins.end());
+		Layer.Job.reset();
+	}
+}
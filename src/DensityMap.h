@@ -0,0 +1,80 @@
+#pragma once
+
+#include "DisplayLines.h"
+#include "GlobalSearch.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+enum class EDensityLayer : int
+{
+	Errors = 0,
+	Warnings,
+	SearchHits,
+	Bookmarks,
+	MAX
+};
+
+extern const char* EDensityLayerStrings[(int)EDensityLayer::MAX + 1];
+
+/**
+ * Where the errors, warnings, search hits and bookmarks of a display set fall, counted into as many bins as the
+ * minimap beside the text is pixels high. A layer is binned on a worker against the display lines it shares with the file
+ * whenever its lines, the display lines or the number of bins change, and its old bins are drawn until the new ones are done.
+ * Binning costs O(m log n) for m marked lines however many lines are displayed.
+ */
+class FDensityMap
+{
+public:
+	/** Takes the display lines if they or the number of bins changed, so every layer is binned again */
+	void SetDisplayLines(std::shared_ptr<const FDisplayLines> DisplayLines, uint64_t DisplayLinesVersion, int NumBins);
+
+	/**
+	 * Starts binning a layer if its lines or the display lines changed since it was last binned and it is not being binned already.
+	 * LinesVersion changes whenever the lines do, and GetLines is only called to get them, sorted, when they are binned.
+	 * OnDone is called from the worker.
+	 */
+	void UpdateLayer(EDensityLayer Layer, uint64_t LinesVersion, const std::function<std::vector<uint64_t>()>& GetLines, const std::function<void()>& OnDone);
+
+	/** UpdateLayer for the search hits layer, the hits GetHits returns are read on the worker rather than copied first */
+	void UpdateSearchHits(uint64_t HitsVersion, const std::function<FGlobalSearch::FFileHits()>& GetHits, const std::function<void()>& OnDone);
+
+	/** Takes the bins of the layers that finished binning */
+	void Poll();
+
+	/** Marked lines in each bin, empty until the layer is first binned. Bins split the display rows evenly. */
+	const std::vector<uint32_t>& GetBins(EDensityLayer Layer) const { return Layers[(int)Layer].Bins; }
+	uint32_t GetMaxBin(EDensityLayer Layer) const { return Layers[(int)Layer].MaxBin; }
+
+private:
+	struct FJob
+	{
+		std::vector<uint32_t> Bins;
+		std::atomic<bool> bDone{ false };
+	};
+
+	struct FLayer
+	{
+		std::vector<uint32_t> Bins;
+		uint32_t MaxBin = 0;
+		// What the bins are being or were last counted from
+		uint64_t LinesVersion = UINT64_MAX;
+		uint64_t BinsVersion = UINT64_MAX;
+		std::shared_ptr<FJob> Job;
+	};
+
+	/** True if the layer should be binned again, in which case it is marked as binned from the lines and display lines now */
+	bool StartUpdate(FLayer& Layer, uint64_t LinesVersion);
+	/** Bins the sorted lines that GetJobLines returns on a worker */
+	void LaunchJob(FLayer& Layer, std::function<std::vector<uint64_t>()> GetJobLines, const std::function<void()>& OnDone);
+
+	FLayer Layers[(int)EDensityLayer::MAX];
+	std::shared_ptr<const FDisplayLines> DisplayLines;
+	// Display lines version and number of bins of the display lines taken, bumped whenever either changes
+	uint64_t DisplayLinesVersion = UINT64_MAX;
+	int NumBins = 0;
+	uint64_t BinsVersion = 0;
+};
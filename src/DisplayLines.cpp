@@ -0,0 +1,315 @@
+#include "DisplayLines.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+static int PopCount(uint64_t Value) { return int(__popcnt64(Value)); }
+static int CountTrailingZeros(uint64_t Value) { unsigned long Idx; _BitScanForward64(&Idx, Value); return int(Idx); }
+#else
+static int PopCount(uint64_t Value) { return __builtin_popcountll(Value); }
+static int CountTrailingZeros(uint64_t Value) { return __builtin_ctzll(Value); }
+#endif
+
+void FDisplayLines::Reset()
+{
+	Containers.clear();
+	PendingValues.clear();
+	PendingKey = 0;
+	NumRows = 0;
+}
+
+void FDisplayLines::Finish()
+{
+	if (!PendingValues.empty()) FlushPending();
+	std::vector<uint16_t>().swap(PendingValues);
+	Containers.shrink_to_fit();
+}
+
+void FDisplayLines::FlushPending()
+{
+	const size_t NumValues = PendingValues.size();
+	size_t NumRuns = 1;
+	for (size_t ValueIdx = 1; ValueIdx < NumValues; ++ValueIdx)
+	{
+		NumRuns += PendingValues[ValueIdx] != PendingValues[ValueIdx - 1] + 1;
+	}
+
+	FContainer Container;
+	Container.Key = PendingKey;
+	Container.FirstRow = NumRows;
+	Container.NumRows = uint32_t(NumValues);
+
+	const size_t ArrayBytes = NumValues * sizeof(uint16_t);
+	const size_t RunsBytes = NumRuns * 3 * sizeof(uint16_t);
+	const size_t BitmapBytes = NumBitmapWords * sizeof(uint64_t);
+	if (RunsBytes <= ArrayBytes && RunsBytes <= BitmapBytes)
+	{
+		Container.Type = EContainerType::Runs;
+		Container.Values.reserve(NumRuns * 3);
+		size_t RunStartIdx = 0;
+		for (size_t ValueIdx = 1; ValueIdx <= NumValues; ++ValueIdx)
+		{
+			if (ValueIdx == NumValues || PendingValues[ValueIdx] != PendingValues[ValueIdx - 1] + 1)
+			{
+				Container.Values.push_back(PendingValues[RunStartIdx]);
+				Container.Values.push_back(uint16_t(ValueIdx - RunStartIdx - 1));
+				Container.Values.push_back(uint16_t(RunStartIdx));
+				RunStartIdx = ValueIdx;
+			}
+		}
+	}
+	else if (ArrayBytes <= BitmapBytes)
+	{
+		Container.Type = EContainerType::Array;
+		Container.Values = PendingValues;
+	}
+	else
+	{
+		Container.Type = EContainerType::Bitmap;
+		Container.Bits.assign(NumBitmapWords, 0);
+		for (uint16_t Value : PendingValues)
+		{
+			Container.Bits[Value >> 6] |= 1ull << (Value & 63);
+		}
+		uint32_t RowsBefore = 0;
+		for (int WordIdx = 0; WordIdx < NumBitmapWords; ++WordIdx)
+		{
+			if (WordIdx % WordsPerBitmapRank == 0) Container.Values.push_back(uint16_t(RowsBefore));
+			RowsBefore += PopCount(Container.Bits[WordIdx]);
+		}
+	}
+
+	NumRows += NumValues;
+	Containers.emplace_back(std::move(Container));
+	PendingValues.clear();
+}
+
+uint32_t FDisplayLines::SelectInContainer(const FContainer& Container, uint32_t LocalRow) const
+{
+	switch (Container.Type)
+	{
+	case EContainerType::Array:
+		return Container.Values[LocalRow];
+	case EContainerType::Runs:
+	{
+		// Last run that starts at or before the row
+		size_t Low = 0, High = Container.Values.size() / 3;
+		while (High - Low > 1)
+		{
+			const size_t Mid = (Low + High) / 2;
+			if (Container.Values[Mid * 3 + 2] <= LocalRow) Low = Mid;
+			else High = Mid;
+		}
+		return Container.Values[Low * 3] + (LocalRow - Container.Values[Low * 3 + 2]);
+	}
+	case EContainerType::Bitmap:
+	default:
+	{
+		const size_t RankIdx = std::upper_bound(Container.Values.begin(), Container.Values.end(), LocalRow) - Container.Values.begin() - 1;
+		uint32_t Remaining = LocalRow - Container.Values[RankIdx];
+		for (size_t WordIdx = RankIdx * WordsPerBitmapRank; ; ++WordIdx)
+		{
+			uint64_t Word = Container.Bits[WordIdx];
+			const uint32_t NumBits = PopCount(Word);
+			if (Remaining < NumBits)
+			{
+				while (Remaining--) Word &= Word - 1;
+				return uint32_t(WordIdx * 64 + CountTrailingZeros(Word));
+			}
+			Remaining -= NumBits;
+		}
+	}
+	}
+}
+
+uint32_t FDisplayLines::RankInContainer(const FContainer& Container, uint32_t Low) const
+{
+	switch (Container.Type)
+	{
+	case EContainerType::Array:
+		return uint32_t(std::lower_bound(Container.Values.begin(), Container.Values.end(), Low) - Container.Values.begin());
+	case EContainerType::Runs:
+	{
+		uint32_t Rank = 0;
+		for (size_t RunIdx = 0; RunIdx < Container.Values.size(); RunIdx += 3)
+		{
+			const uint32_t Start = Container.Values[RunIdx];
+			const uint32_t Last = Start + Container.Values[RunIdx + 1];
+			if (Low <= Start) break;
+			Rank = Container.Values[RunIdx + 2] + std::min(Low, Last + 1) - Start;
+			if (Low <= Last) break;
+		}
+		return Rank;
+	}
+	case EContainerType::Bitmap:
+	default:
+	{
+		const uint32_t WordIdx = Low >> 6;
+		const uint32_t RankIdx = WordIdx / WordsPerBitmapRank;
+		uint32_t Rank = Container.Values[RankIdx];
+		for (uint32_t Idx = RankIdx * WordsPerBitmapRank; Idx < WordIdx; ++Idx)
+		{
+			Rank += PopCount(Container.Bits[Idx]);
+		}
+		return Rank + PopCount(Container.Bits[WordIdx] & ((1ull << (Low & 63)) - 1));
+	}
+	}
+}
+
+uint64_t FDisplayLines::operator[](uint64_t Row) const
+{
+	auto It = std::upper_bound(Containers.begin(), Containers.end(), Row, [](uint64_t Value, const FContainer& Container) { return Value < Container.FirstRow; });
+	const FContainer& Container = *(It - 1);
+	return (Container.Key << 16) | SelectInContainer(Container, uint32_t(Row - Container.FirstRow));
+}
+
+uint64_t FDisplayLines::FindRow(uint64_t LineIdx) const
+{
+	const uint64_t Key = LineIdx >> 16;
+	auto It = std::lower_bound(Containers.begin(), Containers.end(), Key, [](const FContainer& Container, uint64_t Value) { return Container.Key < Value; });
+	if (It == Containers.end()) return NumRows;
+	if (It->Key > Key) return It->FirstRow;
+	return It->FirstRow + RankInContainer(*It, uint32_t(LineIdx & 0xFFFF));
+}
+
+bool FDisplayLines::Contains(uint64_t LineIdx) const
+{
+	const uint64_t Key = LineIdx >> 16;
+	auto It = std::lower_bound(Containers.begin(), Containers.end(), Key, [](const FContainer& Container, uint64_t Value) { return Container.Key < Value; });
+	if (It == Containers.end() || It->Key != Key) return false;
+	const uint16_t Low = uint16_t(LineIdx);
+	switch (It->Type)
+	{
+	case EContainerType::Array:
+		return std::binary_search(It->Values.begin(), It->Values.end(), Low);
+	case EContainerType::Runs:
+		for (size_t RunIdx = 0; RunIdx < It->Values.size() && It->Values[RunIdx] <= Low; RunIdx += 3)
+		{
+			if (Low - It->Values[RunIdx] <= It->Values[RunIdx + 1]) return true;
+		}
+		return false;
+	case EContainerType::Bitmap:
+	default:
+		return (It->Bits[Low >> 6] >> (Low & 63)) & 1;
+	}
+}
+
+void FDisplayLines::GetContainerLines(size_t ContainerIdx, std::vector<uint64_t>& OutLines) const
+{
+	const FContainer& Container = Containers[ContainerIdx];
+	const uint64_t KeyBits = Container.Key << 16;
+	switch (Container.Type)
+	{
+	case EContainerType::Array:
+		for (uint16_t Low : Container.Values)
+		{
+			OutLines.push_back(KeyBits | Low);
+		}
+		break;
+	case EContainerType::Runs:
+		for (size_t RunIdx = 0; RunIdx < Container.Values.size(); RunIdx += 3)
+		{
+			const uint64_t Start = KeyBits | Container.Values[RunIdx];
+			for (uint64_t LineIdx = Start; LineIdx <= Start + Container.Values[RunIdx + 1]; ++LineIdx)
+			{
+				OutLines.push_back(LineIdx);
+			}
+		}
+		break;
+	case EContainerType::Bitmap:
+	default:
+		for (int WordIdx = 0; WordIdx < NumBitmapWords; ++WordIdx)
+		{
+			for (uint64_t Word = Container.Bits[WordIdx]; Word; Word &= Word - 1)
+			{
+				OutLines.push_back(KeyBits | uint64_t(WordIdx * 64 + CountTrailingZeros(Word)));
+			}
+		}
+		break;
+	}
+}
+
+uint64_t FDisplayLines::GetAllocatedBytes() const
+{
+	uint64_t NumBytes = Containers.capacity() * sizeof(FContainer) + PendingValues.capacity() * sizeof(uint16_t);
+	for (const FContainer& Container : Containers)
+	{
+		NumBytes += Container.Values.capacity() * sizeof(uint16_t) + Container.Bits.capacity() * sizeof(uint64_t);
+	}
+	return NumBytes;
+}
+
+void FDisplayLines::Release()
+{
+	Reset();
+	std::vector<FContainer>().swap(Containers);
+	std::vector<uint16_t>().swap(PendingValues);
+}
+
+void FDuplicateRuns::Reset()
+{
+	Runs.clear();
+	NumDisplayRows = NumRows = 0;
+}
+
+void FDuplicateRuns::AddRun(uint64_t FirstDisplayRow, uint64_t NumRunDisplayRows)
+{
+	FRun Run;
+	Run.FirstDisplayRow = FirstDisplayRow;
+	Run.NumDisplayRows = NumRunDisplayRows;
+	Runs.push_back(Run);
+}
+
+void FDuplicateRuns::Finish(uint64_t InNumDisplayRows)
+{
+	NumDisplayRows = InNumDisplayRows;
+	Runs.shrink_to_fit();
+	UpdateRows();
+}
+
+void FDuplicateRuns::SetRunExpanded(size_t RunIdx, bool bExpanded)
+{
+	Runs[RunIdx].bExpanded = bExpanded;
+	UpdateRows();
+}
+
+void FDuplicateRuns::UpdateRows()
+{
+	uint64_t NumHiddenRows = 0;
+	for (FRun& Run : Runs)
+	{
+		Run.FirstRow = Run.FirstDisplayRow - NumHiddenRows;
+		NumHiddenRows += Run.bExpanded ? 0 : Run.NumDisplayRows - 1;
+	}
+	NumRows = NumDisplayRows - NumHiddenRows;
+}
+
+uint64_t FDuplicateRuns::GetDisplayRow(uint64_t Row, int64_t& OutRunIdx) const
+{
+	OutRunIdx = -1;
+	auto RunIt = std::upper_bound(Runs.begin(), Runs.end(), Row, [](uint64_t Value, const FRun& Run) { return Value < Run.FirstRow; });
+	if (RunIt == Runs.begin()) return Row;
+	const FRun& Run = *--RunIt;
+	const uint64_t RowInRun = Row - Run.FirstRow;
+	if (RowInRun == 0)
+	{
+		OutRunIdx = int64_t(RunIt - Runs.begin());
+		return Run.FirstDisplayRow;
+	}
+	if (Run.bExpanded && RowInRun < Run.NumDisplayRows) return Run.FirstDisplayRow + RowInRun;
+	// Past the end of the run, the rest of it is hidden unless it is expanded
+	return Run.FirstDisplayRow + RowInRun + (Run.bExpanded ? 0 : Run.NumDisplayRows - 1);
+}
+
+uint64_t FDuplicateRuns::FindRow(uint64_t DisplayRow) const
+{
+	auto RunIt = std::upper_bound(Runs.begin(), Runs.end(), DisplayRow, [](uint64_t Value, const FRun& Run) { return Value < Run.FirstDisplayRow; });
+	if (RunIt == Runs.begin()) return DisplayRow;
+	const FRun& Run = *--RunIt;
+	if (DisplayRow - Run.FirstDisplayRow < Run.NumDisplayRows)
+	{
+		return Run.bExpanded ? Run.FirstRow + (DisplayRow - Run.FirstDisplayRow) : Run.FirstRow;
+	}
+	return DisplayRow - (Run.FirstDisplayRow - Run.FirstRow) - (Run.bExpanded ? 0 : Run.NumDisplayRows - 1);
+}
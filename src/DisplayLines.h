@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Sorted set of the line indices that pass the filters, with lookup by display row.
+ * Lines are grouped by their upper bits into containers of 65536 lines, and each container
+ * stores its lower 16 bits as whichever is smallest of a sorted array, a list of runs or a bitmap.
+ * An unfiltered or lightly filtered view is a handful of runs.
+ */
+class FDisplayLines
+{
+public:
+	void Reset();
+
+	/** Lines must be added in increasing order, call Finish once all of them are added */
+	void Add(uint64_t LineIdx)
+	{
+		const uint64_t Key = LineIdx >> 16;
+		if (Key != PendingKey && !PendingValues.empty()) FlushPending();
+		PendingKey = Key;
+		PendingValues.push_back(uint16_t(LineIdx));
+	}
+	void Finish();
+
+	uint64_t Num() const { return NumRows; }
+	bool IsEmpty() const { return NumRows == 0; }
+
+	/** Line shown on a display row, O(log n) */
+	uint64_t operator[](uint64_t Row) const;
+
+	/** First row that shows LineIdx or a later line, Num() if there is none */
+	uint64_t FindRow(uint64_t LineIdx) const;
+
+	/** Whether a line passed the filters, O(log n) */
+	bool Contains(uint64_t LineIdx) const;
+
+	/** Lines are kept in containers of up to 65536 rows, which can be read independently of each other */
+	size_t NumContainers() const { return Containers.size(); }
+	uint64_t GetContainerFirstRow(size_t ContainerIdx) const { return Containers[ContainerIdx].FirstRow; }
+
+	/** Appends the lines of a container in order, O(rows) rather than O(rows log n) for looking each one up */
+	void GetContainerLines(size_t ContainerIdx, std::vector<uint64_t>& OutLines) const;
+
+	uint64_t GetAllocatedBytes() const;
+	void Release();
+
+private:
+	enum class EContainerType : uint8_t
+	{
+		Array,
+		Runs,
+		Bitmap
+	};
+
+	struct FContainer
+	{
+		uint64_t Key = 0;
+		uint64_t FirstRow = 0;
+		uint32_t NumRows = 0;
+		EContainerType Type = EContainerType::Array;
+		// Array: the sorted lower bits. Runs: (start, length - 1, rows before) triples. Bitmap: rows before every 64 words.
+		std::vector<uint16_t> Values;
+		std::vector<uint64_t> Bits;
+	};
+
+	static const int NumBitmapWords = 65536 / 64;
+	static const int WordsPerBitmapRank = 64;
+
+	void FlushPending();
+	uint32_t SelectInContainer(const FContainer& Container, uint32_t LocalRow) const;
+	uint32_t RankInContainer(const FContainer& Container, uint32_t Low) const;
+
+	std::vector<FContainer> Containers;
+	std::vector<uint16_t> PendingValues;
+	uint64_t PendingKey = 0;
+	uint64_t NumRows = 0;
+};
+
+/**
+ * Runs of consecutive display rows whose lines have the same message, and the rows they leave when each run is
+ * collapsed into the row of its first line. Runs are expanded back into their rows one at a time.
+ */
+class FDuplicateRuns
+{
+public:
+	void Reset();
+
+	/** Runs of more than one row must be added in order, call Finish with the number of display rows once all of them are added */
+	void AddRun(uint64_t FirstDisplayRow, uint64_t NumDisplayRows);
+	void Finish(uint64_t NumDisplayRows);
+
+	/** Rows left with the collapsed runs hidden */
+	uint64_t Num() const { return NumRows; }
+	size_t NumRuns() const { return Runs.size(); }
+
+	/** Display row shown on a row, and the run it starts or -1. O(log r) for r runs. */
+	uint64_t GetDisplayRow(uint64_t Row, int64_t& OutRunIdx) const;
+	uint64_t GetDisplayRow(uint64_t Row) const { int64_t RunIdx; return GetDisplayRow(Row, RunIdx); }
+
+	/** Row that shows a display row, the first row of its run if the run is collapsed */
+	uint64_t FindRow(uint64_t DisplayRow) const;
+
+	uint64_t GetRunFirstDisplayRow(size_t RunIdx) const { return Runs[RunIdx].FirstDisplayRow; }
+	uint64_t GetRunNumDisplayRows(size_t RunIdx) const { return Runs[RunIdx].NumDisplayRows; }
+	bool IsRunExpanded(size_t RunIdx) const { return Runs[RunIdx].bExpanded; }
+	void SetRunExpanded(size_t RunIdx, bool bExpanded);
+
+	uint64_t GetAllocatedBytes() const { return Runs.capacity() * sizeof(FRun); }
+
+private:
+	struct FRun
+	{
+		uint64_t FirstDisplayRow = 0;
+		uint64_t NumDisplayRows = 0;
+		// Row of the first line of the run
+		uint64_t FirstRow = 0;
+		bool bExpanded = false;
+	};
+
+	void UpdateRows();
+
+	std::vector<FRun> Runs;
+	uint64_t NumDisplayRows = 0;
+	uint64_t NumRows = 0;
+};
@@ -1,26 +1,73 @@
 #include "FileUtils.h"
+#include "Profiler.h"
 
 #include <fstream>
+#include <memory>
+#include <sys/stat.h>
+#include <sys/types.h>
 
 namespace FileUtils
 {
 
-std::vector<std::string> ReadFileContents(const std::string& FilePath)
+FLineStore ReadFileContents(const std::string& FilePath, ELineStorage Storage)
 {
-    std::vector<std::string> FileContents;
-    
-    std::ifstream FileStream (FilePath);
+    ULV_PROFILE_SCOPE("FileUtils::ReadFileContents");
+    FLineStore FileContents(Storage, FilePath);
+    const uint64_t NumBytesRead = AppendFileContents(FileContents, FilePath);
+    FileContents.Finish();
+    if (FileContents.IsOutOfBodyIds())
+    {
+        // Too many distinct lines to deduplicate, paged storage keeps them as they are in the file
+        return ReadFileContents(FilePath, ELineStorage::Paged);
+    }
+    ULV_PROFILE_WORK(FileContents.Num(), NumBytesRead);
+	return FileContents;
+}
+
+uint64_t AppendFileContents(FLineStore& Lines, const std::string& FilePath, uint64_t StartOffset)
+{
+    ULV_PROFILE_JOB("Reading " + FilePath);
+    uint64_t NumBytesRead = 0;
+
+    std::ifstream FileStream (FilePath, std::ios::binary);
     if (FileStream.is_open())
     {
-        std::string Line;
-        while (std::getline(FileStream, Line))
+        FileStream.seekg(0, std::ios::end);
+        const uint64_t FileSize = FileStream.tellg();
+        FileStream.seekg(StartOffset, std::ios::beg);
+
+        const size_t ChunkSize = 1 << 20;
+        std::unique_ptr<char[]> Chunk(new char[ChunkSize]);
+        while (FileStream)
         {
-            FileContents.emplace_back(std::move(Line));
+            FileStream.read(Chunk.get(), ChunkSize);
+            const size_t NumChunkBytes = size_t(FileStream.gcount());
+            if (NumChunkBytes == 0) break;
+            Lines.AppendText(Chunk.get(), NumChunkBytes);
+            NumBytesRead += NumChunkBytes;
+            if (Lines.IsOutOfBodyIds()) break;
+            ULV_PROFILE_JOB_PROGRESS(StartOffset + NumBytesRead, FileSize);
         }
         FileStream.close();
     }
-    
-	return FileContents;
+    return NumBytesRead;
+}
+
+uint64_t GetFileSize(const std::string& FilePath)
+{
+    std::ifstream FileStream (FilePath, std::ios::binary | std::ios::ate);
+    return FileStream.is_open() ? uint64_t(FileStream.tellg()) : 0;
+}
+
+uint64_t GetFileModifiedTime(const std::string& FilePath)
+{
+#ifdef _WIN32
+    struct _stat64 FileStat;
+    return _stat64(FilePath.c_str(), &FileStat) == 0 ? uint64_t(FileStat.st_mtime) : 0;
+#else
+    struct stat FileStat;
+    return stat(FilePath.c_str(), &FileStat) == 0 ? uint64_t(FileStat.st_mtime) : 0;
+#endif
 }
 
 }
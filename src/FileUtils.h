@@ -1,9 +1,20 @@
 #pragma once
 
+#include "LineStore.h"
+
+#include <cstdint>
 #include <string>
-#include <vector>
 
 namespace FileUtils
 {
-	std::vector<std::string> ReadFileContents(const std::string& FilePath);
-}
\ No newline at end of file
+	FLineStore ReadFileContents(const std::string& FilePath, ELineStorage Storage = ELineStorage::Memory);
+
+	/** Appends the text of a file from StartOffset on, without finishing the store. Returns the number of bytes read. */
+	uint64_t AppendFileContents(FLineStore& Lines, const std::string& FilePath, uint64_t StartOffset = 0);
+
+	/** Returns 0 if the file does not exist */
+	uint64_t GetFileSize(const std::string& FilePath);
+
+	/** Last modification time in seconds, 0 if the file does not exist */
+	uint64_t GetFileModifiedTime(const std::string& FilePath);
+}
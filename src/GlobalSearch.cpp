@@ -0,0 +1,227 @@
+#include "GlobalSearch.h"
+#include "Jobs.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Lines per chunk of work, small enough for a few files to spread over every worker
+static const uint64_t LinesPerChunk = uint64_t(FLineStore::LinesPerBlock) * 16;
+
+struct FFoldCase
+{
+	unsigned char Lower[256];
+
+	FFoldCase()
+	{
+		for (int Char = 0; Char < 256; ++Char)
+		{
+			Lower[Char] = (unsigned char)tolower(Char);
+		}
+	}
+};
+static const FFoldCase FoldCase;
+
+/** Characters at the start of a regex that every match begins with, empty if the regex has alternatives */
+static std::string GetRegexLiteralPrefix(const std::string& Pattern)
+{
+	if (Pattern.find('|') != std::string::npos) return std::string();
+	const size_t PrefixSize = Pattern.find_first_of("\\^$.?*+()[]{}");
+	if (PrefixSize == std::string::npos) return Pattern;
+	// A quantifier applies to the character before it
+	const bool bLastOptional = Pattern[PrefixSize] == '?' || Pattern[PrefixSize] == '*' || Pattern[PrefixSize] == '{';
+	return Pattern.substr(0, bLastOptional && PrefixSize > 0 ? PrefixSize - 1 : PrefixSize);
+}
+
+bool FSearchMatcher::Init(const FSearchQuery& InQuery)
+{
+	Query = InQuery;
+	Token = Query.bRegex ? GetRegexLiteralPrefix(Query.Text) : Query.Text;
+	if (!Query.bCaseMatch)
+	{
+		std::transform(Token.begin(), Token.end(), Token.begin(), [](char Char) { return char(FoldCase.Lower[(unsigned char)Char]); });
+	}
+	if (Query.bRegex)
+	{
+		try
+		{
+			Regex = std::regex(Query.Text, Query.bCaseMatch ? std::regex::ECMAScript : std::regex::ECMAScript | std::regex::icase);
+		}
+		catch (const std::regex_error&)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FSearchMatcher::Matches(FStringView Line) const
+{
+	if (Query.Text.empty()) return false;
+	if (!ContainsToken(Line)) return false;
+	return !Query.bRegex || std::regex_search(Line.begin(), Line.end(), Regex);
+}
+
+bool FSearchMatcher::ContainsToken(FStringView Line) const
+{
+	if (Token.empty()) return true;
+	if (Query.bCaseMatch) return Line.Find(Token) != FStringView::npos;
+
+	// Compare folded, checking the first and last characters before the rest
+	const size_t TokenSize = Token.size();
+	if (TokenSize > Line.Size) return false;
+	const unsigned char* Lower = FoldCase.Lower;
+	const unsigned char First = (unsigned char)Token[0];
+	const unsigned char Last = (unsigned char)Token[TokenSize - 1];
+	const unsigned char* LineChars = (const unsigned char*)Line.Data;
+	for (size_t Pos = 0, LastPos = Line.Size - TokenSize; Pos <= LastPos; ++Pos)
+	{
+		if (Lower[LineChars[Pos]] != First || Lower[LineChars[Pos + TokenSize - 1]] != Last) continue;
+		size_t CharIdx = 1;
+		while (CharIdx < TokenSize && Lower[LineChars[Pos + CharIdx]] == (unsigned char)Token[CharIdx]) ++CharIdx;
+		if (CharIdx >= TokenSize - 1) return true;
+	}
+	return false;
+}
+
+struct FGlobalSearch::FState
+{
+	std::vector<const FLineStore*> Files;
+	FSearchMatcher Matcher;
+	std::function<void()> OnProgress;
+	std::vector<std::unique_ptr<FChunk>> Chunks;
+	std::atomic<size_t> NextChunk{ 0 };
+	std::atomic<size_t> NumDoneChunks{ 0 };
+	std::atomic<bool> bCancelled{ false };
+	std::chrono::steady_clock::time_point StartTime;
+	std::atomic<double> SearchMs{ 0.0 };
+
+	std::mutex Mutex;
+	std::condition_variable LanesDone;
+	int NumLanes = 0;
+
+	/** Searches one chunk, then queues itself behind whatever else was launched meanwhile so prefetches are not held up */
+	static void RunLane(const std::shared_ptr<FState>& State)
+	{
+		const size_t ChunkIdx = State->bCancelled ? State->Chunks.size() : State->NextChunk.fetch_add(1);
+		if (ChunkIdx >= State->Chunks.size())
+		{
+			std::lock_guard<std::mutex> Lock(State->Mutex);
+			if (--State->NumLanes == 0) State->LanesDone.notify_all();
+			return;
+		}
+
+		State->SearchChunk(*State->Chunks[ChunkIdx]);
+		if (State->NumDoneChunks.fetch_add(1) + 1 == State->Chunks.size())
+		{
+			State->SearchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - State->StartTime).count();
+		}
+		if (State->OnProgress) State->OnProgress();
+		Jobs::Launch([State]() { RunLane(State); });
+	}
+
+	void SearchChunk(FChunk& Chunk)
+	{
+		ULV_PROFILE_SCOPE("FGlobalSearch chunk");
+		const FLineStore& Lines = *Files[Chunk.FileIdx];
+		for (uint64_t BlockLine = Chunk.FirstLine; BlockLine < Chunk.EndLine && !bCancelled; BlockLine += FLineStore::LinesPerBlock)
+		{
+			Lines.ForEachLine(BlockLine, std::min(Chunk.EndLine, BlockLine + FLineStore::LinesPerBlock), [&](uint64_t LineIdx, FStringView Line)
+			{
+				if (Matcher.Matches(Line)) Chunk.Hits.push_back(LineIdx);
+			});
+		}
+		Chunk.bDone = true;
+	}
+};
+
+bool FGlobalSearch::Start(const std::vector<const FLineStore*>& Files, const FSearchQuery& InQuery, std::function<void()> OnProgress)
+{
+	Cancel();
+	State.reset();
+	FileFirstChunks.clear();
+	Query = InQuery;
+
+	std::shared_ptr<FState> NewState = std::make_shared<FState>();
+	if (!NewState->Matcher.Init(Query)) return false;
+	NewState->Files = Files;
+	NewState->OnProgress = std::move(OnProgress);
+	for (size_t FileIdx = 0; FileIdx < Files.size(); ++FileIdx)
+	{
+		FileFirstChunks.push_back(NewState->Chunks.size());
+		for (uint64_t FirstLine = 0; FirstLine < Files[FileIdx]->Num(); FirstLine += LinesPerChunk)
+		{
+			std::unique_ptr<FChunk> Chunk(new FChunk());
+			Chunk->FileIdx = FileIdx;
+			Chunk->FirstLine = FirstLine;
+			Chunk->EndLine = std::min(Files[FileIdx]->Num(), FirstLine + LinesPerChunk);
+			NewState->Chunks.push_back(std::move(Chunk));
+		}
+	}
+	FileFirstChunks.push_back(NewState->Chunks.size());
+
+	NewState->StartTime = std::chrono::steady_clock::now();
+	NewState->NumLanes = int(std::min<size_t>(Jobs::GetNumWorkers(), NewState->Chunks.size()));
+	State = NewState;
+	for (int LaneIdx = 0, NumLanes = NewState->NumLanes; LaneIdx < NumLanes; ++LaneIdx)
+	{
+		Jobs::Launch([NewState]() { FState::RunLane(NewState); });
+	}
+	return true;
+}
+
+void FGlobalSearch::Cancel()
+{
+	if (!State) return;
+	State->bCancelled = true;
+	Wait();
+}
+
+void FGlobalSearch::Wait()
+{
+	if (!State) return;
+	std::unique_lock<std::mutex> Lock(State->Mutex);
+	State->LanesDone.wait(Lock, [this]() { return State->NumLanes == 0; });
+}
+
+bool FGlobalSearch::IsRunning() const
+{
+	return State && !State->bCancelled && State->NumDoneChunks < State->Chunks.size();
+}
+
+float FGlobalSearch::GetProgress() const
+{
+	return !State || State->Chunks.empty() ? 1.0f : float(State->NumDoneChunks) / float(State->Chunks.size());
+}
+
+double FGlobalSearch::GetSearchMs() const
+{
+	return State ? State->SearchMs.load() : 0.0;
+}
+
+uint64_t FGlobalSearch::FFileHits::operator[](uint64_t HitIdx) const
+{
+	const size_t ChunkIdx = size_t(std::upper_bound(ChunkFirstHits.begin(), ChunkFirstHits.end(), HitIdx) - ChunkFirstHits.begin()) - 1;
+	return (*ChunkHits[ChunkIdx])[size_t(HitIdx - ChunkFirstHits[ChunkIdx])];
+}
+
+FGlobalSearch::FFileHits FGlobalSearch::GetFileHits(size_t FileIdx) const
+{
+	FFileHits FileHits;
+	if (!State || FileIdx >= NumFiles()) return FileHits;
+	FileHits.State = State;
+	uint64_t NumHits = 0;
+	for (size_t ChunkIdx = FileFirstChunks[FileIdx]; ChunkIdx < FileFirstChunks[FileIdx + 1]; ++ChunkIdx)
+	{
+		const FChunk& Chunk = *State->Chunks[ChunkIdx];
+		if (!Chunk.bDone || Chunk.Hits.empty()) continue;
+		FileHits.ChunkFirstHits.push_back(NumHits);
+		FileHits.ChunkHits.push_back(&Chunk.Hits);
+		NumHits += Chunk.Hits.size();
+	}
+	FileHits.ChunkFirstHits.push_back(NumHits);
+	return FileHits;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "LineStore.h"
+#include "StringView.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+struct FSearchQuery
+{
+	std::string Text;
+	bool bCaseMatch = false;
+	// Text is an ECMAScript regular expression rather than a token
+	bool bRegex = false;
+};
+
+/** Tests lines against a query, safe to share between threads */
+class FSearchMatcher
+{
+public:
+	/** Returns false if the query is an invalid regex */
+	bool Init(const FSearchQuery& Query);
+	bool Matches(FStringView Line) const;
+
+private:
+	bool ContainsToken(FStringView Line) const;
+
+	FSearchQuery Query;
+	// Text every match contains, with every letter folded to lower case when the case does not matter.
+	// For a regex this is its literal prefix, and lines without it are skipped without running the regex.
+	std::string Token;
+	std::regex Regex;
+};
+
+/**
+ * Search of every line of any number of files on the worker threads.
+ * The files are cut into chunks of whole blocks and the workers take the next chunk of any file,
+ * so many small files keep every worker as busy as one large file does. Hits stream in as chunks finish.
+ */
+class FGlobalSearch
+{
+public:
+	~FGlobalSearch() { Cancel(); }
+
+	/**
+	 * Cancels any search in progress and starts a new one, OnProgress is called from a worker whenever a chunk finishes.
+	 * The files must stay put until the search finishes or is cancelled. Returns false if the query is an invalid regex.
+	 */
+	bool Start(const std::vector<const FLineStore*>& Files, const FSearchQuery& Query, std::function<void()> OnProgress);
+
+	/** Stops the workers and waits until none of them are looking at the files, the hits so far are kept */
+	void Cancel();
+
+	/** Waits for the search to finish */
+	void Wait();
+
+	bool IsRunning() const;
+	/** Fraction of the chunks searched */
+	float GetProgress() const;
+	double GetSearchMs() const;
+	const FSearchQuery& GetQuery() const { return Query; }
+
+private:
+	struct FState;
+
+public:
+	/** Hits of one file from the chunks searched so far, in line order. Keeps them alive, so it can be read on a worker. */
+	class FFileHits
+	{
+	public:
+		uint64_t Num() const { return ChunkFirstHits.empty() ? 0 : ChunkFirstHits.back(); }
+		/** O(log c) for c chunks with hits */
+		uint64_t operator[](uint64_t HitIdx) const;
+
+	private:
+		friend class FGlobalSearch;
+		std::shared_ptr<const FState> State;
+		// Hits before each finished chunk and in total
+		std::vector<uint64_t> ChunkFirstHits;
+		std::vector<const std::vector<uint64_t>*> ChunkHits;
+	};
+
+	size_t NumFiles() const { return FileFirstChunks.empty() ? 0 : FileFirstChunks.size() - 1; }
+
+	/** Call once a frame rather than once a hit, O(c) for c chunks in the file */
+	FFileHits GetFileHits(size_t FileIdx) const;
+
+private:
+	struct FChunk
+	{
+		size_t FileIdx = 0;
+		uint64_t FirstLine = 0;
+		uint64_t EndLine = 0;
+		// Written by the one worker that searches the chunk, then only read once bDone is set
+		std::vector<uint64_t> Hits;
+		std::atomic<bool> bDone{ false };
+	};
+
+	FSearchQuery Query;
+	std::shared_ptr<FState> State;
+	// First chunk of each file and the total number of chunks
+	std::vector<size_t> FileFirstChunks;
+};
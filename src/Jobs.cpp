@@ -0,0 +1,150 @@
+#include "Jobs.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Jobs
+{
+
+class FWorkerPool
+{
+public:
+	FWorkerPool()
+	{
+		const int NumWorkers = std::max(1, int(std::thread::hardware_concurrency()));
+		for (int WorkerIdx = 0; WorkerIdx < NumWorkers; ++WorkerIdx)
+		{
+			Workers.emplace_back([this, WorkerIdx]() { WorkerMain(WorkerIdx); });
+		}
+	}
+
+	~FWorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			bStopping = true;
+		}
+		TaskAdded.notify_all();
+		for (std::thread& Worker : Workers)
+		{
+			Worker.join();
+		}
+	}
+
+	void Launch(std::function<void()>&& Task)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Tasks.emplace_back(std::move(Task));
+		}
+		TaskAdded.notify_one();
+	}
+
+	int GetNumWorkers() const { return int(Workers.size()); }
+
+private:
+	void WorkerMain(int WorkerIdx)
+	{
+#if ULV_WITH_PROFILER
+		Profiler::SetThreadName("Worker " + std::to_string(WorkerIdx));
+#endif
+		for (;;)
+		{
+			std::function<void()> Task;
+			{
+				std::unique_lock<std::mutex> Lock(Mutex);
+				TaskAdded.wait(Lock, [this]() { return bStopping || !Tasks.empty(); });
+				if (Tasks.empty()) return;
+				Task = std::move(Tasks.front());
+				Tasks.pop_front();
+			}
+			Task();
+		}
+	}
+
+	std::mutex Mutex;
+	std::condition_variable TaskAdded;
+	std::deque<std::function<void()>> Tasks;
+	std::vector<std::thread> Workers;
+	bool bStopping = false;
+};
+
+static FWorkerPool& GetPool()
+{
+	static FWorkerPool Pool;
+	return Pool;
+}
+
+void Launch(std::function<void()>&& Task)
+{
+	GetPool().Launch(std::move(Task));
+}
+
+void ParallelFor(uint64_t Num, uint64_t ChunkSize, const std::function<void(uint64_t, uint64_t)>& Func)
+{
+	struct FParallelFor
+	{
+		const std::function<void(uint64_t, uint64_t)>* Func = nullptr;
+		uint64_t Num = 0;
+		uint64_t ChunkSize = 0;
+		uint64_t NumChunks = 0;
+		std::atomic<uint64_t> NextChunk;
+		std::atomic<uint64_t> NumDoneChunks;
+		std::mutex Mutex;
+		std::condition_variable ChunksDone;
+
+		void RunChunks()
+		{
+			for (uint64_t Begin; (Begin = NextChunk.fetch_add(1) * ChunkSize) < Num; )
+			{
+				(*Func)(Begin, std::min(Num, Begin + ChunkSize));
+				if (NumDoneChunks.fetch_add(1) + 1 == NumChunks)
+				{
+					std::lock_guard<std::mutex> Lock(Mutex);
+					ChunksDone.notify_one();
+				}
+			}
+		}
+	};
+
+	ChunkSize = std::max<uint64_t>(ChunkSize, 1);
+	const uint64_t NumChunks = (Num + ChunkSize - 1) / ChunkSize;
+	if (NumChunks <= 1 || GetNumWorkers() <= 1)
+	{
+		if (Num > 0) Func(0, Num);
+		return;
+	}
+
+	// We only wait for the chunks to be done, not for the helpers to run. Helpers that only start once every chunk is taken
+	// return straight away, and ones still queued behind busy workers cannot hold us up, so a worker can call this too.
+	std::shared_ptr<FParallelFor> State = std::make_shared<FParallelFor>();
+	State->Func = &Func;
+	State->Num = Num;
+	State->ChunkSize = ChunkSize;
+	State->NumChunks = NumChunks;
+	State->NextChunk = 0;
+	State->NumDoneChunks = 0;
+	for (uint64_t HelperIdx = 0, NumHelpers = std::min<uint64_t>(GetNumWorkers(), NumChunks - 1); HelperIdx < NumHelpers; ++HelperIdx)
+	{
+		Launch([State]() { State->RunChunks(); });
+	}
+	State->RunChunks();
+
+	std::unique_lock<std::mutex> Lock(State->Mutex);
+	State->ChunksDone.wait(Lock, [&State]() { return State->NumDoneChunks == State->NumChunks; });
+}
+
+int GetNumWorkers()
+{
+	return GetPool().GetNumWorkers();
+}
+
+}
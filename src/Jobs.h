@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// Small pool of worker threads for background work such as prefetching text.
+
+namespace Jobs
+{
+	/** Runs the task on a worker thread. Tasks start in the order they are launched. */
+	void Launch(std::function<void()>&& Task);
+
+	/**
+	 * Calls Func(Begin, End) for consecutive chunks of [0, Num) on the workers and the calling thread,
+	 * and returns once every chunk is done. Chunks run in no particular order. Safe to call from a worker.
+	 */
+	void ParallelFor(uint64_t Num, uint64_t ChunkSize, const std::function<void(uint64_t, uint64_t)>& Func);
+
+	int GetNumWorkers();
+}
@@ -0,0 +1,664 @@
+#include "LineStore.h"
+#include "Jobs.h"
+#include "LineTimes.h"
+#include "Lz4.h"
+#include "Profiler.h"
+
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+const char* ELineStorageStrings[(int)ELineStorage::MAX + 1] =
+{
+	"Memory",
+	"Paged",
+	"Compressed",
+	"Deduplicated"
+};
+
+/** Parses a line prefix, only succeeds if formatting it again gives back exactly the same text */
+static bool ParsePrefix(const char* Line, size_t Size, int64_t& OutTimestampMs, int& OutFrame)
+{
+	if (!ParseLinePrefix(Line, Size, OutTimestampMs, OutFrame)) return false;
+
+	// Anything that would not come back the same, like the 31st of February, is left in the body
+	char Formatted[LinePrefixSize];
+	FormatLinePrefix(OutTimestampMs, OutFrame, Formatted);
+	return memcmp(Formatted, Line, LinePrefixSize) == 0;
+}
+
+/**
+ * Columns and message bodies of deduplicated storage, every distinct body is stored once.
+ * Shared with the page cache, which rebuilds the text of a block from them.
+ */
+class FLineBodies
+{
+public:
+	FLineBodies()
+	{
+		BodyEnds.push_back(0);
+		HashTable.resize(1024);
+	}
+
+	/** Adds a line of the current block, including its '\n' */
+	void AddLine(const char* Line, size_t Size)
+	{
+		if (Blocks.empty() || Blocks.back().bFinished)
+		{
+			Blocks.emplace_back();
+			Blocks.back().BodyIds.reserve(FLineStore::LinesPerBlock);
+			Blocks.back().TimestampDeltas.reserve(FLineStore::LinesPerBlock);
+			Blocks.back().Frames.reserve(FLineStore::LinesPerBlock);
+		}
+		FColumnBlock& Block = Blocks.back();
+
+		int64_t TimestampMs = 0;
+		int Frame = 0;
+		bool bHasPrefix = ParsePrefix(Line, Size, TimestampMs, Frame);
+		if (bHasPrefix)
+		{
+			if (!Block.bHasBaseTimestamp)
+			{
+				Block.BaseTimestampMs = TimestampMs;
+				Block.bHasBaseTimestamp = true;
+			}
+			// Timestamps are stored relative to the block, a line too far from the rest keeps its prefix as text
+			bHasPrefix = TimestampMs - Block.BaseTimestampMs >= INT32_MIN && TimestampMs - Block.BaseTimestampMs <= INT32_MAX;
+		}
+
+		const size_t BodyStart = bHasPrefix ? LinePrefixSize : 0;
+		const uint32_t BodyId = AddBody(Line + BodyStart, Size - 1 - BodyStart);
+		Block.BodyIds.push_back(BodyId | (bHasPrefix ? FLineStore::BodyIdPrefixBit : 0));
+		Block.TimestampDeltas.push_back(bHasPrefix ? int32_t(TimestampMs - Block.BaseTimestampMs) : 0);
+		Block.Frames.push_back(uint16_t(Frame));
+	}
+
+	void FinishBlock()
+	{
+		if (Blocks.empty() || Blocks.back().bFinished) Blocks.emplace_back();
+		FColumnBlock& Block = Blocks.back();
+		Block.BodyIds.shrink_to_fit();
+		Block.TimestampDeltas.shrink_to_fit();
+		Block.Frames.shrink_to_fit();
+		Block.bFinished = true;
+	}
+
+	/** Frees the lookup used to find duplicates, no more lines can be added */
+	void Finish()
+	{
+		std::vector<uint64_t>().swap(HashTable);
+		BodyText.shrink_to_fit();
+		BodyEnds.shrink_to_fit();
+		Blocks.shrink_to_fit();
+	}
+
+	void BuildBlockText(size_t BlockIdx, std::vector<char>& OutText) const
+	{
+		const FColumnBlock& Block = Blocks[BlockIdx];
+		for (size_t LineIdx = 0; LineIdx < Block.BodyIds.size(); ++LineIdx)
+		{
+			const uint32_t BodyId = Block.BodyIds[LineIdx];
+			if (BodyId & FLineStore::BodyIdPrefixBit)
+			{
+				const size_t PrefixStart = OutText.size();
+				OutText.resize(PrefixStart + LinePrefixSize);
+				FormatLinePrefix(Block.BaseTimestampMs + Block.TimestampDeltas[LineIdx], Block.Frames[LineIdx], OutText.data() + PrefixStart);
+			}
+			const uint32_t Id = BodyId & ~FLineStore::BodyIdPrefixBit;
+			OutText.insert(OutText.end(), BodyText.data() + BodyEnds[Id], BodyText.data() + BodyEnds[Id + 1]);
+			OutText.push_back('\n');
+		}
+	}
+
+	uint32_t NumBodies() const { return uint32_t(BodyEnds.size() - 1); }
+
+	FStringView GetBody(uint32_t BodyId) const
+	{
+		FStringView Body(BodyText.data() + BodyEnds[BodyId], size_t(BodyEnds[BodyId + 1] - BodyEnds[BodyId]));
+		if (!Body.empty() && Body[Body.Size - 1] == '\r') --Body.Size;
+		return Body;
+	}
+
+	const uint32_t* GetBlockBodyIds(size_t BlockIdx) const { return Blocks[BlockIdx].BodyIds.data(); }
+
+	bool GetLinePrefix(size_t BlockIdx, size_t LocalIdx, int64_t& OutTimestampMs, int& OutFrame) const
+	{
+		const FColumnBlock& Block = Blocks[BlockIdx];
+		if (!(Block.BodyIds[LocalIdx] & FLineStore::BodyIdPrefixBit)) return false;
+		OutTimestampMs = Block.BaseTimestampMs + Block.TimestampDeltas[LocalIdx];
+		OutFrame = Block.Frames[LocalIdx];
+		return true;
+	}
+
+	/** True once a line had a new body after every id was taken */
+	bool IsOutOfIds() const { return bOutOfIds; }
+
+	uint64_t GetTextBytes() const { return BodyText.capacity(); }
+
+	uint64_t GetIndexBytes() const
+	{
+		uint64_t NumBytes = Blocks.capacity() * sizeof(FColumnBlock) + (BodyEnds.capacity() + HashTable.capacity()) * sizeof(uint64_t);
+		for (const FColumnBlock& Block : Blocks)
+		{
+			NumBytes += Block.BodyIds.capacity() * sizeof(uint32_t) + Block.TimestampDeltas.capacity() * sizeof(int32_t) + Block.Frames.capacity() * sizeof(uint16_t);
+		}
+		return NumBytes;
+	}
+
+private:
+	struct FColumnBlock
+	{
+		int64_t BaseTimestampMs = 0;
+		bool bHasBaseTimestamp = false;
+		bool bFinished = false;
+		std::vector<uint32_t> BodyIds;
+		std::vector<int32_t> TimestampDeltas;
+		std::vector<uint16_t> Frames;
+	};
+
+	static uint32_t HashBody(const char* Data, size_t Size)
+	{
+		uint64_t Hash = Size * 0x9E3779B97F4A7C15ull;
+		for (; Size >= 8; Data += 8, Size -= 8)
+		{
+			uint64_t Word;
+			memcpy(&Word, Data, 8);
+			Hash = (Hash ^ Word) * 0xFF51AFD7ED558CCDull;
+			Hash ^= Hash >> 32;
+		}
+		uint64_t Word = 0;
+		memcpy(&Word, Data, Size);
+		Hash = (Hash ^ Word) * 0xC4CEB9FE1A85EC53ull;
+		return uint32_t(Hash ^ (Hash >> 29));
+	}
+
+	uint32_t AddBody(const char* Data, size_t Size)
+	{
+		const uint32_t Hash = HashBody(Data, Size);
+		const size_t Mask = HashTable.size() - 1;
+		size_t SlotIdx = Hash & Mask;
+		for (; HashTable[SlotIdx]; SlotIdx = (SlotIdx + 1) & Mask)
+		{
+			const uint64_t Slot = HashTable[SlotIdx];
+			const uint32_t Id = uint32_t(Slot) - 1;
+			if (uint32_t(Slot >> 32) == Hash && BodyEnds[Id + 1] - BodyEnds[Id] == Size && memcmp(BodyText.data() + BodyEnds[Id], Data, Size) == 0)
+			{
+				return Id;
+			}
+		}
+
+		// Ids share their top bit with the prefix flag, which limits a file to 2^31 distinct bodies.
+		// Past that the lines would get the wrong text, so they are marked as lost and the file has to be read another way.
+		if (NumBodies() >= FLineStore::BodyIdPrefixBit)
+		{
+			bOutOfIds = true;
+			return 0;
+		}
+		const uint32_t Id = NumBodies();
+		BodyText.insert(BodyText.end(), Data, Data + Size);
+		BodyEnds.push_back(BodyText.size());
+		HashTable[SlotIdx] = (uint64_t(Hash) << 32) | (Id + 1);
+		if (BodyEnds.size() * 2 > HashTable.size())
+		{
+			Rehash(HashTable.size() * 2);
+		}
+		return Id;
+	}
+
+	void Rehash(size_t NumSlots)
+	{
+		std::vector<uint64_t> OldTable(NumSlots, 0);
+		OldTable.swap(HashTable);
+		const size_t Mask = NumSlots - 1;
+		for (uint64_t Slot : OldTable)
+		{
+			if (!Slot) continue;
+			size_t SlotIdx = uint32_t(Slot >> 32) & Mask;
+			while (HashTable[SlotIdx]) SlotIdx = (SlotIdx + 1) & Mask;
+			HashTable[SlotIdx] = Slot;
+		}
+	}
+
+	std::vector<FColumnBlock> Blocks;
+	std::vector<char> BodyText;
+	std::vector<uint64_t> BodyEnds;
+
+	// Open addressing table of body hash << 32 | body id + 1, only kept while lines are added
+	std::vector<uint64_t> HashTable;
+	bool bOutOfIds = false;
+};
+
+/**
+ * Blocks of text that are read back from the log file or decompressed on demand,
+ * shared with the jobs that prefetch them. Pages are only added while the store is built.
+ */
+class FPageCache
+{
+public:
+	FPageCache(const std::string& FilePath, const std::shared_ptr<const FLineBodies>& InBodies = nullptr)
+		: Bodies(InBodies)
+	{
+		if (!FilePath.empty()) File.open(FilePath, std::ios::binary);
+	}
+
+	void AddPage(uint64_t FileOffset, uint32_t Size)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FPage Page;
+		Page.FileOffset = FileOffset;
+		Page.Size = Size;
+		Pages.push_back(std::move(Page));
+	}
+
+	/** Compresses the page on a worker thread, call WaitForCompression before reading any of them */
+	void AddCompressedPage(const std::shared_ptr<FPageCache>& Self, std::vector<char>&& Text)
+	{
+		size_t PageIdx;
+		{
+			// Do not let reading run too far ahead of compression, or we hold the whole file uncompressed
+			std::unique_lock<std::mutex> Lock(Mutex);
+			PagesCompressed.wait(Lock, [this]() { return NumCompressing < 2 * Jobs::GetNumWorkers(); });
+			PageIdx = Pages.size();
+			Pages.emplace_back();
+			Pages.back().Size = uint32_t(Text.size());
+			++NumCompressing;
+		}
+
+		std::shared_ptr<std::vector<char>> SharedText = std::make_shared<std::vector<char>>(std::move(Text));
+		Jobs::Launch([Self, PageIdx, SharedText]()
+		{
+			ULV_PROFILE_SCOPE("FPageCache::Compress");
+			std::vector<char> Compressed(Lz4::GetMaxCompressedSize(SharedText->size()));
+			Compressed.resize(Lz4::Compress(SharedText->data(), SharedText->size(), Compressed.data()));
+			Compressed.shrink_to_fit();
+			ULV_PROFILE_WORK(0, SharedText->size());
+			{
+				std::lock_guard<std::mutex> Lock(Self->Mutex);
+				Self->CompressedBytes += Compressed.capacity();
+				Self->Pages[PageIdx].Compressed = std::move(Compressed);
+				--Self->NumCompressing;
+			}
+			Self->PagesCompressed.notify_all();
+		});
+	}
+
+	void WaitForCompression()
+	{
+		std::unique_lock<std::mutex> Lock(Mutex);
+		PagesCompressed.wait(Lock, [this]() { return NumCompressing == 0; });
+	}
+
+	FBlockText Pin(size_t PageIdx)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			FPage& Page = Pages[PageIdx];
+			if (Page.Text)
+			{
+				Page.LastUsed = ++UseCounter;
+				return Page.Text;
+			}
+		}
+
+		FBlockText Text = Load(PageIdx);
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FPage& Page = Pages[PageIdx];
+		Page.LastUsed = ++UseCounter;
+		if (!Page.Text)
+		{
+			// Whoever loaded it first wins, a prefetch may have beaten us to it
+			Page.Text = Text;
+			ResidentPages.push_back(PageIdx);
+			ResidentBytes += Text->capacity();
+			TrimLocked(Budget);
+		}
+		return Page.Text;
+	}
+
+	void Prefetch(const std::shared_ptr<FPageCache>& Self, size_t PageIdx)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			FPage& Page = Pages[PageIdx];
+			if (Page.Text || Page.bPrefetching) return;
+			Page.bPrefetching = true;
+		}
+		Jobs::Launch([Self, PageIdx]()
+		{
+			Self->Pin(PageIdx);
+			std::lock_guard<std::mutex> Lock(Self->Mutex);
+			Self->Pages[PageIdx].bPrefetching = false;
+		});
+	}
+
+	void SetBudget(uint64_t NumBytes)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Budget = NumBytes;
+	}
+
+	uint64_t Trim(uint64_t TargetBytes)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return TrimLocked(TargetBytes);
+	}
+
+	uint64_t GetResidentBytes()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return ResidentBytes + CompressedBytes;
+	}
+
+	uint64_t GetIndexBytes()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return Pages.capacity() * sizeof(FPage) + ResidentPages.capacity() * sizeof(size_t);
+	}
+
+private:
+	struct FPage
+	{
+		uint64_t FileOffset = 0;
+		uint32_t Size = 0;
+		std::vector<char> Compressed;
+		bool bPrefetching = false;
+		uint64_t LastUsed = 0;
+		FBlockText Text;
+	};
+
+	FBlockText Load(size_t PageIdx)
+	{
+		ULV_PROFILE_SCOPE("FPageCache::Load");
+		uint64_t FileOffset;
+		uint32_t Size;
+		const std::vector<char>* Compressed;
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			FileOffset = Pages[PageIdx].FileOffset;
+			Size = Pages[PageIdx].Size;
+			Compressed = &Pages[PageIdx].Compressed;
+		}
+
+		std::shared_ptr<std::vector<char>> Text = std::make_shared<std::vector<char>>(Size);
+		if (Bodies)
+		{
+			Text->clear();
+			Bodies->BuildBlockText(PageIdx, *Text);
+			Text->resize(Size, ' ');
+		}
+		else if (!Compressed->empty())
+		{
+			if (!Lz4::Decompress(Compressed->data(), Compressed->size(), Text->data(), Size))
+			{
+				std::fill(Text->begin(), Text->end(), ' ');
+			}
+		}
+		else
+		{
+			std::lock_guard<std::mutex> Lock(FileMutex);
+			File.clear();
+			File.seekg(FileOffset);
+			File.read(Text->data(), Size);
+			// If the file shrank underneath us, show the missing text as blank rather than garbage
+			std::fill(Text->begin() + size_t(File.gcount()), Text->end(), ' ');
+		}
+		ULV_PROFILE_WORK(0, Size);
+		return Text;
+	}
+
+	/** Evicts least recently used pages that nobody else references */
+	uint64_t TrimLocked(uint64_t TargetBytes)
+	{
+		if (ResidentBytes <= TargetBytes) return 0;
+
+		std::sort(ResidentPages.begin(), ResidentPages.end(), [this](size_t A, size_t B) { return Pages[A].LastUsed > Pages[B].LastUsed; });
+		const uint64_t PrevResidentBytes = ResidentBytes;
+		for (size_t ResidentIdx = ResidentPages.size(); ResidentIdx-- > 0 && ResidentBytes > TargetBytes; )
+		{
+			FPage& Page = Pages[ResidentPages[ResidentIdx]];
+			if (Page.Text.use_count() > 1) continue;
+			ResidentBytes -= Page.Text->capacity();
+			Page.Text.reset();
+			ResidentPages.erase(ResidentPages.begin() + ResidentIdx);
+		}
+		return PrevResidentBytes - ResidentBytes;
+	}
+
+	std::mutex Mutex;
+	std::vector<FPage> Pages;
+	std::vector<size_t> ResidentPages;
+	uint64_t ResidentBytes = 0;
+	uint64_t CompressedBytes = 0;
+	int NumCompressing = 0;
+	std::condition_variable PagesCompressed;
+	uint64_t UseCounter = 0;
+	uint64_t Budget = 256ull * 1024 * 1024;
+
+	std::mutex FileMutex;
+	std::ifstream File;
+
+	std::shared_ptr<const FLineBodies> Bodies;
+};
+
+FLineStore::FLineStore()
+{
+}
+
+FLineStore::FLineStore(ELineStorage InStorage, const std::string& FilePath)
+	: Storage(InStorage)
+{
+	if (Storage == ELineStorage::Paged)
+	{
+		PageCache = std::make_shared<FPageCache>(FilePath);
+	}
+	else if (Storage == ELineStorage::Compressed)
+	{
+		PageCache = std::make_shared<FPageCache>(std::string());
+	}
+	else if (Storage == ELineStorage::Deduplicated)
+	{
+		Bodies = std::make_shared<FLineBodies>();
+		PageCache = std::make_shared<FPageCache>(std::string(), Bodies);
+	}
+}
+
+void FLineStore::AppendText(const char* Text, size_t Size)
+{
+	const char* End = Text + Size;
+	while (Text < End)
+	{
+		const char* LineEnd = (const char*)memchr(Text, '\n', End - Text);
+		if (!LineEnd)
+		{
+			AppendToLine(Text, End - Text);
+			break;
+		}
+		AppendToLine(Text, LineEnd - Text + 1);
+		EndLine();
+		Text = LineEnd + 1;
+	}
+}
+
+void FLineStore::AddLine(FStringView Line)
+{
+	AppendToLine(Line.Data, Line.Size);
+	AppendToLine("\n", 1);
+	EndLine();
+}
+
+void FLineStore::AddBlock(std::vector<uint32_t>&& LineEnds, std::vector<char>&& Text)
+{
+	const uint32_t BlockSize = LineEnds.empty() ? 0 : LineEnds.back();
+	Blocks.emplace_back();
+	Blocks.back().LineEnds = std::move(LineEnds);
+	BlockText = std::move(Text);
+	NumLines += Blocks.back().LineEnds.size();
+	NumTextBytes += BlockSize;
+	CommitBlock();
+}
+
+void FLineStore::Finish()
+{
+	// Full blocks are committed as soon as their last line ends
+	if (!Blocks.empty() && Blocks.back().LineEnds.size() < LinesPerBlock)
+	{
+		const FBlock& Block = Blocks.back();
+		if (BlockText.size() > (Block.LineEnds.empty() ? 0 : Block.LineEnds.back()))
+		{
+			EndLine();
+		}
+		if (Blocks.back().LineEnds.size() < LinesPerBlock)
+		{
+			CommitBlock();
+		}
+	}
+	std::vector<char>().swap(BlockText);
+	Blocks.shrink_to_fit();
+	if (Storage == ELineStorage::Compressed)
+	{
+		PageCache->WaitForCompression();
+	}
+	else if (Bodies)
+	{
+		Bodies->Finish();
+	}
+}
+
+void FLineStore::AppendToLine(const char* Text, size_t Size)
+{
+	if (Blocks.empty() || Blocks.back().LineEnds.size() == LinesPerBlock)
+	{
+		Blocks.emplace_back();
+		Blocks.back().LineEnds.reserve(LinesPerBlock);
+	}
+
+	// Offsets are 32 bit, a line that would not fit is truncated
+	const size_t NumAppended = std::min<size_t>(Size, UINT32_MAX - 1 - BlockText.size());
+	BlockText.insert(BlockText.end(), Text, Text + NumAppended);
+	NumTextBytes += Size;
+}
+
+void FLineStore::EndLine()
+{
+	FBlock& Block = Blocks.back();
+	if (BlockText.empty() || BlockText.back() != '\n')
+	{
+		// The last line of a file may not have a line ending, the offsets assume one anyway
+		BlockText.push_back('\n');
+	}
+	Block.LineEnds.push_back(uint32_t(BlockText.size()));
+	++NumLines;
+	if (Block.LineEnds.size() == LinesPerBlock)
+	{
+		CommitBlock();
+	}
+}
+
+void FLineStore::CommitBlock()
+{
+	FBlock& Block = Blocks.back();
+	Block.LineEnds.shrink_to_fit();
+	if (Storage == ELineStorage::Paged)
+	{
+		PageCache->AddPage(BlockFileOffset, uint32_t(NumTextBytes - BlockFileOffset));
+		BlockText.clear();
+	}
+	else if (Storage == ELineStorage::Deduplicated)
+	{
+		uint32_t LineStart = 0;
+		for (uint32_t LineEnd : Block.LineEnds)
+		{
+			Bodies->AddLine(BlockText.data() + LineStart, LineEnd - LineStart);
+			LineStart = LineEnd;
+		}
+		Bodies->FinishBlock();
+		PageCache->AddPage(0, uint32_t(BlockText.size()));
+		BlockText.clear();
+	}
+	else if (Storage == ELineStorage::Compressed)
+	{
+		const size_t ExpectedSize = BlockText.size() + BlockText.size() / 8;
+		PageCache->AddCompressedPage(PageCache, std::move(BlockText));
+		BlockText = std::vector<char>();
+		BlockText.reserve(ExpectedSize);
+	}
+	else
+	{
+		const size_t ExpectedSize = BlockText.size() + BlockText.size() / 8;
+		if (BlockText.capacity() - BlockText.size() > BlockText.size() / 8) BlockText.shrink_to_fit();
+		Block.Text = std::make_shared<const std::vector<char>>(std::move(BlockText));
+		BlockText = std::vector<char>();
+		BlockText.reserve(ExpectedSize);
+	}
+	BlockFileOffset = NumTextBytes;
+}
+
+FBlockText FLineStore::PinBlock(size_t BlockIdx) const
+{
+	return PageCache ? PageCache->Pin(BlockIdx) : Blocks[BlockIdx].Text;
+}
+
+void FLineStore::Prefetch(size_t BlockIdx) const
+{
+	if (PageCache) PageCache->Prefetch(PageCache, BlockIdx);
+}
+
+void FLineStore::SetCacheBudget(uint64_t NumBytes)
+{
+	if (PageCache) PageCache->SetBudget(NumBytes);
+}
+
+uint64_t FLineStore::Trim(uint64_t TargetBytes)
+{
+	return PageCache ? PageCache->Trim(TargetBytes) : 0;
+}
+
+uint64_t FLineStore::GetTextBytes() const
+{
+	if (PageCache) return PageCache->GetResidentBytes() + (Bodies ? Bodies->GetTextBytes() : 0);
+
+	uint64_t NumBytes = BlockText.capacity();
+	for (const FBlock& Block : Blocks)
+	{
+		NumBytes += Block.Text ? Block.Text->capacity() : 0;
+	}
+	return NumBytes;
+}
+
+uint64_t FLineStore::GetIndexBytes() const
+{
+	uint64_t NumBytes = Blocks.capacity() * sizeof(FBlock) + (PageCache ? PageCache->GetIndexBytes() : 0) + (Bodies ? Bodies->GetIndexBytes() : 0);
+	for (const FBlock& Block : Blocks)
+	{
+		NumBytes += Block.LineEnds.capacity() * sizeof(uint32_t);
+	}
+	return NumBytes;
+}
+
+bool FLineStore::IsOutOfBodyIds() const
+{
+	return Bodies && Bodies->IsOutOfIds();
+}
+
+uint32_t FLineStore::NumBodies() const
+{
+	return Bodies->NumBodies();
+}
+
+FStringView FLineStore::GetBody(uint32_t BodyId) const
+{
+	return Bodies->GetBody(BodyId);
+}
+
+const uint32_t* FLineStore::GetBlockBodyIds(size_t BlockIdx) const
+{
+	return Bodies->GetBlockBodyIds(BlockIdx);
+}
+
+bool FLineStore::GetLinePrefix(uint64_t LineIdx, int64_t& OutTimestampMs, int& OutFrame) const
+{
+	return Bodies && Bodies->GetLinePrefix(size_t(LineIdx >> LinesPerBlockLog2), size_t(LineIdx & (LinesPerBlock - 1)), OutTimestampMs, OutFrame);
+}
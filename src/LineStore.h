@@ -0,0 +1,172 @@
+#pragma once
+
+#include "StringView.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class ELineStorage : int
+{
+	Memory = 0,
+	Paged,
+	Compressed,
+	Deduplicated,
+	MAX
+};
+
+extern const char* ELineStorageStrings[(int)ELineStorage::MAX + 1];
+
+/** Text of one block of lines, kept loaded for as long as anyone holds a reference */
+typedef std::shared_ptr<const std::vector<char>> FBlockText;
+
+struct FLineRef
+{
+	FBlockText Block;
+	FStringView Text;
+};
+
+class FPageCache;
+class FLineBodies;
+
+/**
+ * Text of a log file, stored as raw file bytes in blocks of a fixed number of lines.
+ * Each line costs a 32 bit end offset into its block, its start is the end of the line before it.
+ * With paged storage only the line index stays in memory, and the text of a block is
+ * read back from the file when it is needed and evicted least recently used first.
+ * Compressed storage keeps every block LZ4 compressed in memory and caches the
+ * decompressed blocks the same way.
+ * Deduplicated storage splits the [timestamp][frame] prefix of each line off into numbers
+ * and keeps every distinct message body once, block text is rebuilt from them on demand.
+ */
+class FLineStore
+{
+public:
+	static const int LinesPerBlockLog2 = 12;
+	static const int LinesPerBlock = 1 << LinesPerBlockLog2;
+	// How many blocks ahead ForEachLine loads in the background
+	static const int NumPrefetchBlocks = 4;
+
+	FLineStore();
+	FLineStore(ELineStorage InStorage, const std::string& FilePath);
+
+	/** Appends raw text, which may start or end in the middle of a line */
+	void AppendText(const char* Text, size_t Size);
+	void AddLine(FStringView Line);
+
+	/**
+	 * Adds a full block of lines whose ends are already known, e.g. from a cached index, without scanning its text.
+	 * Only valid between blocks. The text is not needed with paged storage.
+	 */
+	void AddBlock(std::vector<uint32_t>&& LineEnds, std::vector<char>&& Text);
+
+	/** Terminates a trailing partial line and releases spare capacity, call once all text has been appended */
+	void Finish();
+
+	uint64_t Num() const { return NumLines; }
+	size_t NumBlocks() const { return Blocks.size(); }
+	size_t NumLinesInBlock(size_t BlockIdx) const { return Blocks[BlockIdx].LineEnds.size(); }
+
+	/** Offset just past the '\n' of each line of a block, relative to the start of the block */
+	const std::vector<uint32_t>& GetBlockLineEnds(size_t BlockIdx) const { return Blocks[BlockIdx].LineEnds; }
+	ELineStorage GetStorage() const { return Storage; }
+
+	/** The line without its line ending, loading its block if needed */
+	FLineRef GetLine(uint64_t LineIdx) const
+	{
+		FLineRef Line;
+		Line.Block = PinBlock(size_t(LineIdx >> LinesPerBlockLog2));
+		Line.Text = GetLineInBlock(*Line.Block, LineIdx);
+		return Line;
+	}
+
+	/** Returns the text of a block, loading it if needed */
+	FBlockText PinBlock(size_t BlockIdx) const;
+
+	/** Starts loading a block in the background */
+	void Prefetch(size_t BlockIdx) const;
+
+	FStringView GetLineInBlock(const std::vector<char>& BlockText, uint64_t LineIdx) const
+	{
+		const FBlock& Block = Blocks[size_t(LineIdx >> LinesPerBlockLog2)];
+		const size_t LocalIdx = size_t(LineIdx & (LinesPerBlock - 1));
+		const uint32_t Start = LocalIdx ? Block.LineEnds[LocalIdx - 1] : 0;
+		uint32_t End = Block.LineEnds[LocalIdx] - 1;
+		if (End > Start && BlockText[End - 1] == '\r') --End;
+		return FStringView(BlockText.data() + Start, End - Start);
+	}
+
+	/** Calls Func(LineIdx, Line) for every line in [FirstLine, EndLine), streaming the blocks in order */
+	template<class TFunc>
+	void ForEachLine(uint64_t FirstLine, uint64_t EndLine, TFunc Func) const
+	{
+		for (uint64_t LineIdx = FirstLine; LineIdx < EndLine; )
+		{
+			const size_t BlockIdx = size_t(LineIdx >> LinesPerBlockLog2);
+			const FBlockText Text = PinBlock(BlockIdx);
+			for (size_t PrefetchIdx = BlockIdx + 1; PrefetchIdx <= BlockIdx + NumPrefetchBlocks && PrefetchIdx < Blocks.size(); ++PrefetchIdx)
+			{
+				Prefetch(PrefetchIdx);
+			}
+			const uint64_t BlockEndLine = std::min(EndLine, uint64_t(BlockIdx + 1) << LinesPerBlockLog2);
+			for (; LineIdx < BlockEndLine; ++LineIdx)
+			{
+				Func(LineIdx, GetLineInBlock(*Text, LineIdx));
+			}
+		}
+	}
+
+	/** Most bytes of paged or decompressed text to keep loaded, blocks still referenced may go over it */
+	void SetCacheBudget(uint64_t NumBytes);
+
+	/** Evicts loaded pages until at most TargetBytes remain, returns the number of bytes released */
+	uint64_t Trim(uint64_t TargetBytes);
+
+	uint64_t GetTextBytes() const;
+	uint64_t GetIndexBytes() const;
+
+	// Deduplicated storage only. Lines with the same body id have the same text after their prefix,
+	// lines without a prefix are a body on their own.
+
+	// Set in the body ids of lines that start with a prefix
+	static const uint32_t BodyIdPrefixBit = 0x80000000u;
+
+	bool HasBodies() const { return Bodies != nullptr; }
+	/** True if the log has more distinct bodies than ids, some lines then have the wrong text and the store can't be used */
+	bool IsOutOfBodyIds() const;
+	uint32_t NumBodies() const;
+
+	/** Body text without its line ending */
+	FStringView GetBody(uint32_t BodyId) const;
+
+	/** Body id of every line in the block, one per line */
+	const uint32_t* GetBlockBodyIds(size_t BlockIdx) const;
+
+	/** Returns false if the line has no prefix */
+	bool GetLinePrefix(uint64_t LineIdx, int64_t& OutTimestampMs, int& OutFrame) const;
+
+private:
+	struct FBlock
+	{
+		// Offset just past the '\n' of each line
+		std::vector<uint32_t> LineEnds;
+		// Always set with memory storage, paged text lives in the page cache
+		FBlockText Text;
+	};
+
+	void AppendToLine(const char* Text, size_t Size);
+	void EndLine();
+	void CommitBlock();
+
+	ELineStorage Storage = ELineStorage::Memory;
+	std::vector<FBlock> Blocks;
+	// Text of the block being appended to
+	std::vector<char> BlockText;
+	uint64_t NumLines = 0;
+	uint64_t NumTextBytes = 0;
+	uint64_t BlockFileOffset = 0;
+	std::shared_ptr<FPageCache> PageCache;
+	std::shared_ptr<FLineBodies> Bodies;
+};
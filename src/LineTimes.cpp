@@ -0,0 +1,178 @@
+#include "LineTimes.h"
+
+#include <algorithm>
+#include <cstring>
+
+static int64_t DaysFromCivil(int Year, int Month, int Day)
+{
+	// From Howard Hinnant's date algorithms
+	Year -= Month <= 2;
+	const int64_t Era = (Year >= 0 ? Year : Year - 399) / 400;
+	const int YearOfEra = int(Year - Era * 400);
+	const int DayOfYear = (153 * (Month + (Month > 2 ? -3 : 9)) + 2) / 5 + Day - 1;
+	const int DayOfEra = YearOfEra * 365 + YearOfEra / 4 - YearOfEra / 100 + DayOfYear;
+	return Era * 146097 + DayOfEra - 719468;
+}
+
+static void WriteDigits(char* Out, int Value, int NumDigits)
+{
+	for (int DigitIdx = NumDigits - 1; DigitIdx >= 0; --DigitIdx, Value /= 10)
+	{
+		Out[DigitIdx] = char('0' + Value % 10);
+	}
+}
+
+void FormatLinePrefix(int64_t TimestampMs, int Frame, char* Out)
+{
+	const int64_t Seconds = TimestampMs / 1000;
+	const int64_t Z = Seconds / 86400 + 719468;
+	const int SecondOfDay = int(Seconds % 86400);
+	const int64_t Era = Z / 146097;
+	const int DayOfEra = int(Z - Era * 146097);
+	const int YearOfEra = (DayOfEra - DayOfEra / 1460 + DayOfEra / 36524 - DayOfEra / 146096) / 365;
+	const int DayOfYear = DayOfEra - (365 * YearOfEra + YearOfEra / 4 - YearOfEra / 100);
+	const int MonthPrime = (5 * DayOfYear + 2) / 153;
+	const int Day = DayOfYear - (153 * MonthPrime + 2) / 5 + 1;
+	const int Month = MonthPrime < 10 ? MonthPrime + 3 : MonthPrime - 9;
+	const int Year = int(YearOfEra + Era * 400) + (Month <= 2);
+
+	memcpy(Out, "[0000.00.00-00.00.00:000][   ]", LinePrefixSize);
+	WriteDigits(Out + 1, Year, 4);
+	WriteDigits(Out + 6, Month, 2);
+	WriteDigits(Out + 9, Day, 2);
+	WriteDigits(Out + 12, SecondOfDay / 3600, 2);
+	WriteDigits(Out + 15, (SecondOfDay / 60) % 60, 2);
+	WriteDigits(Out + 18, SecondOfDay % 60, 2);
+	WriteDigits(Out + 21, int(TimestampMs % 1000), 3);
+	const int NumFrameDigits = Frame >= 100 ? 3 : Frame >= 10 ? 2 : 1;
+	WriteDigits(Out + 29 - NumFrameDigits, Frame, NumFrameDigits);
+}
+
+void FormatTime(int64_t TimeMs, char* Out)
+{
+	char Prefix[LinePrefixSize];
+	FormatLinePrefix(TimeMs, 0, Prefix);
+	memcpy(Out, Prefix + 1, TimeTextSize);
+}
+
+bool ParseTime(const char* Text, size_t Size, int64_t& OutTimeMs)
+{
+	if (Size != TimeTextSize) return false;
+	char Prefix[LinePrefixSize];
+	Prefix[0] = '[';
+	memcpy(Prefix + 1, Text, TimeTextSize);
+	memcpy(Prefix + 1 + TimeTextSize, "][  0]", 6);
+	int Frame;
+	return ParseLinePrefix(Prefix, LinePrefixSize, OutTimeMs, Frame);
+}
+
+bool ParseLinePrefix(const char* Line, size_t Size, int64_t& OutTimestampMs, int& OutFrame)
+{
+	if (Size < LinePrefixSize || Line[0] != '[' || Line[24] != ']' || Line[25] != '[' || Line[29] != ']') return false;
+
+	int Fields[7];
+	static const int FieldStarts[7] = { 1, 6, 9, 12, 15, 18, 21 };
+	static const int FieldSizes[7] = { 4, 2, 2, 2, 2, 2, 3 };
+	for (int FieldIdx = 0; FieldIdx < 7; ++FieldIdx)
+	{
+		int Value = 0;
+		for (int CharIdx = FieldStarts[FieldIdx]; CharIdx < FieldStarts[FieldIdx] + FieldSizes[FieldIdx]; ++CharIdx)
+		{
+			if (Line[CharIdx] < '0' || Line[CharIdx] > '9') return false;
+			Value = Value * 10 + (Line[CharIdx] - '0');
+		}
+		Fields[FieldIdx] = Value;
+	}
+	if (Fields[1] < 1 || Fields[1] > 12 || Fields[2] < 1 || Fields[2] > 31 || Fields[3] > 23 || Fields[4] > 59 || Fields[5] > 59) return false;
+
+	OutFrame = 0;
+	for (int CharIdx = 26; CharIdx < 29; ++CharIdx)
+	{
+		if (Line[CharIdx] >= '0' && Line[CharIdx] <= '9') OutFrame = OutFrame * 10 + (Line[CharIdx] - '0');
+	}
+	OutTimestampMs = ((DaysFromCivil(Fields[0], Fields[1], Fields[2]) * 24 + Fields[3]) * 60 + Fields[4]) * 60 * 1000
+		+ Fields[5] * 1000 + Fields[6];
+
+	return true;
+}
+
+void FLineTimes::Add(bool bHasTime, int64_t TimeMs, int Frame)
+{
+	if (bHasTime && !bHasTimes)
+	{
+		// Lines before the first timestamp happened at about the same time as it
+		std::fill(Bases.begin(), Bases.end(), TimeMs);
+		LastTime = TimeMs;
+		std::fill(FrameBases.begin(), FrameBases.end(), int64_t(Frame));
+		LastFrame = Frame;
+		bHasTimes = true;
+	}
+	if (bHasTime)
+	{
+		LastTime = std::max(LastTime, TimeMs);
+		if (LastFrameColumn >= 0)
+		{
+			LastFrame += Frame >= LastFrameColumn ? Frame - LastFrameColumn : Frame + 1000 - LastFrameColumn;
+		}
+		LastFrameColumn = Frame;
+	}
+
+	if ((Offsets.size() & (LinesPerBlock - 1)) == 0)
+	{
+		Bases.push_back(LastTime);
+		FrameBases.push_back(LastFrame);
+	}
+	FrameOffsets.push_back(uint16_t(std::min<int64_t>(LastFrame - FrameBases.back(), UINT16_MAX)));
+	const int64_t Base = Bases.back();
+	// A block that spans more than 49 days keeps its order, but not the times of its last lines
+	Offsets.push_back(Base == NoTime ? 0 : uint32_t(std::min<int64_t>(LastTime - Base, UINT32_MAX)));
+}
+
+void FLineTimes::AddBlock(int64_t BaseTimeMs, const uint32_t* BlockOffsets, int64_t BaseFrame, const uint16_t* BlockFrameOffsets)
+{
+	if (BaseTimeMs != NoTime && !bHasTimes)
+	{
+		std::fill(Bases.begin(), Bases.end(), BaseTimeMs);
+		std::fill(FrameBases.begin(), FrameBases.end(), BaseFrame);
+		bHasTimes = true;
+	}
+	Bases.push_back(BaseTimeMs);
+	Offsets.insert(Offsets.end(), BlockOffsets, BlockOffsets + LinesPerBlock);
+	LastTime = BaseTimeMs == NoTime ? NoTime : BaseTimeMs + Offsets.back();
+	FrameBases.push_back(BaseFrame);
+	FrameOffsets.insert(FrameOffsets.end(), BlockFrameOffsets, BlockFrameOffsets + LinesPerBlock);
+	LastFrame = BaseFrame + FrameOffsets.back();
+	LastFrameColumn = bHasTimes ? int(LastFrame % 1000) : -1;
+}
+
+uint64_t FLineTimes::FindLine(int64_t TimeMs) const
+{
+	uint64_t Lo = 0, Hi = Num();
+	while (Lo < Hi)
+	{
+		const uint64_t Mid = Lo + (Hi - Lo) / 2;
+		if ((*this)[Mid] < TimeMs) Lo = Mid + 1;
+		else Hi = Mid;
+	}
+	return Lo;
+}
+
+uint64_t FLineTimes::FindFrameLine(int64_t Frame) const
+{
+	uint64_t Lo = 0, Hi = Num();
+	while (Lo < Hi)
+	{
+		const uint64_t Mid = Lo + (Hi - Lo) / 2;
+		if (GetFrame(Mid) < Frame) Lo = Mid + 1;
+		else Hi = Mid;
+	}
+	return Lo;
+}
+
+void FLineTimes::Reserve(uint64_t NumLines)
+{
+	Bases.reserve(size_t((NumLines + LinesPerBlock - 1) >> LinesPerBlockLog2));
+	Offsets.reserve(size_t(NumLines));
+	FrameBases.reserve(Bases.capacity());
+	FrameOffsets.reserve(size_t(NumLines));
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/** Size of the [YYYY.MM.DD-HH.MM.SS:mmm][fff] prefix Unreal puts in front of log lines */
+static const int LinePrefixSize = 30;
+
+/** Parses the prefix at the start of a line into milliseconds since 1970 and the frame number, returns false if there is none */
+bool ParseLinePrefix(const char* Line, size_t Size, int64_t& OutTimestampMs, int& OutFrame);
+
+/** Writes the LinePrefixSize characters of a prefix */
+void FormatLinePrefix(int64_t TimestampMs, int Frame, char* Out);
+
+/** Size of a YYYY.MM.DD-HH.MM.SS:mmm time as it is written in a prefix */
+static const int TimeTextSize = 23;
+
+/** Writes the TimeTextSize characters of a time */
+void FormatTime(int64_t TimeMs, char* Out);
+
+/** Parses a time written as it is in a prefix, returns false if the text is anything else */
+bool ParseTime(const char* Text, size_t Size, int64_t& OutTimeMs);
+
+/**
+ * Time of every line of a log in milliseconds, for lining logs up with each other, and its frame.
+ * A line without a timestamp takes the time of the line before it and time never goes backwards,
+ * so the times are sorted and can be binary searched. Lines before the first timestamp take its time.
+ * Stored as a base per block of lines and a 32 bit offset from it per line.
+ *
+ * The prefix only has the frame counter modulo 1000, so frames are unwrapped by counting each time it goes backwards,
+ * which misses a wrap if two lines with a prefix are more than 1000 frames apart. Frames are sorted the same way
+ * as times and stored as a base per block and a 16 bit offset per line, which saturates in a block spanning more frames than that.
+ */
+class FLineTimes
+{
+public:
+	static const int LinesPerBlockLog2 = 12;
+	static const int LinesPerBlock = 1 << LinesPerBlockLog2;
+	// Time of every line of a log without any timestamps
+	static const int64_t NoTime = INT64_MIN;
+
+	/** Adds the next line, bHasTime is false for lines without a prefix. Frame is the frame column of the prefix. */
+	void Add(bool bHasTime, int64_t TimeMs, int Frame = 0);
+
+	/** Adds a whole block as returned by the GetBlock functions, only valid between blocks */
+	void AddBlock(int64_t BaseTimeMs, const uint32_t* Offsets, int64_t BaseFrame, const uint16_t* FrameOffsets);
+
+	uint64_t Num() const { return Offsets.size(); }
+	bool HasTimes() const { return bHasTimes; }
+
+	int64_t operator[](uint64_t LineIdx) const
+	{
+		const int64_t Base = Bases[size_t(LineIdx >> LinesPerBlockLog2)];
+		return Base == NoTime ? NoTime : Base + Offsets[size_t(LineIdx)];
+	}
+
+	/** First line at or after a time, Num() if there is none */
+	uint64_t FindLine(int64_t TimeMs) const;
+
+	/** Unwrapped frame of a line, counting on from the frame column of the first line rather than the engine's frame counter */
+	int64_t GetFrame(uint64_t LineIdx) const { return FrameBases[size_t(LineIdx >> LinesPerBlockLog2)] + FrameOffsets[size_t(LineIdx)]; }
+
+	/** First line at or after an unwrapped frame, Num() if there is none */
+	uint64_t FindFrameLine(int64_t Frame) const;
+
+	int64_t GetBlockBase(size_t BlockIdx) const { return Bases[BlockIdx]; }
+	const uint32_t* GetBlockOffsets(size_t BlockIdx) const { return Offsets.data() + (BlockIdx << LinesPerBlockLog2); }
+	int64_t GetBlockBaseFrame(size_t BlockIdx) const { return FrameBases[BlockIdx]; }
+	const uint16_t* GetBlockFrameOffsets(size_t BlockIdx) const { return FrameOffsets.data() + (BlockIdx << LinesPerBlockLog2); }
+
+	void Reserve(uint64_t NumLines);
+	uint64_t GetAllocatedBytes() const
+	{
+		return (Bases.capacity() + FrameBases.capacity()) * sizeof(int64_t) + Offsets.capacity() * sizeof(uint32_t) + FrameOffsets.capacity() * sizeof(uint16_t);
+	}
+
+private:
+	std::vector<int64_t> Bases;
+	std::vector<uint32_t> Offsets;
+	int64_t LastTime = NoTime;
+	bool bHasTimes = false;
+
+	std::vector<int64_t> FrameBases;
+	std::vector<uint16_t> FrameOffsets;
+	// Unwrapped frame of the last line, and its frame column or -1 before the first prefix
+	int64_t LastFrame = 0;
+	int LastFrameColumn = -1;
+};
@@ -0,0 +1,612 @@
+#include "LogDiff.h"
+#include "Jobs.h"
+#include "LineTimes.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+const char* EDiffOpStrings[(int)EDiffOp::MAX + 1] =
+{
+	"Common",
+	"Removed",
+	"Added",
+	"MAX"
+};
+
+enum : uint8_t
+{
+	CharWord = 1,
+	CharDigit = 2,
+	CharHexLetter = 4
+};
+
+struct FCharClasses
+{
+	uint8_t Classes[256] = {};
+
+	FCharClasses()
+	{
+		for (int C = '0'; C <= '9'; ++C) Classes[C] = CharWord | CharDigit;
+		for (int C = 'a'; C <= 'z'; ++C) Classes[C] = CharWord | (C <= 'f' ? CharHexLetter : 0);
+		for (int C = 'A'; C <= 'Z'; ++C) Classes[C] = CharWord | (C <= 'F' ? CharHexLetter : 0);
+		Classes['_'] = CharWord;
+	}
+
+	bool IsWord(char C) const { return (Classes[uint8_t(C)] & CharWord) != 0; }
+	bool IsDigit(char C) const { return (Classes[uint8_t(C)] & CharDigit) != 0; }
+	bool IsHexDigit(char C) const { return (Classes[uint8_t(C)] & (CharDigit | CharHexLetter)) != 0; }
+};
+
+static const FCharClasses CharClasses;
+
+/** Size of the GUID at the start of Text, 0 if there is none */
+static size_t MatchGuid(const char* Text, const char* End)
+{
+	const char* It = Text;
+	while (It < End && CharClasses.IsHexDigit(*It)) ++It;
+	if (It - Text == 32) return It == End || !CharClasses.IsWord(*It) ? 32 : 0;
+	if (It - Text != 8) return 0;
+
+	static const int GroupSizes[4] = { 4, 4, 4, 12 };
+	for (int GroupSize : GroupSizes)
+	{
+		if (It == End || *It != '-') return 0;
+		++It;
+		for (int DigitIdx = 0; DigitIdx < GroupSize; ++DigitIdx, ++It)
+		{
+			if (It == End || !CharClasses.IsHexDigit(*It)) return 0;
+		}
+	}
+	return It == End || !CharClasses.IsWord(*It) ? size_t(It - Text) : 0;
+}
+
+static uint64_t MixHash(uint64_t Hash, uint64_t Value)
+{
+	Hash = (Hash ^ (Value * 0x9E3779B97F4A7C15ull)) * 0xD6E8FEB86659FD93ull;
+	return Hash ^ (Hash >> 32);
+}
+
+/** Mixes a run of text into the hash 8 bytes at a time */
+static uint64_t MixText(uint64_t Hash, const char* Text, const char* End)
+{
+	Hash = MixHash(Hash, uint64_t(End - Text));
+	for (; End - Text >= 8; Text += 8)
+	{
+		uint64_t Word;
+		memcpy(&Word, Text, 8);
+		Hash = MixHash(Hash, Word);
+	}
+	if (Text < End)
+	{
+		uint64_t Word = 0;
+		memcpy(&Word, Text, size_t(End - Text));
+		Hash = MixHash(Hash, Word);
+	}
+	return Hash;
+}
+
+uint64_t HashNormalizedLine(FStringView Line, const FDiffOptions& Options)
+{
+	const char* Text = Line.Data;
+	const char* End = Line.Data + Line.Size;
+	if (Text < End && End[-1] == '\r') --End;
+	int64_t TimestampMs;
+	int Frame;
+	if (ParseLinePrefix(Text, size_t(End - Text), TimestampMs, Frame)) Text += LinePrefixSize;
+
+	// Runs of text between the parts the options leave out are hashed whole, the parts left out as a placeholder each.
+	// Only characters that can start a part that is left out stop the scan.
+	const uint8_t StopClasses = (Options.bIgnoreNumbers || Options.bIgnoreGuids || Options.bIgnoreAddresses ? CharDigit : 0) | (Options.bIgnoreGuids ? CharHexLetter : 0);
+	if (!StopClasses) return MixText(0, Text, End);
+	uint64_t Hash = 0;
+	const char* RunStart = Text;
+	for (const char* It = Text; It < End; )
+	{
+		if (!(CharClasses.Classes[uint8_t(*It)] & StopClasses))
+		{
+			++It;
+			continue;
+		}
+
+		const bool bWordStart = It == Text || !CharClasses.IsWord(It[-1]);
+		const char* PartEnd = nullptr;
+		char Placeholder = 0;
+		size_t GuidSize = 0;
+		if (bWordStart && Options.bIgnoreAddresses && It[0] == '0' && End - It > 2 && (It[1] == 'x' || It[1] == 'X') && CharClasses.IsHexDigit(It[2]))
+		{
+			for (PartEnd = It + 2; PartEnd < End && CharClasses.IsHexDigit(*PartEnd); ++PartEnd) {}
+			Placeholder = '@';
+		}
+		else if (bWordStart && Options.bIgnoreGuids && (GuidSize = MatchGuid(It, End)) != 0)
+		{
+			PartEnd = It + GuidSize;
+			Placeholder = '%';
+		}
+		else if (Options.bIgnoreNumbers && CharClasses.IsDigit(*It))
+		{
+			for (PartEnd = It + 1; PartEnd < End && CharClasses.IsDigit(*PartEnd); ++PartEnd) {}
+			Placeholder = '#';
+		}
+		if (!Placeholder)
+		{
+			// Only numbers can start in the middle of a word
+			if (Options.bIgnoreNumbers) ++It;
+			else while (++It < End && CharClasses.IsWord(*It)) {}
+			continue;
+		}
+		Hash = MixHash(MixText(Hash, RunStart, It), 0x100 | uint8_t(Placeholder));
+		It = RunStart = PartEnd;
+	}
+	return MixText(Hash, RunStart, End);
+}
+
+/** Counts the blocks it hashes into NumHashedBlocks, and skips the rest once bCancelled is set */
+static std::vector<uint64_t> HashNormalizedBlocks(const FLineStore& Lines, const FDiffOptions& Options,
+	const std::atomic<bool>* bCancelled, std::atomic<uint64_t>* NumHashedBlocks)
+{
+	ULV_PROFILE_SCOPE("HashNormalizedLines");
+	std::vector<uint64_t> Hashes(size_t(Lines.Num()));
+	Jobs::ParallelFor(Lines.NumBlocks(), 1, [&](uint64_t FirstBlock, uint64_t EndBlock)
+	{
+		if (bCancelled && *bCancelled) return;
+		if (NumHashedBlocks) *NumHashedBlocks += EndBlock - FirstBlock;
+		const uint64_t FirstLine = FirstBlock << FLineStore::LinesPerBlockLog2;
+		const uint64_t EndLine = std::min(Lines.Num(), EndBlock << FLineStore::LinesPerBlockLog2);
+		Lines.ForEachLine(FirstLine, EndLine, [&](uint64_t LineIdx, FStringView Line)
+		{
+			Hashes[size_t(LineIdx)] = HashNormalizedLine(Line, Options);
+		});
+	});
+	return Hashes;
+}
+
+std::vector<uint64_t> HashNormalizedLines(const FLineStore& Lines, const FDiffOptions& Options)
+{
+	return HashNormalizedBlocks(Lines, Options, nullptr, nullptr);
+}
+
+namespace
+{
+
+// Slot of a line FindRarestAnchors is not pairing up
+static const uint64_t NoSlot = UINT64_MAX;
+
+/** Patience diff of lines that have been mapped to dense ids, so the counts of a range are plain arrays */
+class FPatienceDiff
+{
+public:
+	FPatienceDiff(std::vector<uint32_t>&& InLeft, std::vector<uint32_t>&& InRight, uint32_t NumIds)
+		: Left(std::move(InLeft))
+		, Right(std::move(InRight))
+		, LeftCounts(NumIds, 0)
+		, RightCounts(NumIds, 0)
+		, IdSeen(NumIds, 0)
+		, IdLeftLines(NumIds, 0)
+		, IdSlots(NumIds, NoSlot)
+	{
+	}
+
+	std::vector<FDiffRun> Run()
+	{
+		// Ranges left to diff wait on a stack rather than being recursed into, a long log can split into millions of them.
+		// Runs come out of order, and are sorted by where they start in the edit script once every range is done.
+		FRange Range{ 0, Left.size(), 0, Right.size() };
+		if (TrimRange(Range)) Stack.push_back(Range);
+		while (!Stack.empty())
+		{
+			Range = Stack.back();
+			Stack.pop_back();
+			DiffRange(Range);
+		}
+		std::sort(Runs.begin(), Runs.end(), [](const FDiffRun& A, const FDiffRun& B) { return A.LeftLine + A.RightLine < B.LeftLine + B.RightLine; });
+		size_t NumRuns = 0;
+		for (const FDiffRun& Run : Runs)
+		{
+			if (NumRuns > 0 && Runs[NumRuns - 1].Op == Run.Op) Runs[NumRuns - 1].NumLines += Run.NumLines;
+			else Runs[NumRuns++] = Run;
+		}
+		Runs.resize(NumRuns);
+		Runs.shrink_to_fit();
+		return std::move(Runs);
+	}
+
+private:
+	struct FRange
+	{
+		uint64_t Left0, Left1, Right0, Right1;
+	};
+
+	struct FAnchor
+	{
+		uint64_t LeftLine;
+		uint64_t RightLine;
+	};
+
+	void Emit(EDiffOp Op, uint64_t LeftLine, uint64_t RightLine, uint64_t NumLines)
+	{
+		if (NumLines == 0) return;
+		// Carry on from the last run when it ends where this one starts
+		if (!Runs.empty() && Runs.back().Op == Op && Runs.back().LeftLine + (Op != EDiffOp::Added ? Runs.back().NumLines : 0) == LeftLine
+			&& Runs.back().RightLine + (Op != EDiffOp::Removed ? Runs.back().NumLines : 0) == RightLine)
+		{
+			Runs.back().NumLines += NumLines;
+			return;
+		}
+		FDiffRun Run;
+		Run.Op = Op;
+		Run.LeftLine = LeftLine;
+		Run.RightLine = RightLine;
+		Run.NumLines = NumLines;
+		Runs.push_back(Run);
+	}
+
+	void EmitChange(const FRange& Range)
+	{
+		Emit(EDiffOp::Removed, Range.Left0, Range.Right0, Range.Left1 - Range.Left0);
+		Emit(EDiffOp::Added, Range.Left1, Range.Right0, Range.Right1 - Range.Right0);
+	}
+
+	/**
+	 * Emits the lines in common at either end of a range and cuts them off. Ranges left with no lines on a side,
+	 * or one line, are emitted whole straight away. Returns true if the range still has to be diffed.
+	 */
+	bool TrimRange(FRange& Range)
+	{
+		const uint64_t Left0 = Range.Left0, Right0 = Range.Right0;
+		while (Range.Left0 < Range.Left1 && Range.Right0 < Range.Right1 && Left[Range.Left0] == Right[Range.Right0]) ++Range.Left0, ++Range.Right0;
+		Emit(EDiffOp::Common, Left0, Right0, Range.Left0 - Left0);
+		const uint64_t Left1 = Range.Left1;
+		while (Range.Left0 < Range.Left1 && Range.Right0 < Range.Right1 && Left[Range.Left1 - 1] == Right[Range.Right1 - 1]) --Range.Left1, --Range.Right1;
+		Emit(EDiffOp::Common, Range.Left1, Range.Right1, Left1 - Range.Left1);
+
+		if (Range.Left0 == Range.Left1 || Range.Right0 == Range.Right1)
+		{
+			EmitChange(Range);
+			return false;
+		}
+		if (Range.Left1 - Range.Left0 == 1)
+		{
+			// Keep the one line if the other side has it
+			const uint64_t RightLine = uint64_t(std::find(Right.begin() + Range.Right0, Right.begin() + Range.Right1, Left[Range.Left0]) - Right.begin());
+			if (RightLine == Range.Right1)
+			{
+				EmitChange(Range);
+				return false;
+			}
+			Emit(EDiffOp::Added, Range.Left0, Range.Right0, RightLine - Range.Right0);
+			Emit(EDiffOp::Common, Range.Left0, RightLine, 1);
+			Emit(EDiffOp::Added, Range.Left1, RightLine + 1, Range.Right1 - RightLine - 1);
+			return false;
+		}
+		if (Range.Right1 - Range.Right0 == 1)
+		{
+			const uint64_t LeftLine = uint64_t(std::find(Left.begin() + Range.Left0, Left.begin() + Range.Left1, Right[Range.Right0]) - Left.begin());
+			if (LeftLine == Range.Left1)
+			{
+				EmitChange(Range);
+				return false;
+			}
+			Emit(EDiffOp::Removed, Range.Left0, Range.Right0, LeftLine - Range.Left0);
+			Emit(EDiffOp::Common, LeftLine, Range.Right0, 1);
+			Emit(EDiffOp::Removed, LeftLine + 1, Range.Right1, Range.Left1 - LeftLine - 1);
+			return false;
+		}
+		return true;
+	}
+
+	/** Diffs a trimmed range, whose lines in between its anchors are trimmed too and left on the stack if there is more to do */
+	void DiffRange(const FRange& Range)
+	{
+		for (uint64_t LeftLine = Range.Left0; LeftLine < Range.Left1; ++LeftLine)
+		{
+			++LeftCounts[Left[LeftLine]];
+			IdLeftLines[Left[LeftLine]] = LeftLine;
+		}
+		for (uint64_t RightLine = Range.Right0; RightLine < Range.Right1; ++RightLine)
+		{
+			++RightCounts[Right[RightLine]];
+		}
+
+		// Lines that occur once on each side are the anchors, in the order of the right side
+		Anchors.clear();
+		for (uint64_t RightLine = Range.Right0; RightLine < Range.Right1; ++RightLine)
+		{
+			const uint32_t Id = Right[RightLine];
+			if (LeftCounts[Id] == 1 && RightCounts[Id] == 1) Anchors.push_back({ IdLeftLines[Id], RightLine });
+		}
+		if (Anchors.empty()) FindRarestAnchors(Range);
+
+		for (uint64_t LeftLine = Range.Left0; LeftLine < Range.Left1; ++LeftLine)
+		{
+			LeftCounts[Left[LeftLine]] = 0;
+		}
+		for (uint64_t RightLine = Range.Right0; RightLine < Range.Right1; ++RightLine)
+		{
+			RightCounts[Right[RightLine]] = 0;
+		}
+		if (Anchors.empty())
+		{
+			EmitChange(Range);
+			return;
+		}
+
+		// The longest run of anchors in order on both sides, by patience sorting their left lines
+		PileTops.clear();
+		AnchorPrevs.resize(Anchors.size());
+		for (size_t AnchorIdx = 0; AnchorIdx < Anchors.size(); ++AnchorIdx)
+		{
+			// Anchors are mostly in order already, so try the last pile before searching
+			const uint64_t LeftLine = Anchors[AnchorIdx].LeftLine;
+			const size_t Pile = PileTops.empty() || Anchors[PileTops.back()].LeftLine < LeftLine ? PileTops.size()
+				: size_t(std::lower_bound(PileTops.begin(), PileTops.end(), LeftLine, [this](size_t TopIdx, uint64_t Line) { return Anchors[TopIdx].LeftLine < Line; }) - PileTops.begin());
+			AnchorPrevs[AnchorIdx] = Pile > 0 ? PileTops[Pile - 1] : SIZE_MAX;
+			if (Pile == PileTops.size()) PileTops.push_back(AnchorIdx);
+			else PileTops[Pile] = AnchorIdx;
+		}
+
+		// From the last anchor back, adjacent anchors are lines in common and the lines between the others are diffed the same way
+		FRange Common{ Range.Left1, Range.Left1, Range.Right1, Range.Right1 };
+		auto AddGap = [this, &Common](uint64_t Left0, uint64_t Right0)
+		{
+			Emit(EDiffOp::Common, Common.Left0, Common.Right0, Common.Left1 - Common.Left0);
+			FRange Gap{ Left0, Common.Left0, Right0, Common.Right0 };
+			if (TrimRange(Gap)) Stack.push_back(Gap);
+		};
+		for (size_t AnchorIdx = PileTops.back(); AnchorIdx != SIZE_MAX; AnchorIdx = AnchorPrevs[AnchorIdx])
+		{
+			const FAnchor& Anchor = Anchors[AnchorIdx];
+			if (Anchor.LeftLine + 1 != Common.Left0 || Anchor.RightLine + 1 != Common.Right0)
+			{
+				AddGap(Anchor.LeftLine + 1, Anchor.RightLine + 1);
+				Common = FRange{ Anchor.LeftLine + 1, Anchor.LeftLine + 1, Anchor.RightLine + 1, Anchor.RightLine + 1 };
+			}
+			--Common.Left0;
+			--Common.Right0;
+		}
+		AddGap(Range.Left0, Range.Right0);
+	}
+
+	/**
+	 * Without unique lines, pairs up the occurrences of the rarest lines on both sides, the first on the left with the first
+	 * on the right and so on, as anchors in the order of the right side. The counts of the range must be set.
+	 */
+	void FindRarestAnchors(const FRange& Range)
+	{
+		uint32_t MinCount = UINT32_MAX;
+		for (uint64_t RightLine = Range.Right0; RightLine < Range.Right1; ++RightLine)
+		{
+			const uint32_t Id = Right[RightLine];
+			if (LeftCounts[Id] > 0) MinCount = std::min(MinCount, std::min(LeftCounts[Id], RightCounts[Id]));
+		}
+		if (MinCount == UINT32_MAX) return;
+
+		// Each of those lines gets MinCount slots for the left lines of its first occurrences
+		uint64_t NumSlots = 0;
+		for (uint64_t RightLine = Range.Right0; RightLine < Range.Right1; ++RightLine)
+		{
+			const uint32_t Id = Right[RightLine];
+			if (LeftCounts[Id] == 0 || IdSlots[Id] != NoSlot || std::min(LeftCounts[Id], RightCounts[Id]) != MinCount) continue;
+			IdSlots[Id] = NumSlots;
+			NumSlots += MinCount;
+		}
+		SlotLeftLines.resize(size_t(NumSlots));
+		for (uint64_t LeftLine = Range.Left0; LeftLine < Range.Left1; ++LeftLine)
+		{
+			const uint32_t Id = Left[LeftLine];
+			if (IdSlots[Id] != NoSlot && IdSeen[Id] < MinCount) SlotLeftLines[size_t(IdSlots[Id] + IdSeen[Id]++)] = LeftLine;
+		}
+		for (uint64_t LeftLine = Range.Left0; LeftLine < Range.Left1; ++LeftLine)
+		{
+			IdSeen[Left[LeftLine]] = 0;
+		}
+		for (uint64_t RightLine = Range.Right0; RightLine < Range.Right1; ++RightLine)
+		{
+			const uint32_t Id = Right[RightLine];
+			if (IdSlots[Id] != NoSlot && IdSeen[Id] < MinCount) Anchors.push_back({ SlotLeftLines[size_t(IdSlots[Id] + IdSeen[Id]++)], RightLine });
+		}
+		for (uint64_t RightLine = Range.Right0; RightLine < Range.Right1; ++RightLine)
+		{
+			IdSeen[Right[RightLine]] = 0;
+			IdSlots[Right[RightLine]] = NoSlot;
+		}
+	}
+
+	std::vector<uint32_t> Left;
+	std::vector<uint32_t> Right;
+	// How often each line occurs in the range being diffed, zeroed again before the next one
+	std::vector<uint32_t> LeftCounts;
+	std::vector<uint32_t> RightCounts;
+	std::vector<uint32_t> IdSeen;
+	// Last left line of each line in the range, only read for lines that occur once
+	std::vector<uint64_t> IdLeftLines;
+	// First of the slots of each line paired up by FindRarestAnchors, and the left lines in them
+	std::vector<uint64_t> IdSlots;
+	std::vector<uint64_t> SlotLeftLines;
+	std::vector<FAnchor> Anchors;
+	// Last anchor of each pile, and the anchor before each one on its longest run
+	std::vector<size_t> PileTops;
+	std::vector<size_t> AnchorPrevs;
+	std::vector<FRange> Stack;
+	std::vector<FDiffRun> Runs;
+};
+
+}
+
+std::vector<FDiffRun> DiffLineHashes(const std::vector<uint64_t>& LeftHashes, const std::vector<uint64_t>& RightHashes)
+{
+	ULV_PROFILE_SCOPE("DiffLineHashes");
+
+	// Give every distinct hash a dense id, through a table that grows with the number of distinct lines
+	std::vector<uint64_t> IdHashes;
+	std::vector<uint32_t> Slots(1 << 16, UINT32_MAX);
+	auto GetId = [&](uint64_t Hash)
+	{
+		size_t SlotIdx = size_t(Hash * 0x9E3779B97F4A7C15ull >> 32) & (Slots.size() - 1);
+		for (; Slots[SlotIdx] != UINT32_MAX; SlotIdx = (SlotIdx + 1) & (Slots.size() - 1))
+		{
+			if (IdHashes[Slots[SlotIdx]] == Hash) return Slots[SlotIdx];
+		}
+		const uint32_t Id = uint32_t(IdHashes.size());
+		Slots[SlotIdx] = Id;
+		IdHashes.push_back(Hash);
+		if (IdHashes.size() * 2 > Slots.size())
+		{
+			std::vector<uint32_t>(Slots.size() * 2, UINT32_MAX).swap(Slots);
+			for (uint32_t OtherId = 0; OtherId < IdHashes.size(); ++OtherId)
+			{
+				size_t OtherSlotIdx = size_t(IdHashes[OtherId] * 0x9E3779B97F4A7C15ull >> 32) & (Slots.size() - 1);
+				while (Slots[OtherSlotIdx] != UINT32_MAX) OtherSlotIdx = (OtherSlotIdx + 1) & (Slots.size() - 1);
+				Slots[OtherSlotIdx] = OtherId;
+			}
+		}
+		return Id;
+	};
+	std::vector<uint32_t> LeftIds(LeftHashes.size());
+	for (size_t LineIdx = 0; LineIdx < LeftHashes.size(); ++LineIdx) LeftIds[LineIdx] = GetId(LeftHashes[LineIdx]);
+	std::vector<uint32_t> RightIds(RightHashes.size());
+	for (size_t LineIdx = 0; LineIdx < RightHashes.size(); ++LineIdx) RightIds[LineIdx] = GetId(RightHashes[LineIdx]);
+	const uint32_t NumIds = uint32_t(IdHashes.size());
+	std::vector<uint64_t>().swap(IdHashes);
+	std::vector<uint32_t>().swap(Slots);
+
+	return FPatienceDiff(std::move(LeftIds), std::move(RightIds), NumIds).Run();
+}
+
+struct FLogDiff::FJob
+{
+	uint64_t NumBlocks = 0;
+	std::atomic<uint64_t> NumHashedBlocks{ 0 };
+	std::atomic<bool> bCancelled{ false };
+	// Set once the job no longer reads the files
+	std::mutex Mutex;
+	std::condition_variable FilesReleased;
+	bool bFilesReleased = false;
+	// Written by the job, then only read once bDone is set
+	std::vector<FDiffRun> Runs;
+	double CompareMs = 0.0;
+	std::atomic<bool> bDone{ false };
+};
+
+void FLogDiff::Compare(const FLogFile& Left, const FLogFile& Right, const FDiffOptions& Options, std::function<void()> OnDone)
+{
+	Cancel();
+	Reset();
+	std::shared_ptr<FJob> NewJob = std::make_shared<FJob>();
+	NewJob->NumBlocks = Left.Lines.NumBlocks() + Right.Lines.NumBlocks();
+	Job = NewJob;
+	const FLineStore* LeftLines = &Left.Lines;
+	const FLineStore* RightLines = &Right.Lines;
+	Jobs::Launch([NewJob, LeftLines, RightLines, Options, OnDone]()
+	{
+		ULV_PROFILE_SCOPE("FLogDiff::Compare");
+		const auto StartTime = std::chrono::steady_clock::now();
+		const std::vector<uint64_t> LeftHashes = HashNormalizedBlocks(*LeftLines, Options, &NewJob->bCancelled, &NewJob->NumHashedBlocks);
+		const std::vector<uint64_t> RightHashes = HashNormalizedBlocks(*RightLines, Options, &NewJob->bCancelled, &NewJob->NumHashedBlocks);
+		{
+			std::lock_guard<std::mutex> Lock(NewJob->Mutex);
+			NewJob->bFilesReleased = true;
+			NewJob->FilesReleased.notify_all();
+		}
+		if (NewJob->bCancelled) return;
+
+		NewJob->Runs = DiffLineHashes(LeftHashes, RightHashes);
+		NewJob->CompareMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+		NewJob->bDone = true;
+		if (OnDone) OnDone();
+	});
+}
+
+void FLogDiff::Cancel()
+{
+	if (!Job) return;
+	Job->bCancelled = true;
+	std::unique_lock<std::mutex> Lock(Job->Mutex);
+	Job->FilesReleased.wait(Lock, [this]() { return Job->bFilesReleased; });
+	Lock.unlock();
+	Job.reset();
+}
+
+void FLogDiff::Poll()
+{
+	if (!Job || !Job->bDone) return;
+	Reset();
+	Runs = std::move(Job->Runs);
+	for (const FDiffRun& Run : Runs)
+	{
+		NumOpLines[(int)Run.Op] += Run.NumLines;
+	}
+	CompareMs = Job->CompareMs;
+	Job.reset();
+}
+
+bool FLogDiff::IsRunning() const
+{
+	return Job != nullptr;
+}
+
+float FLogDiff::GetProgress() const
+{
+	return !Job || Job->NumBlocks == 0 ? 1.0f : float(Job->NumHashedBlocks) / float(Job->NumBlocks);
+}
+
+void FLogDiff::Reset()
+{
+	Runs.clear();
+	std::fill(NumOpLines, NumOpLines + (int)EDiffOp::MAX, 0);
+	CompareMs = 0.0;
+	LeftFile = RightFile = nullptr;
+	RunFirstRows.clear();
+	RunFirstDisplayRows.clear();
+}
+
+void FLogDiff::UpdateRows(const FLogFile& Left, const FLogFile& Right, uint32_t ShownOpsMask)
+{
+	const FDisplayLines& LeftDisplayLines = Left.GetDisplayLines();
+	const FDisplayLines& RightDisplayLines = Right.GetDisplayLines();
+	if (&Left == LeftFile && &Right == RightFile && ShownOpsMask == ShownOps
+		&& Left.GetDisplayLinesVersion() == LeftVersion && Right.GetDisplayLinesVersion() == RightVersion)
+	{
+		return;
+	}
+	ULV_PROFILE_SCOPE("FLogDiff::UpdateRows");
+	LeftFile = &Left;
+	RightFile = &Right;
+	ShownOps = ShownOpsMask;
+	LeftVersion = Left.GetDisplayLinesVersion();
+	RightVersion = Right.GetDisplayLinesVersion();
+
+	// A run shows the lines of its file that pass the filters, which are a range of the file's display rows
+	RunFirstRows.resize(Runs.size() + 1);
+	RunFirstDisplayRows.resize(Runs.size());
+	uint64_t NumRows = 0;
+	for (size_t RunIdx = 0; RunIdx < Runs.size(); ++RunIdx)
+	{
+		const FDiffRun& Run = Runs[RunIdx];
+		RunFirstRows[RunIdx] = NumRows;
+		RunFirstDisplayRows[RunIdx] = 0;
+		if (!(ShownOps & (1u << (int)Run.Op))) continue;
+
+		const FDisplayLines& DisplayLines = Run.Op == EDiffOp::Added ? RightDisplayLines : LeftDisplayLines;
+		const uint64_t FirstLine = Run.Op == EDiffOp::Added ? Run.RightLine : Run.LeftLine;
+		RunFirstDisplayRows[RunIdx] = DisplayLines.FindRow(FirstLine);
+		NumRows += DisplayLines.FindRow(FirstLine + Run.NumLines) - RunFirstDisplayRows[RunIdx];
+	}
+	RunFirstRows.back() = NumRows;
+}
+
+FDiffRow FLogDiff::operator[](uint64_t Row) const
+{
+	// The last run starting at or before the row, runs without rows start at the same row as the next one
+	const size_t RunIdx = size_t(std::upper_bound(RunFirstRows.begin(), RunFirstRows.end() - 1, Row) - RunFirstRows.begin()) - 1;
+	const FDiffRun& Run = Runs[RunIdx];
+	const FLogFile& File = Run.Op == EDiffOp::Added ? *RightFile : *LeftFile;
+
+	FDiffRow DiffRow;
+	DiffRow.Op = Run.Op;
+	DiffRow.LineIdx = File.GetDisplayLines()[RunFirstDisplayRows[RunIdx] + Row - RunFirstRows[RunIdx]];
+	return DiffRow;
+}
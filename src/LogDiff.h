@@ -0,0 +1,116 @@
+#pragma once
+
+#include "LogFile.h"
+#include "StringView.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+enum class EDiffOp : uint8_t
+{
+	Common = 0,
+	Removed,
+	Added,
+	MAX
+};
+
+extern const char* EDiffOpStrings[(int)EDiffOp::MAX + 1];
+
+/** What to leave out of lines before comparing them. The [timestamp][frame] prefix is always left out. */
+struct FDiffOptions
+{
+	// On by default, as runs of the same build rarely agree on ids, counts and durations
+	bool bIgnoreNumbers = true;
+	// 32 hex digits, with or without the dashes
+	bool bIgnoreGuids = true;
+	// 0x followed by hex digits
+	bool bIgnoreAddresses = true;
+};
+
+/** Consecutive lines with the same op. Removed lines are in the left file, added lines in the right one, common lines in both. */
+struct FDiffRun
+{
+	EDiffOp Op = EDiffOp::Common;
+	uint64_t LeftLine = 0;
+	uint64_t RightLine = 0;
+	uint64_t NumLines = 0;
+};
+
+/** Hash of a line after normalizing it, lines that only differ in what the options leave out hash the same */
+uint64_t HashNormalizedLine(FStringView Line, const FDiffOptions& Options);
+
+/** Normalized hash of every line, worked out on all workers */
+std::vector<uint64_t> HashNormalizedLines(const FLineStore& Lines, const FDiffOptions& Options);
+
+/**
+ * Edit script from one sequence of line hashes to another, as a patience diff.
+ * Lines that occur once on each side anchor the alignment, the longest run of anchors in the same order on both sides is kept,
+ * and the gaps between them are diffed the same way. Gaps without such lines anchor on their rarest common lines instead,
+ * which lines up the distinctive lines of two runs rather than the repeated ones. O(n log n) for n lines in most logs.
+ */
+std::vector<FDiffRun> DiffLineHashes(const std::vector<uint64_t>& LeftHashes, const std::vector<uint64_t>& RightHashes);
+
+struct FDiffRow
+{
+	EDiffOp Op = EDiffOp::Common;
+	// Line of the right file for added rows, of the left file otherwise
+	uint64_t LineIdx = 0;
+};
+
+/** Diff of two log files, shown as the rows of the chosen ops whose lines pass the filters of their file */
+class FLogDiff
+{
+public:
+	~FLogDiff() { Cancel(); }
+
+	/**
+	 * Cancels any compare in progress and starts a new one on the workers, OnDone is called from a worker once it finishes.
+	 * The files must stay put until it finishes or is cancelled, and Poll swaps the results in.
+	 */
+	void Compare(const FLogFile& Left, const FLogFile& Right, const FDiffOptions& Options, std::function<void()> OnDone);
+
+	/** Stops the compare and waits until it no longer reads the files */
+	void Cancel();
+
+	/** Swaps in the results of a finished compare, call on the thread that uses the rows */
+	void Poll();
+
+	/** True until Poll swaps the results in */
+	bool IsRunning() const;
+	/** Fraction of the lines hashed, the diff itself runs once they all are */
+	float GetProgress() const;
+
+	void Reset();
+	bool IsEmpty() const { return Runs.empty(); }
+
+	/** Call before using the rows each frame, the files must stay put until the next call */
+	void UpdateRows(const FLogFile& Left, const FLogFile& Right, uint32_t ShownOpsMask);
+
+	uint64_t Num() const { return RunFirstRows.empty() ? 0 : RunFirstRows.back(); }
+
+	/** O(log r + log n) for r runs of n lines */
+	FDiffRow operator[](uint64_t Row) const;
+
+	uint64_t GetNumLines(EDiffOp Op) const { return NumOpLines[(int)Op]; }
+	double GetCompareMs() const { return CompareMs; }
+
+private:
+	struct FJob;
+	std::shared_ptr<FJob> Job;
+
+	std::vector<FDiffRun> Runs;
+	uint64_t NumOpLines[(int)EDiffOp::MAX] = {};
+	double CompareMs = 0.0;
+
+	const FLogFile* LeftFile = nullptr;
+	const FLogFile* RightFile = nullptr;
+	uint32_t ShownOps = 0;
+	uint64_t LeftVersion = 0;
+	uint64_t RightVersion = 0;
+	// Rows before each run and in total, and the display row of the first line of each run in its file
+	std::vector<uint64_t> RunFirstRows;
+	std::vector<uint64_t> RunFirstDisplayRows;
+};
@@ -0,0 +1,300 @@
+#include "LogFields.h"
+#include "Jobs.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+const char* EFieldTypeStrings[(int)EFieldType::MAX + 1] =
+{
+	"Number",
+	"Integer"
+};
+
+/** Parses [-]digits[.digits] at the start of Text, the fraction only for numbers */
+static bool ParseValue(const char* Text, const char* End, EFieldType Type, double& OutValue)
+{
+	const bool bNegative = Text < End && *Text == '-';
+	Text += bNegative;
+	if (Text == End || *Text < '0' || *Text > '9') return false;
+
+	double Value = 0.0;
+	for (; Text < End && *Text >= '0' && *Text <= '9'; ++Text)
+	{
+		Value = Value * 10.0 + (*Text - '0');
+	}
+	if (Type == EFieldType::Number && Text + 1 < End && *Text == '.' && Text[1] >= '0' && Text[1] <= '9')
+	{
+		double Scale = 0.1;
+		for (++Text; Text < End && *Text >= '0' && *Text <= '9'; ++Text, Scale *= 0.1)
+		{
+			Value += (*Text - '0') * Scale;
+		}
+	}
+	OutValue = bNegative ? -Value : Value;
+	return true;
+}
+
+namespace
+{
+	struct FEntry
+	{
+		uint64_t Key;
+		uint64_t Idx;
+		bool operator<(const FEntry& Other) const { return Key < Other.Key; }
+	};
+
+	/** Maps a value to an unsigned key in the same order, by flipping the sign bit of positives and every bit of negatives */
+	uint64_t GetSortKey(double Value)
+	{
+		uint64_t Bits;
+		memcpy(&Bits, &Value, sizeof(Bits));
+		return (Bits >> 63) ? ~Bits : Bits | (uint64_t(1) << 63);
+	}
+
+	/** Stable LSD radix sort by 11 bit digits, skipping digits all the keys share, which leaves equal keys in index order */
+	void RadixSort(FEntry* Entries, FEntry* Scratch, size_t Num)
+	{
+		const int DigitBits = 11;
+		const int NumDigits = (64 + DigitBits - 1) / DigitBits;
+		const size_t NumDigitValues = size_t(1) << DigitBits;
+		if (Num == 0) return;
+
+		// Every digit is counted in one pass over the keys
+		std::vector<size_t> Counts(NumDigits * NumDigitValues);
+		for (size_t Idx = 0; Idx < Num; ++Idx)
+		{
+			for (int Digit = 0; Digit < NumDigits; ++Digit)
+			{
+				++Counts[Digit * NumDigitValues + ((Entries[Idx].Key >> (Digit * DigitBits)) & (NumDigitValues - 1))];
+			}
+		}
+		FEntry* From = Entries;
+		FEntry* To = Scratch;
+		for (int Digit = 0; Digit < NumDigits; ++Digit)
+		{
+			const int Shift = Digit * DigitBits;
+			size_t* DigitCounts = Counts.data() + Digit * NumDigitValues;
+			if (DigitCounts[(From[0].Key >> Shift) & (NumDigitValues - 1)] == Num) continue;
+			size_t Offset = 0;
+			for (size_t Value = 0; Value < NumDigitValues; ++Value)
+			{
+				const size_t Count = DigitCounts[Value];
+				DigitCounts[Value] = Offset;
+				Offset += Count;
+			}
+			for (size_t Idx = 0; Idx < Num; ++Idx)
+			{
+				To[DigitCounts[(From[Idx].Key >> Shift) & (NumDigitValues - 1)]++] = From[Idx];
+			}
+			std::swap(From, To);
+		}
+		if (From != Entries) std::copy(From, From + Num, Entries);
+	}
+}
+
+bool ExtractField(const FFieldRule& Rule, FStringView Line, double& OutValue)
+{
+	const FStringView Anchor(Rule.Anchor.data(), Rule.Anchor.size());
+	if (Anchor.empty()) return false;
+	for (size_t Pos = Line.Find(Anchor); Pos != FStringView::npos; Pos = Line.Find(Anchor, Pos + 1))
+	{
+		const char* Text = Line.Data + Pos + Anchor.Size;
+		while (Text < Line.end() && *Text == ' ') ++Text;
+		if (ParseValue(Text, Line.end(), Rule.Type, OutValue)) return true;
+	}
+	return false;
+}
+
+void FFieldColumn::Extract(const FLineStore& Lines, const FDisplayLines& DisplayLines, const FLineTimes& LineTimes, const FFieldRule& InRule,
+	const std::atomic<bool>* bCancelled)
+{
+	ULV_PROFILE_SCOPE("FFieldColumn::Extract");
+	const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+	Rule = InRule;
+	auto IsCancelled = [bCancelled]() { return bCancelled && *bCancelled; };
+
+	// Each container of display lines is extracted on its own, then the chunks are joined in order
+	struct FChunk
+	{
+		std::vector<uint64_t> LineIdxs;
+		std::vector<double> Values;
+	};
+	std::vector<FChunk> Chunks(DisplayLines.NumContainers());
+	Jobs::ParallelFor(Chunks.size(), 1, [&](uint64_t BeginChunk, uint64_t EndChunk)
+	{
+		std::vector<uint64_t> ContainerLines;
+		for (uint64_t ChunkIdx = BeginChunk; ChunkIdx < EndChunk && !IsCancelled(); ++ChunkIdx)
+		{
+			FChunk& Chunk = Chunks[size_t(ChunkIdx)];
+			ContainerLines.clear();
+			DisplayLines.GetContainerLines(size_t(ChunkIdx), ContainerLines);
+			FBlockText Text;
+			size_t TextBlockIdx = SIZE_MAX;
+			for (uint64_t LineIdx : ContainerLines)
+			{
+				const size_t BlockIdx = size_t(LineIdx >> FLineStore::LinesPerBlockLog2);
+				if (BlockIdx != TextBlockIdx)
+				{
+					Text = Lines.PinBlock(BlockIdx);
+					TextBlockIdx = BlockIdx;
+				}
+				double Value;
+				if (ExtractField(Rule, Lines.GetLineInBlock(*Text, LineIdx), Value))
+				{
+					Chunk.LineIdxs.push_back(LineIdx);
+					Chunk.Values.push_back(Value);
+				}
+			}
+		}
+	});
+	if (IsCancelled()) return;
+
+	size_t NumValues = 0;
+	for (const FChunk& Chunk : Chunks)
+	{
+		NumValues += Chunk.Values.size();
+	}
+	LineIdxs.clear();
+	Values.clear();
+	LineIdxs.reserve(NumValues);
+	Values.reserve(NumValues);
+	for (FChunk& Chunk : Chunks)
+	{
+		LineIdxs.insert(LineIdxs.end(), Chunk.LineIdxs.begin(), Chunk.LineIdxs.end());
+		Values.insert(Values.end(), Chunk.Values.begin(), Chunk.Values.end());
+		Chunk = FChunk();
+	}
+	ExtractMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+	ULV_PROFILE_WORK(DisplayLines.Num(), 0);
+
+	// Radix sort (value, index) pairs in a slice per worker, then merge the slices pairwise until one is left
+	const std::chrono::steady_clock::time_point SortStartTime = std::chrono::steady_clock::now();
+	std::vector<FEntry> Entries(NumValues);
+	for (size_t Idx = 0; Idx < NumValues; ++Idx)
+	{
+		Entries[Idx] = FEntry{ GetSortKey(Values[Idx]), Idx };
+	}
+	std::vector<FEntry> Merged(NumValues);
+	const size_t NumSlices = std::min<size_t>(size_t(Jobs::GetNumWorkers()) + 1, std::max<size_t>(NumValues / 65536, 1));
+	const size_t SliceSize = (NumValues + NumSlices - 1) / NumSlices;
+	Jobs::ParallelFor(NumSlices, 1, [&](uint64_t BeginSlice, uint64_t EndSlice)
+	{
+		for (uint64_t Slice = BeginSlice; Slice < EndSlice; ++Slice)
+		{
+			const size_t First = std::min(NumValues, size_t(Slice) * SliceSize);
+			const size_t End = std::min(NumValues, size_t(Slice + 1) * SliceSize);
+			RadixSort(Entries.data() + First, Merged.data() + First, End - First);
+		}
+	});
+	for (size_t SortedSize = SliceSize; SortedSize < NumValues; SortedSize *= 2)
+	{
+		const size_t NumMerges = (NumValues + 2 * SortedSize - 1) / (2 * SortedSize);
+		Jobs::ParallelFor(NumMerges, 1, [&](uint64_t BeginMerge, uint64_t EndMerge)
+		{
+			for (uint64_t Merge = BeginMerge; Merge < EndMerge; ++Merge)
+			{
+				const size_t First = size_t(Merge) * 2 * SortedSize;
+				const size_t Middle = std::min(NumValues, First + SortedSize);
+				const size_t End = std::min(NumValues, First + 2 * SortedSize);
+				std::merge(Entries.begin() + First, Entries.begin() + Middle, Entries.begin() + Middle, Entries.begin() + End, Merged.begin() + First);
+			}
+		});
+		Entries.swap(Merged);
+	}
+	std::vector<FEntry>().swap(Merged);
+	SortedIdxs.resize(NumValues);
+	for (size_t Rank = 0; Rank < NumValues; ++Rank)
+	{
+		SortedIdxs[Rank] = Entries[Rank].Idx;
+	}
+	std::vector<FEntry>().swap(Entries);
+	SortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - SortStartTime).count();
+
+	Stats = FFieldStats();
+	Histogram.assign(NumHistogramBins, 0.0f);
+	TimeMeans.assign(NumTimeBuckets, 0.0f);
+	if (NumValues == 0) return;
+
+	auto Percentile = [&](double Fraction) { return Values[SortedIdxs[std::min(NumValues - 1, size_t(Fraction * NumValues))]]; };
+	double Sum = 0.0;
+	for (double Value : Values)
+	{
+		Sum += Value;
+	}
+	Stats.Count = NumValues;
+	Stats.Min = Values[SortedIdxs.front()];
+	Stats.Max = Values[SortedIdxs.back()];
+	Stats.Mean = Sum / NumValues;
+	Stats.P50 = Percentile(0.50);
+	Stats.P95 = Percentile(0.95);
+	Stats.P99 = Percentile(0.99);
+
+	const double BinScale = Stats.Max > Stats.Min ? NumHistogramBins / (Stats.Max - Stats.Min) : 0.0;
+	for (double Value : Values)
+	{
+		Histogram[std::min(NumHistogramBins - 1, int((Value - Stats.Min) * BinScale))] += 1.0f;
+	}
+
+	// Over time if the log has times, otherwise over its lines
+	auto GetPosition = [&](size_t Idx) { return LineTimes.HasTimes() ? double(LineTimes[LineIdxs[Idx]]) : double(LineIdxs[Idx]); };
+	const double FirstPosition = GetPosition(0);
+	const double Span = GetPosition(NumValues - 1) - FirstPosition;
+	std::vector<double> BucketSums(NumTimeBuckets, 0.0);
+	std::vector<uint64_t> BucketCounts(NumTimeBuckets, 0);
+	for (size_t Idx = 0; Idx < NumValues; ++Idx)
+	{
+		const int Bucket = Span > 0.0 ? std::min(NumTimeBuckets - 1, int((GetPosition(Idx) - FirstPosition) / Span * NumTimeBuckets)) : 0;
+		BucketSums[Bucket] += Values[Idx];
+		++BucketCounts[Bucket];
+	}
+	for (int Bucket = 0; Bucket < NumTimeBuckets; ++Bucket)
+	{
+		TimeMeans[Bucket] = BucketCounts[Bucket] ? float(BucketSums[Bucket] / BucketCounts[Bucket]) : Bucket > 0 ? TimeMeans[Bucket - 1] : float(Stats.Mean);
+	}
+}
+
+uint64_t FFieldColumn::GetAllocatedBytes() const
+{
+	return (LineIdxs.capacity() + SortedIdxs.capacity()) * sizeof(uint64_t) + Values.capacity() * sizeof(double)
+		+ (Histogram.capacity() + TimeMeans.capacity()) * sizeof(float);
+}
+
+void FFieldExtraction::Start(const FLineStore& Lines, std::shared_ptr<const FDisplayLines> DisplayLines, const FLineTimes& LineTimes, const FFieldRule& Rule,
+	std::function<void()> OnDone)
+{
+	Cancel();
+	std::shared_ptr<FJob> NewJob = std::make_shared<FJob>();
+	Job = NewJob;
+	const FLineStore* JobLines = &Lines;
+	const FLineTimes* JobLineTimes = &LineTimes;
+	Jobs::Launch([NewJob, JobLines, DisplayLines, JobLineTimes, Rule, OnDone]()
+	{
+		NewJob->Column.Extract(*JobLines, *DisplayLines, *JobLineTimes, Rule, &NewJob->bCancelled);
+		std::lock_guard<std::mutex> Lock(NewJob->Mutex);
+		NewJob->bStopped = true;
+		NewJob->Stopped.notify_all();
+		if (NewJob->bCancelled) return;
+		NewJob->bDone = true;
+		if (OnDone) OnDone();
+	});
+}
+
+void FFieldExtraction::Cancel()
+{
+	if (!Job) return;
+	Job->bCancelled = true;
+	std::unique_lock<std::mutex> Lock(Job->Mutex);
+	Job->Stopped.wait(Lock, [this]() { return Job->bStopped; });
+	Lock.unlock();
+	Job.reset();
+}
+
+bool FFieldExtraction::Poll()
+{
+	if (!Job || !Job->bDone) return false;
+	Column = std::move(Job->Column);
+	Job.reset();
+	return true;
+}
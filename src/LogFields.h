@@ -0,0 +1,130 @@
+#pragma once
+
+#include "DisplayLines.h"
+#include "LineStore.h"
+#include "LineTimes.h"
+#include "StringView.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class EFieldType : int
+{
+	Number = 0,
+	Integer,
+	MAX
+};
+
+extern const char* EFieldTypeStrings[(int)EFieldType::MAX + 1];
+
+/** A number in a line, found as the value that follows a literal anchor such as "took " or "Mem: " */
+struct FFieldRule
+{
+	std::string Anchor;
+	EFieldType Type = EFieldType::Number;
+};
+
+struct FFieldStats
+{
+	uint64_t Count = 0;
+	double Min = 0.0;
+	double Max = 0.0;
+	double Mean = 0.0;
+	double P50 = 0.0;
+	double P95 = 0.0;
+	double P99 = 0.0;
+};
+
+/** Parses the value after the first occurrence of the anchor that is followed by one, returns false if there is none */
+bool ExtractField(const FFieldRule& Rule, FStringView Line, double& OutValue);
+
+/**
+ * Values of a field in the lines of a display set, as columns of the lines they came from and their values.
+ * The display set is split by its containers and extracted on the workers, then indexed by value with a parallel sort,
+ * which the percentiles, the histogram and the lines by value are all read from.
+ */
+class FFieldColumn
+{
+public:
+	static const int NumHistogramBins = 64;
+	static const int NumTimeBuckets = 256;
+
+	/** Stops early once bCancelled is set, leaving the column half extracted, to be thrown away */
+	void Extract(const FLineStore& Lines, const FDisplayLines& DisplayLines, const FLineTimes& LineTimes, const FFieldRule& Rule,
+		const std::atomic<bool>* bCancelled = nullptr);
+
+	const FFieldRule& GetRule() const { return Rule; }
+	uint64_t Num() const { return LineIdxs.size(); }
+	uint64_t GetLine(uint64_t Idx) const { return LineIdxs[size_t(Idx)]; }
+	double GetValue(uint64_t Idx) const { return Values[size_t(Idx)]; }
+	/** Index of the value ranked Rank from the smallest */
+	uint64_t GetSortedIdx(uint64_t Rank) const { return SortedIdxs[size_t(Rank)]; }
+
+	const FFieldStats& GetStats() const { return Stats; }
+	/** Values in each of NumHistogramBins even steps from the smallest to the largest */
+	const std::vector<float>& GetHistogram() const { return Histogram; }
+	/** Mean value in each of NumTimeBuckets even steps of time from the first value to the last, empty steps repeat the one before */
+	const std::vector<float>& GetTimeMeans() const { return TimeMeans; }
+
+	double GetExtractMs() const { return ExtractMs; }
+	double GetSortMs() const { return SortMs; }
+	uint64_t GetAllocatedBytes() const;
+
+private:
+	FFieldRule Rule;
+	std::vector<uint64_t> LineIdxs;
+	std::vector<double> Values;
+	std::vector<uint64_t> SortedIdxs;
+	FFieldStats Stats;
+	std::vector<float> Histogram;
+	std::vector<float> TimeMeans;
+	double ExtractMs = 0.0;
+	double SortMs = 0.0;
+};
+
+/** Extracts a column on a worker while the last one extracted is still shown, and swaps it in once it is done */
+class FFieldExtraction
+{
+public:
+	~FFieldExtraction() { Cancel(); }
+
+	/**
+	 * Cancels any extraction in progress and starts a new one, OnDone is called from the worker once it is done.
+	 * The lines and times must stay put until it is done or cancelled, the display lines are shared with the worker.
+	 */
+	void Start(const FLineStore& Lines, std::shared_ptr<const FDisplayLines> DisplayLines, const FLineTimes& LineTimes, const FFieldRule& Rule,
+		std::function<void()> OnDone);
+
+	/** Stops the extraction and waits until the worker no longer reads the lines, the column shown is kept */
+	void Cancel();
+
+	/** Swaps in the column once it is extracted, returns true if it did */
+	bool Poll();
+
+	/** True until Poll swaps the column in */
+	bool IsRunning() const { return Job != nullptr; }
+
+	/** The last column swapped in */
+	const FFieldColumn& GetColumn() const { return Column; }
+
+private:
+	struct FJob
+	{
+		FFieldColumn Column;
+		std::atomic<bool> bCancelled{ false };
+		std::atomic<bool> bDone{ false };
+		// Set once the worker no longer reads the lines
+		std::mutex Mutex;
+		std::condition_variable Stopped;
+		bool bStopped = false;
+	};
+
+	std::shared_ptr<FJob> Job;
+	FFieldColumn Column;
+};
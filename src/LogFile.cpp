@@ -0,0 +1,707 @@
+#include "LogFile.h"
+#include "Jobs.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+const char* EFilterTypeStrings[(int)EFilterType::MAX + 1] =
+{
+	"Text Include",
+	"Text Exclude",
+	"Log Category",
+	"Template Include",
+	"Template Exclude",
+	"Time Range",
+	"Frame Range",
+	"Region"
+};
+
+const char* ELogVerbosityStrings[(int)ELogVerbosity::MAX + 1] =
+{
+	"Off",
+	"Error",
+	"Warning",
+	"Log",
+	"Verbose",
+	"VeryVerbose"
+};
+
+int FindPos(FStringView A, int AStartPos, FStringView B)
+{
+	return int(A.Find(B, AStartPos));
+}
+
+bool StartsWith(FStringView A, int AStartPos, FStringView B)
+{
+	return A.StartsWith(AStartPos, B);
+}
+
+bool Contains(FStringView Haystack, FStringView Needle)
+{
+	return Haystack.Find(Needle) != FStringView::npos;
+}
+
+template<class TPred>
+bool ContainsByPred(FStringView Haystack, FStringView Needle, TPred Pred)
+{
+	return std::search(Haystack.begin(), Haystack.end(), Needle.begin(), Needle.end(), Pred) != Haystack.end();
+}
+
+bool DoFilterLine(const std::vector<FLineFilter>& Filters, FStringView Line, uint32_t TemplateId, FLineContext* OutContext, uint64_t* InOutNumFiltersEvaluated)
+{
+	auto SearchPredCaseInvariant = [](char ch1, char ch2) { return toupper(ch1) == toupper(ch2); };
+
+	bool bIncluded = false;
+	bool bExcluded = false;
+	bool bIncludeFilterEncountered = false;
+	int NumFiltersEvaluated = 0;
+	FLineContext Context;
+	auto AddContext = [&Context](const FLineFilter& Filter)
+	{
+		Context.Before = uint16_t(std::max<int>(Context.Before, std::min(Filter.ContextBefore, MaxContextLines)));
+		Context.After = uint16_t(std::max<int>(Context.After, std::min(Filter.ContextAfter, MaxContextLines)));
+	};
+
+	for (const FLineFilter& Filter : Filters)
+	{
+		if (bExcluded) break;
+		if (!Filter.bEnable) continue;
+		++NumFiltersEvaluated;
+
+		if (Filter.Type == EFilterType::TextInclude || Filter.Type == EFilterType::TextExclude)
+		{
+			const auto& FilterData = Filter.TextData;
+			bool bContains = FilterData.Token.empty() ? false :
+				FilterData.bCaseMatch ? Contains(Line, FilterData.Token) : ContainsByPred(Line, FilterData.Token, SearchPredCaseInvariant);
+
+			if (Filter.Type == EFilterType::TextInclude)
+			{
+				bIncludeFilterEncountered = true;
+				bIncluded |= bContains;
+				if (bContains) AddContext(Filter);
+			}
+			else if (Filter.Type == EFilterType::TextExclude)
+			{
+				bExcluded |= bContains;
+			}
+		}
+		else if (Filter.Type == EFilterType::LogCategory)
+		{
+			const auto& FilterData = Filter.LogCategoryData;
+
+			if (FilterData.Verbosity != ELogVerbosity::VeryVerbose
+				&& !FilterData.Category.empty()
+				&& Contains(Line, FilterData.Category + ":"))
+			{
+				switch (FilterData.Verbosity)
+				{
+				case ELogVerbosity::Off:
+					bExcluded = true;
+					break;
+				case ELogVerbosity::Error:
+					bExcluded = !Contains(Line, FilterData.Category + ": Error:");
+					break;
+				case ELogVerbosity::Warning:
+					bExcluded = !(Contains(Line, FilterData.Category + ": Error:")
+						|| Contains(Line, FilterData.Category + ": Warning:"));
+					break;
+				case ELogVerbosity::Log:
+					bExcluded = Contains(Line, FilterData.Category + ": VeryVerbose:")
+						|| Contains(Line, FilterData.Category + ": Verbose:");
+					break;
+				case ELogVerbosity::Verbose:
+					bExcluded = Contains(Line, FilterData.Category + ": VeryVerbose:");
+					break;
+				}
+			}
+		}
+		else if (Filter.Type == EFilterType::TemplateInclude || Filter.Type == EFilterType::TemplateExclude)
+		{
+			const bool bMatches = TemplateId != FLogTemplates::NoTemplate && TemplateId == Filter.TemplateData.TemplateId;
+			if (Filter.Type == EFilterType::TemplateInclude)
+			{
+				bIncludeFilterEncountered = true;
+				bIncluded |= bMatches;
+				if (bMatches) AddContext(Filter);
+			}
+			else
+			{
+				bExcluded |= bMatches;
+			}
+		}
+		else if (Filter.Type == EFilterType::TimeRange || Filter.Type == EFilterType::FrameRange || Filter.Type == EFilterType::Region)
+		{
+			// Lines are cut down to the range before they get here
+			--NumFiltersEvaluated;
+		}
+		else assert(false);
+	}
+
+	if (InOutNumFiltersEvaluated) *InOutNumFiltersEvaluated += NumFiltersEvaluated;
+	if (OutContext) *OutContext = Context;
+	return !bExcluded && (bIncluded || !bIncludeFilterEncountered);
+}
+
+bool HasContextLines(const std::vector<FLineFilter>& Filters)
+{
+	for (const FLineFilter& Filter : Filters)
+	{
+		const bool bInclude = Filter.Type == EFilterType::TextInclude || Filter.Type == EFilterType::TemplateInclude;
+		if (Filter.bEnable && bInclude && (Filter.ContextBefore > 0 || Filter.ContextAfter > 0)) return true;
+	}
+	return false;
+}
+
+FLogLineMetadata::FLogLineMetadata(FStringView Text)
+{
+	if (Text.Size > FrameEndIdx && Text[TimestampStartIdx] == '[' && Text[TimestampEndIdx] == ']' && Text[FrameStartIdx] == '[' && Text[FrameEndIdx] == ']') bContainsTimestamp = true;
+	
+	LineType = ParseLineType(Text, bContainsTimestamp ? FrameEndIdx + 1 : 0);
+}
+
+ELogLineType FLogLineMetadata::ParseLineType(FStringView Text, int PostTimestampPos)
+{
+	if (StartsWith(Text, PostTimestampPos, "Log"))
+	{
+		const int PosOfColon = FindPos(Text, PostTimestampPos, ": ");
+		if (PosOfColon > 0)
+		{
+			const int PosOfLogLevel = PosOfColon + 2;
+			if (StartsWith(Text, PosOfLogLevel, "Warning: ")) return ELogLineType::Warning;
+			else if (StartsWith(Text, PosOfLogLevel, "Error: ")) return ELogLineType::Error;
+		}
+	}
+	return ELogLineType::Normal;
+}
+
+/**
+ * True if the filters give the same result for a line and for its body without the [timestamp][frame] prefix.
+ * A token can only match across the prefix through its closing ']', or inside it if it is made of prefix characters.
+ */
+static bool CanFilterLineBodies(const std::vector<FLineFilter>& Filters)
+{
+	auto IsBodyOnly = [](const std::string& Token)
+	{
+		return Token.find(']') == std::string::npos && Token.find_first_not_of("[0123456789.-: ") != std::string::npos;
+	};
+	for (const FLineFilter& Filter : Filters)
+	{
+		if (!Filter.bEnable) continue;
+		if (Filter.Type == EFilterType::LogCategory)
+		{
+			if (!Filter.LogCategoryData.Category.empty() && !IsBodyOnly(Filter.LogCategoryData.Category)) return false;
+		}
+		else if (Filter.Type == EFilterType::TemplateInclude || Filter.Type == EFilterType::TemplateExclude)
+		{
+			// Templates are mined from the body
+			continue;
+		}
+		else if (Filter.Type == EFilterType::TimeRange || Filter.Type == EFilterType::FrameRange || Filter.Type == EFilterType::Region) continue;
+		else if (!Filter.TextData.Token.empty() && !IsBodyOnly(Filter.TextData.Token)) return false;
+	}
+	return true;
+}
+
+/**
+ * Whether the template filters drop the lines of each template whatever their text, with NoTemplate last. They do if a Template Exclude
+ * matches, or if every enabled include filter is a Template Include and none of them matches. Empty if no template filter is enabled.
+ */
+static std::vector<bool> GetDroppedTemplates(const std::vector<FLineFilter>& Filters, uint32_t NumTemplates)
+{
+	bool bTemplateFilters = false;
+	bool bTemplateIncludes = false;
+	bool bTextIncludes = false;
+	for (const FLineFilter& Filter : Filters)
+	{
+		if (!Filter.bEnable) continue;
+		bTemplateFilters |= Filter.Type == EFilterType::TemplateInclude || Filter.Type == EFilterType::TemplateExclude;
+		bTemplateIncludes |= Filter.Type == EFilterType::TemplateInclude;
+		bTextIncludes |= Filter.Type == EFilterType::TextInclude;
+	}
+	if (!bTemplateFilters) return std::vector<bool>();
+
+	const bool bOnlyTemplateIncludes = bTemplateIncludes && !bTextIncludes;
+	std::vector<bool> bDropped(NumTemplates + 1, bOnlyTemplateIncludes);
+	for (const FLineFilter& Filter : Filters)
+	{
+		const uint32_t TemplateId = Filter.TemplateData.TemplateId;
+		if (!Filter.bEnable || TemplateId >= NumTemplates) continue;
+		if (Filter.Type == EFilterType::TemplateInclude && bOnlyTemplateIncludes) bDropped[TemplateId] = false;
+	}
+	for (const FLineFilter& Filter : Filters)
+	{
+		const uint32_t TemplateId = Filter.TemplateData.TemplateId;
+		if (!Filter.bEnable || TemplateId >= NumTemplates) continue;
+		if (Filter.Type == EFilterType::TemplateExclude) bDropped[TemplateId] = true;
+	}
+	return bDropped;
+}
+
+FLogFile::FLogFile(const std::string& FilePath, FLineStore&& InLines, std::vector<FLogLineMetadata>&& CachedLineMetadatas, FLineTimes&& CachedLineTimes)
+	: FilePath(FilePath)
+	, Lines(std::move(InLines))
+	, LineMetadatas(std::move(CachedLineMetadatas))
+	, LineTimes(std::move(CachedLineTimes))
+{
+	ULV_PROFILE_SCOPE("FLogFile metadata");
+	const uint64_t FirstLine = LineMetadatas.size();
+	LineMetadatas.reserve(Lines.Num());
+	LineTimes.Reserve(Lines.Num());
+	uint64_t NumBytes = 0;
+	if (Lines.HasBodies())
+	{
+		// Work out the type of each distinct body once, the timestamp is known from the prefix columns
+		const uint8_t UnknownType = 0xFF;
+		std::vector<uint8_t> BodyLineTypes(Lines.NumBodies(), UnknownType);
+		for (size_t BlockIdx = size_t(FirstLine >> FLineStore::LinesPerBlockLog2); BlockIdx < Lines.NumBlocks(); ++BlockIdx)
+		{
+			const uint32_t* BodyIds = Lines.GetBlockBodyIds(BlockIdx);
+			const uint64_t BlockFirstLine = uint64_t(BlockIdx) << FLineStore::LinesPerBlockLog2;
+			for (size_t LocalIdx = BlockFirstLine < FirstLine ? size_t(FirstLine - BlockFirstLine) : 0; LocalIdx < Lines.NumLinesInBlock(BlockIdx); ++LocalIdx)
+			{
+				const uint32_t BodyId = BodyIds[LocalIdx] & ~FLineStore::BodyIdPrefixBit;
+				if (!(BodyIds[LocalIdx] & FLineStore::BodyIdPrefixBit))
+				{
+					// Prefixes that did not fit the prefix columns are still part of the body
+					const FStringView Body = Lines.GetBody(BodyId);
+					LineMetadatas.emplace_back(FLogLineMetadata(Body));
+					int64_t TimestampMs = 0;
+					int Frame = 0;
+					const bool bHasTime = LineMetadatas.back().bContainsTimestamp && ParseLinePrefix(Body.Data, Body.Size, TimestampMs, Frame);
+					LineTimes.Add(bHasTime, TimestampMs, Frame);
+					continue;
+				}
+				int64_t TimestampMs;
+				int Frame;
+				Lines.GetLinePrefix(BlockFirstLine + LocalIdx, TimestampMs, Frame);
+				LineTimes.Add(true, TimestampMs, Frame);
+				if (BodyLineTypes[BodyId] == UnknownType)
+				{
+					BodyLineTypes[BodyId] = (uint8_t)FLogLineMetadata::ParseLineType(Lines.GetBody(BodyId), 0);
+				}
+				LineMetadatas.emplace_back(FLogLineMetadata(true, (ELogLineType)BodyLineTypes[BodyId]));
+			}
+		}
+		ULV_PROFILE_WORK(Lines.Num() - FirstLine, 0);
+	}
+	else
+	{
+		Lines.ForEachLine(FirstLine, Lines.Num(), [&](uint64_t, FStringView Line)
+		{
+			LineMetadatas.emplace_back(FLogLineMetadata(Line));
+			int64_t TimestampMs = 0;
+			int Frame = 0;
+			const bool bHasTime = LineMetadatas.back().bContainsTimestamp && ParseLinePrefix(Line.Data, Line.Size, TimestampMs, Frame);
+			LineTimes.Add(bHasTime, TimestampMs, Frame);
+			NumBytes += Line.Size + 1;
+		});
+		ULV_PROFILE_WORK(Lines.Num() - FirstLine, NumBytes);
+	}
+
+	for (uint64_t LineIdx = 0; LineIdx < LineMetadatas.size(); ++LineIdx)
+	{
+		if (LineMetadatas[LineIdx].LineType == ELogLineType::Error) ErrorLines.push_back(LineIdx);
+		else if (LineMetadatas[LineIdx].LineType == ELogLineType::Warning) WarningLines.push_back(LineIdx);
+	}
+}
+
+FLogFileMemoryUsage& FLogFileMemoryUsage::operator+=(const FLogFileMemoryUsage& Other)
+{
+	Text += Other.Text;
+	LineIndex += Other.LineIndex;
+	Metadata += Other.Metadata;
+	DisplayLines += Other.DisplayLines;
+	FilterCaches += Other.FilterCaches;
+	SearchIndexes += Other.SearchIndexes;
+	return *this;
+}
+
+FLogFileMemoryUsage FLogFile::GetMemoryUsage() const
+{
+	FLogFileMemoryUsage Usage;
+	Usage.Text = Lines.GetTextBytes();
+	Usage.LineIndex = Lines.GetIndexBytes();
+	Usage.Metadata = LineMetadatas.capacity() * sizeof(FLogLineMetadata) + LineTimes.GetAllocatedBytes() + Templates.GetAllocatedBytes() + Timeline.GetAllocatedBytes()
+		+ (ErrorLines.capacity() + WarningLines.capacity() + Bookmarks.capacity()) * sizeof(uint64_t);
+	Usage.DisplayLines = DisplayLines->GetAllocatedBytes() + DuplicateRuns.GetAllocatedBytes();
+	Usage.FilterCaches = Filters.capacity() * sizeof(FLineFilter);
+	for (const FLineFilter& Filter : Filters)
+	{
+		if (Filter.RegionData.Regions) Usage.FilterCaches += Filter.RegionData.Regions->GetAllocatedBytes();
+	}
+	return Usage;
+}
+
+void FLogFile::UpdateRegions(const std::function<void()>& OnDone)
+{
+	bool bAllFound = true;
+	for (FLineFilter& Filter : Filters)
+	{
+		if (!Filter.bEnable || Filter.Type != EFilterType::Region) continue;
+		std::shared_ptr<FLogRegions>& Regions = Filter.RegionData.Regions;
+		if (!Regions) Regions = std::make_shared<FLogRegions>();
+		if (!Regions->IsFound() && !Regions->IsScanning())
+		{
+			Regions->Start(Lines, Filter.RegionData.Start, Filter.RegionData.End, OnDone);
+		}
+		bAllFound &= Regions->IsFound();
+	}
+	if (bWaitingForRegions && bAllFound) bDisplayTextDirty = true;
+}
+
+void FLogFile::CancelRegionScans()
+{
+	for (FLineFilter& Filter : Filters)
+	{
+		if (Filter.RegionData.Regions && Filter.RegionData.Regions->IsScanning()) Filter.RegionData.Regions->Cancel();
+	}
+}
+
+struct FLogFile::FTemplateMining
+{
+	// Only read once bDone is set
+	FLogTemplates Templates;
+	std::atomic<float> Progress{ 0.0f };
+	std::atomic<bool> bCancelled{ false };
+	std::atomic<bool> bDone{ false };
+	// Set once the worker no longer reads the lines
+	std::mutex Mutex;
+	std::condition_variable Stopped;
+	bool bStopped = false;
+};
+
+void FLogFile::UpdateTemplates(const std::function<void()>& OnDone)
+{
+	if (TemplateMining && TemplateMining->bDone)
+	{
+		Templates = std::move(TemplateMining->Templates);
+		TemplateMining.reset();
+		for (const FLineFilter& Filter : Filters)
+		{
+			bDisplayTextDirty |= Filter.bEnable && (Filter.Type == EFilterType::TemplateInclude || Filter.Type == EFilterType::TemplateExclude);
+		}
+	}
+	if (TemplateMining || Templates.NumLines() >= Lines.Num()) return;
+
+	// Carries on from the templates we have, which is none the first time
+	std::shared_ptr<FTemplateMining> Mining = std::make_shared<FTemplateMining>();
+	Mining->Templates = Templates;
+	TemplateMining = Mining;
+	const FLineStore* MinedLines = &Lines;
+	Jobs::Launch([Mining, MinedLines, OnDone]()
+	{
+		Mining->Templates.Update(*MinedLines, &Mining->bCancelled, &Mining->Progress);
+		std::lock_guard<std::mutex> Lock(Mining->Mutex);
+		Mining->bStopped = true;
+		Mining->Stopped.notify_all();
+		if (Mining->bCancelled) return;
+		Mining->bDone = true;
+		if (OnDone) OnDone();
+	});
+}
+
+bool FLogFile::IsMiningTemplates() const
+{
+	return TemplateMining != nullptr;
+}
+
+float FLogFile::GetMiningProgress() const
+{
+	return TemplateMining ? TemplateMining->Progress.load() : 1.0f;
+}
+
+void FLogFile::CancelTemplateMining()
+{
+	if (!TemplateMining) return;
+	TemplateMining->bCancelled = true;
+	std::unique_lock<std::mutex> Lock(TemplateMining->Mutex);
+	TemplateMining->Stopped.wait(Lock, [this]() { return TemplateMining->bStopped; });
+	Lock.unlock();
+	// Mined ones are still swapped in by the next UpdateTemplates
+	if (!TemplateMining->bDone) TemplateMining.reset();
+}
+
+uint64_t FLogFile::EvictCaches()
+{
+	const uint64_t DisplayLinesBytes = DisplayLines->GetAllocatedBytes() + DuplicateRuns.GetAllocatedBytes();
+	if (DisplayLines.use_count() > 1) DisplayLines = std::make_shared<FDisplayLines>();
+	else DisplayLines->Release();
+	DuplicateRuns = FDuplicateRuns();
+	bDisplayTextDirty = true;
+	return DisplayLinesBytes + Lines.Trim(0);
+}
+
+static FLogTimeline::ELevel GetTimelineLevel(ELogLineType LineType)
+{
+	return LineType == ELogLineType::Error ? FLogTimeline::Error : LineType == ELogLineType::Warning ? FLogTimeline::Warning : FLogTimeline::Log;
+}
+
+const FLogTimeline& FLogFile::GetTimeline() const
+{
+	if (Timeline.NumLines() < Lines.Num())
+	{
+		// Which categories get counts depends on every line, so they are all counted again
+		ULV_PROFILE_SCOPE("FLogFile::GetTimeline");
+		Timeline = FLogTimeline();
+		if (Lines.HasBodies())
+		{
+			// Find the category of each distinct body once
+			const uint32_t UnknownCategory = FLogTimeline::NoCategory - 1;
+			std::vector<uint32_t> BodyCategories(Lines.NumBodies(), UnknownCategory);
+			for (size_t BlockIdx = 0; BlockIdx < Lines.NumBlocks(); ++BlockIdx)
+			{
+				const uint32_t* BodyIds = Lines.GetBlockBodyIds(BlockIdx);
+				const uint64_t BlockFirstLine = uint64_t(BlockIdx) << FLineStore::LinesPerBlockLog2;
+				for (size_t LocalIdx = 0; LocalIdx < Lines.NumLinesInBlock(BlockIdx); ++LocalIdx)
+				{
+					const uint32_t BodyId = BodyIds[LocalIdx] & ~FLineStore::BodyIdPrefixBit;
+					uint32_t& Category = BodyCategories[BodyId];
+					if (Category == UnknownCategory)
+					{
+						// Prefixes that did not fit the prefix columns are still part of the body
+						const FStringView Body = Lines.GetBody(BodyId);
+						const size_t BodyStart = !(BodyIds[LocalIdx] & FLineStore::BodyIdPrefixBit) && LineMetadatas[BlockFirstLine + LocalIdx].bContainsTimestamp ? FLogLineMetadata::FrameEndIdx + 1 : 0;
+						Category = Timeline.FindCategory(FStringView(Body.Data + BodyStart, Body.Size - BodyStart));
+					}
+					Timeline.AddLine(GetTimelineLevel(LineMetadatas[BlockFirstLine + LocalIdx].LineType), Category);
+				}
+			}
+		}
+		else
+		{
+			Lines.ForEachLine(0, Lines.Num(), [&](uint64_t LineIdx, FStringView Line)
+			{
+				const FLogLineMetadata& Metadata = LineMetadatas[LineIdx];
+				const size_t BodyStart = Metadata.bContainsTimestamp ? FLogLineMetadata::FrameEndIdx + 1 : 0;
+				Timeline.AddLine(GetTimelineLevel(Metadata.LineType), Timeline.FindCategory(FStringView(Line.Data + BodyStart, Line.Size - BodyStart)));
+			});
+		}
+		Timeline.Finish();
+		ULV_PROFILE_WORK(Lines.Num(), 0);
+	}
+	return Timeline;
+}
+
+const FDisplayLines& FLogFile::GetDisplayLines() const
+{
+	if (bDisplayTextDirty)
+	{
+		ULV_PROFILE_SCOPE("FLogFile::GetDisplayLines");
+		// Jobs may still be reading the last display lines, which are left to them rather than rebuilt in place
+		if (DisplayLines.use_count() > 1) DisplayLines = std::make_shared<FDisplayLines>();
+		else DisplayLines->Reset();
+		DuplicateRuns.Reset();
+
+		// Display rows so far, and the run of rows with the same message as the last one
+		uint64_t NumRows = 0;
+		uint64_t RunFirstRow = 0;
+		auto AddRow = [&](bool bSameAsLastRow)
+		{
+			if (!bSameAsLastRow)
+			{
+				if (NumRows - RunFirstRow > 1) DuplicateRuns.AddRun(RunFirstRow, NumRows - RunFirstRow);
+				RunFirstRow = NumRows;
+			}
+			++NumRows;
+		};
+
+		// Time and frame ranges cut the lines down to one interval by binary search before any of them is looked at
+		uint64_t FirstLine = 0;
+		uint64_t EndLine = Lines.Num();
+		for (const FLineFilter& Filter : Filters)
+		{
+			if (!Filter.bEnable || !LineTimes.HasTimes()) continue;
+			if (Filter.Type == EFilterType::TimeRange)
+			{
+				FirstLine = std::max(FirstLine, LineTimes.FindLine(Filter.TimeRangeData.StartMs));
+				EndLine = std::min(EndLine, LineTimes.FindLine(Filter.TimeRangeData.EndMs));
+			}
+			else if (Filter.Type == EFilterType::FrameRange)
+			{
+				FirstLine = std::max(FirstLine, LineTimes.FindFrameLine(Filter.FrameRangeData.FirstFrame));
+				EndLine = std::min(EndLine, LineTimes.FindFrameLine(Filter.FrameRangeData.LastFrame + 1));
+			}
+		}
+		EndLine = std::max(FirstLine, EndLine);
+
+		// Region filters cut the interval down further to the lines inside a region of every one of them
+		std::vector<FLogRegion> Intervals(1, FLogRegion{ FirstLine, EndLine });
+		bWaitingForRegions = false;
+		for (const FLineFilter& Filter : Filters)
+		{
+			if (!Filter.bEnable || Filter.Type != EFilterType::Region) continue;
+			const std::shared_ptr<FLogRegions>& Regions = Filter.RegionData.Regions;
+			if (!Regions || !Regions->IsFound())
+			{
+				bWaitingForRegions = true;
+				Intervals.clear();
+				continue;
+			}
+			const std::vector<FLogRegion>& FoundRegions = Regions->GetRegions();
+			const int64_t RegionIdx = Filter.RegionData.RegionIdx;
+			if (RegionIdx < 0) Intervals = IntersectRegions(Intervals, FoundRegions.data(), FoundRegions.size());
+			else if (uint64_t(RegionIdx) < FoundRegions.size()) Intervals = IntersectRegions(Intervals, FoundRegions.data() + RegionIdx, 1);
+			else Intervals.clear();
+		}
+
+		uint64_t NumFilteredLines = 0;
+		for (const FLogRegion& Interval : Intervals)
+		{
+			NumFilteredLines += Interval.EndLine - Interval.FirstLine;
+		}
+
+		// With context lines, each match and the lines around it are merged into groups of lines as the matches come in order,
+		// popping any earlier groups a match reaches back over. A second pass then shows every line of the groups.
+		bContextGroups = HasContextLines(Filters);
+		bool bFilterLines = true;
+		std::vector<FLogRegion> Groups;
+		auto AddMatch = [&Groups](uint64_t LineIdx, FLineContext Context, const FLogRegion& Interval)
+		{
+			FLogRegion Group{ std::max(Interval.FirstLine, LineIdx - std::min<uint64_t>(LineIdx, Context.Before)), std::min(Interval.EndLine, LineIdx + Context.After + 1) };
+			while (!Groups.empty() && Group.FirstLine <= Groups.back().EndLine)
+			{
+				Group.FirstLine = std::min(Group.FirstLine, Groups.back().FirstLine);
+				Group.EndLine = std::max(Group.EndLine, Groups.back().EndLine);
+				Groups.pop_back();
+			}
+			Groups.push_back(Group);
+		};
+
+		// Template filters are resolved from the template of each line before its text is read
+		const std::vector<bool> DroppedTemplates = GetDroppedTemplates(Filters, Templates.Num());
+		auto IsDropped = [&](uint64_t LineIdx)
+		{
+			return !DroppedTemplates.empty() && DroppedTemplates[std::min(Templates.GetLineTemplate(LineIdx), Templates.Num())];
+		};
+
+		uint64_t NumBytes = 0;
+		uint64_t NumFiltersEvaluated = 0;
+		if (Lines.HasBodies() && CanFilterLineBodies(Filters))
+		{
+			// Filter each distinct body once and share the result with every line that uses it
+			enum : uint8_t { Unknown, Included, Excluded };
+			std::vector<uint8_t> BodyResults(Lines.NumBodies(), Unknown);
+			std::vector<FLineContext> BodyContexts(bContextGroups ? Lines.NumBodies() : 0);
+			uint32_t LastBodyId = UINT32_MAX;
+			for (int Pass = 0; Pass < (bContextGroups ? 2 : 1); ++Pass)
+			{
+				for (const FLogRegion& Interval : Intervals)
+				{
+					for (size_t BlockIdx = size_t(Interval.FirstLine >> FLineStore::LinesPerBlockLog2); BlockIdx < Lines.NumBlocks(); ++BlockIdx)
+					{
+						const uint32_t* BodyIds = Lines.GetBlockBodyIds(BlockIdx);
+						const uint64_t BlockFirstLine = uint64_t(BlockIdx) << FLineStore::LinesPerBlockLog2;
+						if (BlockFirstLine >= Interval.EndLine) break;
+						const size_t EndLocalIdx = size_t(std::min<uint64_t>(Lines.NumLinesInBlock(BlockIdx), Interval.EndLine - BlockFirstLine));
+						for (size_t LocalIdx = BlockFirstLine < Interval.FirstLine ? size_t(Interval.FirstLine - BlockFirstLine) : 0; LocalIdx < EndLocalIdx; ++LocalIdx)
+						{
+							const uint64_t LineIdx = BlockFirstLine + LocalIdx;
+							const uint32_t BodyId = BodyIds[LocalIdx] & ~FLineStore::BodyIdPrefixBit;
+							if (bFilterLines)
+							{
+								if (IsDropped(LineIdx)) continue;
+								uint8_t& Result = BodyResults[BodyId];
+								if (Result == Unknown)
+								{
+									const FStringView Body = Lines.GetBody(BodyId);
+									Result = DoFilterLine(Filters, Body, Templates.GetLineTemplate(LineIdx), bContextGroups ? &BodyContexts[BodyId] : nullptr, &NumFiltersEvaluated) ? Included : Excluded;
+									NumBytes += Body.Size + 1;
+								}
+								if (Result != Included) continue;
+								if (bContextGroups)
+								{
+									AddMatch(LineIdx, BodyContexts[BodyId], Interval);
+									continue;
+								}
+							}
+							DisplayLines->Add(LineIdx);
+							if (bCollapseDuplicates)
+							{
+								AddRow(BodyId == LastBodyId);
+								LastBodyId = BodyId;
+							}
+						}
+					}
+				}
+				Intervals.swap(Groups);
+				bFilterLines = false;
+			}
+		}
+		else
+		{
+			auto GetBody = [this](uint64_t LineIdx, FStringView Line)
+			{
+				const size_t BodyStart = LineMetadatas[LineIdx].bContainsTimestamp ? FLogLineMetadata::FrameEndIdx + 1 : 0;
+				return FStringView(Line.Data + BodyStart, Line.Size - BodyStart);
+			};
+			// Pins the block of the last shown line once we move past it
+			FLineRef LastLine;
+			uint64_t LastLineIdx = UINT64_MAX;
+			FStringView LastBody;
+			const FLogRegion* Interval = nullptr;
+			auto FilterLine = [&](uint64_t LineIdx, FStringView Line)
+			{
+				if (bFilterLines)
+				{
+					NumBytes += Line.Size + 1;
+					FLineContext Context;
+					if (!DoFilterLine(Filters, Line, Templates.GetLineTemplate(LineIdx), &Context, &NumFiltersEvaluated)) return;
+					if (bContextGroups)
+					{
+						AddMatch(LineIdx, Context, *Interval);
+						return;
+					}
+				}
+				DisplayLines->Add(LineIdx);
+				if (bCollapseDuplicates)
+				{
+					if (LastLineIdx != UINT64_MAX && (LastLineIdx >> FLineStore::LinesPerBlockLog2) != (LineIdx >> FLineStore::LinesPerBlockLog2))
+					{
+						LastLine = Lines.GetLine(LastLineIdx);
+						LastBody = GetBody(LastLineIdx, LastLine.Text);
+					}
+					const FStringView Body = GetBody(LineIdx, Line);
+					AddRow(LastLineIdx != UINT64_MAX && Body.Size == LastBody.Size && memcmp(Body.Data, LastBody.Data, Body.Size) == 0);
+					LastLineIdx = LineIdx;
+					LastBody = Body;
+				}
+			};
+			for (int Pass = 0; Pass < (bContextGroups ? 2 : 1); ++Pass)
+			{
+				for (const FLogRegion& PassInterval : Intervals)
+				{
+					Interval = &PassInterval;
+					if (!bFilterLines || DroppedTemplates.empty())
+					{
+						Lines.ForEachLine(PassInterval.FirstLine, PassInterval.EndLine, FilterLine);
+						continue;
+					}
+					// Only the runs of lines the template filters keep are read
+					for (uint64_t RunStart = PassInterval.FirstLine; RunStart < PassInterval.EndLine; )
+					{
+						while (RunStart < PassInterval.EndLine && IsDropped(RunStart)) ++RunStart;
+						uint64_t RunEnd = RunStart;
+						while (RunEnd < PassInterval.EndLine && !IsDropped(RunEnd)) ++RunEnd;
+						if (RunEnd > RunStart) Lines.ForEachLine(RunStart, RunEnd, FilterLine);
+						RunStart = RunEnd;
+					}
+				}
+				Intervals.swap(Groups);
+				bFilterLines = false;
+			}
+		}
+		DisplayLines->Finish();
+		if (NumRows - RunFirstRow > 1) DuplicateRuns.AddRun(RunFirstRow, NumRows - RunFirstRow);
+		DuplicateRuns.Finish(DisplayLines->Num());
+		ULV_PROFILE_WORK(NumFilteredLines, NumBytes);
+		ULV_PROFILE_COUNTER("DoFilterLine filter evaluations", NumFiltersEvaluated);
+		bDisplayTextDirty = false;
+		++DisplayLinesVersion;
+	}
+	return *DisplayLines;
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "DensityMap.h"
+#include "DisplayLines.h"
+#include "LineStore.h"
+#include "LineTimes.h"
+#include "LogRegions.h"
+#include "LogTemplates.h"
+#include "LogTimeline.h"
+#include "StringView.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class EFilterType : int
+{
+	TextInclude = 0,
+	TextExclude,
+	LogCategory,
+	TemplateInclude,
+	TemplateExclude,
+	TimeRange,
+	FrameRange,
+	Region,
+	MAX
+};
+
+extern const char* EFilterTypeStrings[(int)EFilterType::MAX + 1];
+
+enum class ELogVerbosity : int
+{
+	Off = 0,
+	Error,
+	Warning,
+	Log,
+	Verbose,
+	VeryVerbose,
+	MAX
+};
+
+extern const char* ELogVerbosityStrings[(int)ELogVerbosity::MAX + 1];
+
+struct FLineFilter
+{
+	EFilterType Type = EFilterType::TextInclude;
+	struct
+	{
+		std::string Token;
+		bool bCaseMatch = false;
+	} TextData;
+	struct
+	{
+		std::string Category;
+		ELogVerbosity Verbosity = ELogVerbosity::Log;
+	} LogCategoryData;
+	struct
+	{
+		uint32_t TemplateId = FLogTemplates::NoTemplate;
+		std::string Text;
+	} TemplateData;
+	struct
+	{
+		// Lines from StartMs up to but not including EndMs
+		int64_t StartMs = 0;
+		int64_t EndMs = 0;
+	} TimeRangeData;
+	struct
+	{
+		// Unwrapped frames from FirstFrame to LastFrame inclusive
+		int64_t FirstFrame = 0;
+		int64_t LastFrame = 0;
+	} FrameRangeData;
+	struct
+	{
+		FSearchQuery Start;
+		FSearchQuery End;
+		// Only the region with this index is shown, every region if it is negative
+		int64_t RegionIdx = -1;
+		// Found in the background by FLogFile::UpdateRegions, reset it after changing the queries
+		std::shared_ptr<FLogRegions> Regions;
+	} RegionData;
+	// Lines shown before and after each line an include filter matches, like grep -B and -A
+	int ContextBefore = 0;
+	int ContextAfter = 0;
+	bool bEnable = false;
+};
+
+/** Most lines of context a filter can show on either side of a match */
+static const int MaxContextLines = 10000;
+
+struct FLineContext
+{
+	uint16_t Before = 0;
+	uint16_t After = 0;
+};
+
+/**
+ * Returns true if we should include the line, template filters only match lines whose template is known and time ranges, frame ranges and regions are left to the caller.
+ * OutContext is set to the most context lines any include filter matching the line asks for.
+ * InOutNumFiltersEvaluated is increased by the number of filters looked at, for the caller to report once per pass.
+ */
+bool DoFilterLine(const std::vector<FLineFilter>& Filters, FStringView Line, uint32_t TemplateId = FLogTemplates::NoTemplate, FLineContext* OutContext = nullptr,
+	uint64_t* InOutNumFiltersEvaluated = nullptr);
+
+/** True if an enabled include filter shows context lines around its matches */
+bool HasContextLines(const std::vector<FLineFilter>& Filters);
+
+enum class ELogLineType : uint8_t
+{
+	Normal,
+	Warning,
+	Error
+};
+
+struct FLogLineMetadata
+{
+	FLogLineMetadata(FStringView InText);
+	FLogLineMetadata(bool bInContainsTimestamp, ELogLineType InLineType) : bContainsTimestamp(bInContainsTimestamp), LineType(InLineType) {}
+
+	/** Line type from the text after the timestamp */
+	static ELogLineType ParseLineType(FStringView Text, int PostTimestampPos);
+
+	bool bContainsTimestamp = false;
+	ELogLineType LineType = ELogLineType::Normal;
+
+	static const int TimestampStartIdx = 0;
+	static const int TimestampEndIdx = TimestampStartIdx + 24;
+	static const int FrameStartIdx = TimestampEndIdx + 1;
+	static const int FrameEndIdx = FrameStartIdx + 4;
+};
+
+/** Bytes used by a log file, split by what they are used for */
+struct FLogFileMemoryUsage
+{
+	uint64_t Text = 0;
+	uint64_t LineIndex = 0;
+	uint64_t Metadata = 0;
+	uint64_t DisplayLines = 0;
+	uint64_t FilterCaches = 0;
+	uint64_t SearchIndexes = 0;
+
+	uint64_t GetTotal() const { return Text + LineIndex + Metadata + DisplayLines + FilterCaches + SearchIndexes; }
+	FLogFileMemoryUsage& operator+=(const FLogFileMemoryUsage& Other);
+};
+
+struct FLogFile
+{
+public:
+	/** Works out the metadata and times of every line after the cached ones */
+	FLogFile(const std::string& FilePath, FLineStore&& InLines, std::vector<FLogLineMetadata>&& CachedLineMetadatas = std::vector<FLogLineMetadata>(),
+		FLineTimes&& CachedLineTimes = FLineTimes());
+	std::string FilePath;
+	FLineStore Lines;
+	std::vector<FLogLineMetadata> LineMetadatas;
+	FLineTimes LineTimes;
+	// Lines of each type that stands out, in order
+	std::vector<uint64_t> ErrorLines;
+	std::vector<uint64_t> WarningLines;
+	std::vector<FLineFilter> Filters;
+	// Mined on a worker by UpdateTemplates when the patterns of the file are first shown
+	FLogTemplates Templates;
+	mutable bool bDisplayTextDirty = true;
+
+	// First display row shown in the text window, fractional so small scroll steps add up
+	double ScrollRow = 0.0;
+	// Which way we last scrolled, text is prefetched in that direction
+	int ScrollDirection = 1;
+
+	// Frame this file was last shown on, the least recently viewed files are evicted first
+	uint64_t LastViewedFrame = 0;
+
+	// Time shown across the timeline strip, the whole log while TimelineEndMs is not after TimelineStartMs
+	int64_t TimelineStartMs = 0;
+	int64_t TimelineEndMs = 0;
+	// First line of each timeline bucket and the line count of each series in it, kept to reuse their memory
+	std::vector<uint64_t> TimelineBucketLines;
+	std::vector<float> TimelineBucketCounts;
+
+	// Lines the user marked, in order. Bump BookmarksVersion after changing them.
+	std::vector<uint64_t> Bookmarks;
+	uint64_t BookmarksVersion = 0;
+
+	// Errors, warnings, search hits and bookmarks drawn over the scrollbar
+	FDensityMap DensityMap;
+
+	// Whether this file's lines are shown in the merged view
+	bool bInMergedView = true;
+
+	// Whether this file's hits are folded under its row in the search view
+	bool bSearchHitsCollapsed = false;
+
+	// Consecutive display lines with the same message after the prefix are shown as one row, set bDisplayTextDirty after changing it
+	bool bCollapseDuplicates = false;
+
+	const FDisplayLines& GetDisplayLines() const;
+
+	/** True if the display lines are groups of matches and their context lines, which are split wherever a line is skipped */
+	bool HasContextGroups() const { GetDisplayLines(); return bContextGroups; }
+
+	/** Runs of duplicate display lines, found by GetDisplayLines when bCollapseDuplicates is set */
+	const FDuplicateRuns& GetDuplicateRuns() const { GetDisplayLines(); return DuplicateRuns; }
+	void SetDuplicateRunExpanded(size_t RunIdx, bool bExpanded) { DuplicateRuns.SetRunExpanded(RunIdx, bExpanded); }
+
+	/** The display lines as they are now, for jobs to read without a copy. Rebuilding them leaves this set to the jobs. */
+	std::shared_ptr<const FDisplayLines> ShareDisplayLines() const { GetDisplayLines(); return DisplayLines; }
+
+	/** Changes whenever GetDisplayLines rebuilds the display lines */
+	uint64_t GetDisplayLinesVersion() const { return DisplayLinesVersion; }
+
+	/** First display row at or after a time, O(log n) */
+	uint64_t FindDisplayRow(int64_t TimeMs) const { return GetDisplayLines().FindRow(LineTimes.FindLine(TimeMs)); }
+
+	/**
+	 * Starts finding the regions of enabled region filters that have none, and marks the display text dirty when they are found.
+	 * Cheap once every region filter has its regions. OnDone is called from the worker that found them.
+	 */
+	void UpdateRegions(const std::function<void()>& OnDone);
+
+	/** Stops finding regions, so the file can be moved. They are found again by the next UpdateRegions. */
+	void CancelRegionScans();
+
+	/**
+	 * Starts mining the templates on a worker unless every line has one or is being mined, and swaps them in once they are mined,
+	 * marking the display text dirty if a template filter is enabled. OnDone is called from the worker that mined them.
+	 */
+	void UpdateTemplates(const std::function<void()>& OnDone);
+	/** True until UpdateTemplates swaps the mined templates in */
+	bool IsMiningTemplates() const;
+	/** Fraction of the lines mined so far */
+	float GetMiningProgress() const;
+
+	/** Stops mining templates, so the file can be moved. They are mined again by the next UpdateTemplates. */
+	void CancelTemplateMining();
+
+	/** Line counts over time, counted up to the last line the first time they are asked for */
+	const FLogTimeline& GetTimeline() const;
+
+	FLogFileMemoryUsage GetMemoryUsage() const;
+
+	/** Frees everything that can be rebuilt on demand, returns the number of bytes released */
+	uint64_t EvictCaches();
+
+private:
+	struct FTemplateMining;
+	std::shared_ptr<FTemplateMining> TemplateMining;
+
+	// Shared with the jobs that read them, see ShareDisplayLines
+	mutable std::shared_ptr<FDisplayLines> DisplayLines = std::make_shared<FDisplayLines>();
+	mutable FDuplicateRuns DuplicateRuns;
+	mutable uint64_t DisplayLinesVersion = 0;
+	mutable FLogTimeline Timeline;
+	// An enabled region filter had no regions yet when the display lines were last built
+	mutable bool bWaitingForRegions = false;
+	mutable bool bContextGroups = false;
+};
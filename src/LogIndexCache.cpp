@@ -0,0 +1,289 @@
+#include "LogIndexCache.h"
+#include "FileUtils.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+namespace LogIndexCache
+{
+
+static const char CacheMagic[8] = { 'U', 'L', 'V', 'I', 'N', 'D', 'E', 'X' };
+// Bump whenever the layout, or the way metadata is worked out, changes
+static const uint32_t CacheVersion = 3;
+
+// Small logs load quickly enough without leaving a cache file next to them
+static const uint64_t MinCachedFileSize = 16 * 1024 * 1024;
+
+/**
+ * Start of a cache file. It is followed by one record per block of lines, holding the base time and frame of the block,
+ * the 32 bit line ends, the 32 bit time offsets, the 16 bit frame offsets and then one metadata byte per line.
+ * Everything is little endian at fixed, 8 byte aligned offsets, so the file can be mapped as well as read.
+ */
+struct FCacheHeader
+{
+	char Magic[8];
+	uint32_t Version;
+	uint32_t LinesPerBlock;
+	uint64_t FileSize;
+	uint64_t FileModifiedTime;
+	// Bytes of the log covered by the cached blocks, and a hash of samples of those bytes
+	uint64_t NumCoveredBytes;
+	uint64_t SampleHash;
+	uint64_t NumBlocks;
+};
+
+static const uint64_t RecordsOffset = 64;
+static const uint64_t RecordSize = sizeof(int64_t) * 2 + FLineStore::LinesPerBlock * (sizeof(uint32_t) * 2 + sizeof(uint16_t) + 1);
+static_assert(FLineStore::LinesPerBlock == FLineTimes::LinesPerBlock, "Line times are cached per block of lines");
+
+static uint64_t HashBytes(const char* Data, size_t Size, uint64_t Hash = 14695981039346656037ull)
+{
+	// FNV-1a
+	for (size_t ByteIdx = 0; ByteIdx < Size; ++ByteIdx)
+	{
+		Hash = (Hash ^ uint8_t(Data[ByteIdx])) * 1099511628211ull;
+	}
+	return Hash;
+}
+
+static std::string GetCachePath(const std::string& FilePath, bool bTempDirectory)
+{
+	if (!bTempDirectory) return FilePath + ".ulvindex";
+
+	const char* TempDirectory = getenv("TMPDIR");
+	if (!TempDirectory) TempDirectory = getenv("TEMP");
+	if (!TempDirectory) TempDirectory = "/tmp";
+	char FileName[64];
+	snprintf(FileName, sizeof(FileName), "/ulv_%016llx.ulvindex", (unsigned long long)HashBytes(FilePath.data(), FilePath.size()));
+	return TempDirectory + std::string(FileName);
+}
+
+/** Hashes samples spread evenly over the first NumBytes of a file, including its start and end. Returns 0 if they could not be read. */
+static uint64_t HashFileSamples(const std::string& FilePath, uint64_t NumBytes)
+{
+	std::ifstream File(FilePath, std::ios::binary);
+	if (!File.is_open()) return 0;
+
+	const int NumSamples = 33;
+	char Sample[4096];
+	const uint64_t SampleSize = std::min<uint64_t>(NumBytes, sizeof(Sample));
+	uint64_t Hash = HashBytes((const char*)&NumBytes, sizeof(NumBytes));
+	for (int SampleIdx = 0; SampleIdx < NumSamples; ++SampleIdx)
+	{
+		File.seekg((NumBytes - SampleSize) * SampleIdx / (NumSamples - 1));
+		File.read(Sample, SampleSize);
+		if (uint64_t(File.gcount()) != SampleSize) return 0;
+		Hash = HashBytes(Sample, size_t(SampleSize), Hash);
+	}
+	return Hash;
+}
+
+/** Opens the cache of a log if it is still valid for it, the log may have been appended to since */
+static bool OpenCache(const std::string& CachePath, const std::string& FilePath, uint64_t FileSize, uint64_t ModifiedTime, std::ifstream& OutCache, FCacheHeader& OutHeader)
+{
+	OutCache.open(CachePath, std::ios::binary);
+	if (!OutCache.read((char*)&OutHeader, sizeof(OutHeader))) return false;
+	OutCache.seekg(0, std::ios::end);
+	const uint64_t CacheSize = OutCache.tellg();
+
+	if (memcmp(OutHeader.Magic, CacheMagic, sizeof(CacheMagic)) != 0
+		|| OutHeader.Version != CacheVersion
+		|| OutHeader.LinesPerBlock != FLineStore::LinesPerBlock
+		|| CacheSize < RecordsOffset + OutHeader.NumBlocks * RecordSize)
+	{
+		return false;
+	}
+
+	// A log that shrank, or changed without growing, was rewritten rather than appended to
+	if (FileSize < OutHeader.FileSize || (FileSize == OutHeader.FileSize && ModifiedTime != OutHeader.FileModifiedTime)) return false;
+	return OutHeader.NumCoveredBytes <= FileSize && HashFileSamples(FilePath, OutHeader.NumCoveredBytes) == OutHeader.SampleHash;
+}
+
+/** Adds the cached blocks to the store, returns false if the cache turned out to be corrupt */
+static bool ReadCachedBlocks(std::ifstream& Cache, const FCacheHeader& Header, const std::string& FilePath, FLineStore& Lines,
+	std::vector<FLogLineMetadata>& OutLineMetadatas, FLineTimes& OutLineTimes)
+{
+	ULV_PROFILE_SCOPE("LogIndexCache::ReadCachedBlocks");
+	ULV_PROFILE_JOB("Reading index of " + FilePath);
+
+	// Paged storage reads the text when it is shown, everything else needs it now
+	std::ifstream File;
+	if (Lines.GetStorage() != ELineStorage::Paged)
+	{
+		File.open(FilePath, std::ios::binary);
+	}
+
+	std::unique_ptr<char[]> Record(new char[RecordSize]);
+	OutLineMetadatas.reserve(Header.NumBlocks * FLineStore::LinesPerBlock);
+	OutLineTimes.Reserve(Header.NumBlocks * FLineStore::LinesPerBlock);
+	uint64_t NumBlockBytes = 0;
+	Cache.seekg(RecordsOffset);
+	for (uint64_t BlockIdx = 0; BlockIdx < Header.NumBlocks; ++BlockIdx)
+	{
+		if (!Cache.read(Record.get(), RecordSize)) return false;
+
+		int64_t BaseTime, BaseFrame;
+		memcpy(&BaseTime, Record.get(), sizeof(BaseTime));
+		memcpy(&BaseFrame, Record.get() + sizeof(int64_t), sizeof(BaseFrame));
+		std::vector<uint32_t> LineEnds(FLineStore::LinesPerBlock);
+		memcpy(LineEnds.data(), Record.get() + sizeof(int64_t) * 2, LineEnds.size() * sizeof(uint32_t));
+		for (size_t LineIdx = 0; LineIdx < LineEnds.size(); ++LineIdx)
+		{
+			if (LineEnds[LineIdx] <= (LineIdx ? LineEnds[LineIdx - 1] : 0)) return false;
+		}
+		NumBlockBytes += LineEnds.back();
+
+		std::vector<char> Text;
+		if (File.is_open())
+		{
+			Text.resize(LineEnds.back());
+			File.read(Text.data(), Text.size());
+			std::fill(Text.begin() + size_t(File.gcount()), Text.end(), ' ');
+		}
+		Lines.AddBlock(std::move(LineEnds), std::move(Text));
+
+		const uint32_t* TimeOffsets = (const uint32_t*)(Record.get() + sizeof(int64_t) * 2 + FLineStore::LinesPerBlock * sizeof(uint32_t));
+		const uint16_t* FrameOffsets = (const uint16_t*)(TimeOffsets + FLineStore::LinesPerBlock);
+		OutLineTimes.AddBlock(BaseTime, TimeOffsets, BaseFrame, FrameOffsets);
+
+		const uint8_t* Metadatas = (const uint8_t*)(FrameOffsets + FLineStore::LinesPerBlock);
+		for (int LineIdx = 0; LineIdx < FLineStore::LinesPerBlock; ++LineIdx)
+		{
+			OutLineMetadatas.emplace_back(FLogLineMetadata((Metadatas[LineIdx] & 1) != 0, ELogLineType(Metadatas[LineIdx] >> 1)));
+		}
+		ULV_PROFILE_JOB_PROGRESS(BlockIdx + 1, Header.NumBlocks);
+	}
+	return NumBlockBytes == Header.NumCoveredBytes;
+}
+
+/** Writes the full blocks of the log to its cache, only appending the blocks after the first NumExistingBlocks */
+static bool WriteCache(const std::string& CachePath, const FLogFile& LogFile, uint64_t FileSize, uint64_t ModifiedTime, uint64_t NumExistingBlocks)
+{
+	ULV_PROFILE_SCOPE("LogIndexCache::WriteCache");
+	const FLineStore& Lines = LogFile.Lines;
+
+	// The lines after the last full block are read from the log every time
+	uint64_t NumBlocks = Lines.Num() >> FLineStore::LinesPerBlockLog2;
+	uint64_t NumCoveredBytes = 0;
+	for (uint64_t BlockIdx = 0; BlockIdx < NumBlocks; ++BlockIdx)
+	{
+		NumCoveredBytes += Lines.GetBlockLineEnds(size_t(BlockIdx)).back();
+	}
+	if (NumBlocks > 0 && NumCoveredBytes > FileSize)
+	{
+		// The last line had no line ending, which the store added
+		NumCoveredBytes -= Lines.GetBlockLineEnds(size_t(--NumBlocks)).back();
+	}
+	if (NumBlocks == 0 || NumExistingBlocks > NumBlocks) return false;
+
+	std::fstream Cache;
+	if (NumExistingBlocks > 0)
+	{
+		Cache.open(CachePath, std::ios::in | std::ios::out | std::ios::binary);
+	}
+	if (!Cache.is_open())
+	{
+		Cache.open(CachePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		NumExistingBlocks = 0;
+	}
+	if (!Cache.is_open()) return false;
+
+	std::unique_ptr<char[]> Record(new char[RecordSize]);
+	Cache.seekp(RecordsOffset + NumExistingBlocks * RecordSize);
+	for (uint64_t BlockIdx = NumExistingBlocks; BlockIdx < NumBlocks && Cache; ++BlockIdx)
+	{
+		const int64_t BaseTime = LogFile.LineTimes.GetBlockBase(size_t(BlockIdx));
+		const int64_t BaseFrame = LogFile.LineTimes.GetBlockBaseFrame(size_t(BlockIdx));
+		memcpy(Record.get(), &BaseTime, sizeof(BaseTime));
+		memcpy(Record.get() + sizeof(int64_t), &BaseFrame, sizeof(BaseFrame));
+		const std::vector<uint32_t>& LineEnds = Lines.GetBlockLineEnds(size_t(BlockIdx));
+		memcpy(Record.get() + sizeof(int64_t) * 2, LineEnds.data(), LineEnds.size() * sizeof(uint32_t));
+		uint32_t* TimeOffsets = (uint32_t*)(Record.get() + sizeof(int64_t) * 2 + FLineStore::LinesPerBlock * sizeof(uint32_t));
+		memcpy(TimeOffsets, LogFile.LineTimes.GetBlockOffsets(size_t(BlockIdx)), FLineStore::LinesPerBlock * sizeof(uint32_t));
+		uint16_t* FrameOffsets = (uint16_t*)(TimeOffsets + FLineStore::LinesPerBlock);
+		memcpy(FrameOffsets, LogFile.LineTimes.GetBlockFrameOffsets(size_t(BlockIdx)), FLineStore::LinesPerBlock * sizeof(uint16_t));
+		uint8_t* Metadatas = (uint8_t*)(FrameOffsets + FLineStore::LinesPerBlock);
+		for (int LineIdx = 0; LineIdx < FLineStore::LinesPerBlock; ++LineIdx)
+		{
+			const FLogLineMetadata& Metadata = LogFile.LineMetadatas[size_t(BlockIdx << FLineStore::LinesPerBlockLog2) + LineIdx];
+			Metadatas[LineIdx] = uint8_t(Metadata.bContainsTimestamp) | uint8_t((int)Metadata.LineType << 1);
+		}
+		Cache.write(Record.get(), RecordSize);
+	}
+
+	// The header goes last, so a cache that was not written completely is never used
+	char HeaderBytes[RecordsOffset] = {};
+	FCacheHeader Header;
+	memcpy(Header.Magic, CacheMagic, sizeof(CacheMagic));
+	Header.Version = CacheVersion;
+	Header.LinesPerBlock = FLineStore::LinesPerBlock;
+	Header.FileSize = FileSize;
+	Header.FileModifiedTime = ModifiedTime;
+	Header.NumCoveredBytes = NumCoveredBytes;
+	Header.SampleHash = HashFileSamples(LogFile.FilePath, NumCoveredBytes);
+	Header.NumBlocks = NumBlocks;
+	memcpy(HeaderBytes, &Header, sizeof(Header));
+	Cache.seekp(0);
+	Cache.write(HeaderBytes, sizeof(HeaderBytes));
+	return bool(Cache);
+}
+
+FLogFile OpenLogFile(const std::string& FilePath, ELineStorage Storage)
+{
+	ULV_PROFILE_SCOPE("LogIndexCache::OpenLogFile");
+	const uint64_t FileSize = FileUtils::GetFileSize(FilePath);
+	const uint64_t ModifiedTime = FileUtils::GetFileModifiedTime(FilePath);
+
+	FLineStore Lines(Storage, FilePath);
+	std::vector<FLogLineMetadata> CachedLineMetadatas;
+	FLineTimes CachedLineTimes;
+	std::string CachePath;
+	FCacheHeader Header = {};
+	if (FileSize >= MinCachedFileSize)
+	{
+		for (bool bTempDirectory : { false, true })
+		{
+			std::ifstream Cache;
+			if (OpenCache(GetCachePath(FilePath, bTempDirectory), FilePath, FileSize, ModifiedTime, Cache, Header)
+				&& ReadCachedBlocks(Cache, Header, FilePath, Lines, CachedLineMetadatas, CachedLineTimes))
+			{
+				CachePath = GetCachePath(FilePath, bTempDirectory);
+				break;
+			}
+			Header = FCacheHeader();
+			Lines = FLineStore(Storage, FilePath);
+			CachedLineMetadatas.clear();
+			CachedLineTimes = FLineTimes();
+		}
+	}
+
+	FileUtils::AppendFileContents(Lines, FilePath, Header.NumCoveredBytes);
+	Lines.Finish();
+	if (Lines.IsOutOfBodyIds())
+	{
+		// Too many distinct lines to deduplicate, the cached line data still matches the lines read back as they are
+		Lines = FileUtils::ReadFileContents(FilePath, ELineStorage::Paged);
+	}
+	FLogFile LogFile(FilePath, std::move(Lines), std::move(CachedLineMetadatas), std::move(CachedLineTimes));
+
+	const bool bCacheUpToDate = !CachePath.empty() && Header.FileSize == FileSize && Header.FileModifiedTime == ModifiedTime;
+	if (FileSize >= MinCachedFileSize && !bCacheUpToDate)
+	{
+		// Extend the cache we read from, otherwise write a new one next to the log or failing that in the temp directory
+		if (CachePath.empty() || !WriteCache(CachePath, LogFile, FileSize, ModifiedTime, Header.NumBlocks))
+		{
+			if (!WriteCache(GetCachePath(FilePath, false), LogFile, FileSize, ModifiedTime, 0))
+			{
+				WriteCache(GetCachePath(FilePath, true), LogFile, FileSize, ModifiedTime, 0);
+			}
+		}
+	}
+	return LogFile;
+}
+
+}
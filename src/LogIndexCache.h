@@ -0,0 +1,16 @@
+#pragma once
+
+#include "LogFile.h"
+
+#include <string>
+
+/**
+ * Sidecar cache of the line index, metadata and line times of a log file, so reopening a large log does not scan it again.
+ * Stored next to the log as <log>.ulvindex, or in the temp directory if that is not writable.
+ * Only whole blocks of lines are cached. A log that was appended to reuses the cached blocks and only reads what is new.
+ */
+namespace LogIndexCache
+{
+	/** Opens a log file through its cache, and updates the cache if anything had to be read */
+	FLogFile OpenLogFile(const std::string& FilePath, ELineStorage Storage);
+}
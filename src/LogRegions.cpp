@@ -0,0 +1,90 @@
+#include "LogRegions.h"
+#include "Jobs.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+const std::vector<FLogRegion> FLogRegions::NoRegions;
+
+std::vector<FLogRegion> IntersectRegions(const std::vector<FLogRegion>& A, const FLogRegion* B, size_t NumB)
+{
+	std::vector<FLogRegion> Result;
+	size_t AIdx = 0, BIdx = 0;
+	while (AIdx < A.size() && BIdx < NumB)
+	{
+		const uint64_t FirstLine = std::max(A[AIdx].FirstLine, B[BIdx].FirstLine);
+		const uint64_t EndLine = std::min(A[AIdx].EndLine, B[BIdx].EndLine);
+		if (FirstLine < EndLine) Result.push_back(FLogRegion{ FirstLine, EndLine });
+		// Whichever ends first cannot overlap anything after the other
+		if (A[AIdx].EndLine < B[BIdx].EndLine) ++AIdx;
+		else ++BIdx;
+	}
+	return Result;
+}
+
+void FLogRegions::Start(const FLineStore& Lines, const FSearchQuery& StartQuery, const FSearchQuery& EndQuery, std::function<void()> OnDone)
+{
+	Cancel();
+	Scan = std::make_shared<FScan>();
+	Scan->Lines = &Lines;
+	Scan->bHasEnd = !EndQuery.Text.empty();
+	Scan->OnDone = std::move(OnDone);
+	if (!Scan->StartMatcher.Init(StartQuery) || !Scan->EndMatcher.Init(EndQuery) || StartQuery.Text.empty())
+	{
+		// Nothing matches an invalid or empty query, so there are no regions
+		Scan->bDone = true;
+		return;
+	}
+	std::shared_ptr<FScan> JobScan = Scan;
+	Jobs::Launch([JobScan]() { JobScan->Run(); });
+}
+
+void FLogRegions::Cancel()
+{
+	if (!Scan) return;
+	Scan->bCancelled = true;
+	std::unique_lock<std::mutex> Lock(Scan->Mutex);
+	Scan->Done.wait(Lock, [this]() { return Scan->bDone.load(); });
+}
+
+void FLogRegions::FScan::Run()
+{
+	ULV_PROFILE_SCOPE("FLogRegions scan");
+	const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+	bool bInRegion = false;
+	uint64_t RegionFirstLine = 0;
+	for (uint64_t BlockLine = 0; BlockLine < Lines->Num() && !bCancelled; BlockLine += FLineStore::LinesPerBlock)
+	{
+		Lines->ForEachLine(BlockLine, std::min(Lines->Num(), BlockLine + FLineStore::LinesPerBlock), [&](uint64_t LineIdx, FStringView Line)
+		{
+			if (!bInRegion)
+			{
+				bInRegion = StartMatcher.Matches(Line);
+				RegionFirstLine = LineIdx;
+			}
+			else if (bHasEnd && EndMatcher.Matches(Line))
+			{
+				Regions.push_back(FLogRegion{ RegionFirstLine, LineIdx + 1 });
+				bInRegion = false;
+			}
+			else if (!bHasEnd && StartMatcher.Matches(Line))
+			{
+				Regions.push_back(FLogRegion{ RegionFirstLine, LineIdx });
+				RegionFirstLine = LineIdx;
+			}
+		});
+	}
+	if (bInRegion) Regions.push_back(FLogRegion{ RegionFirstLine, Lines->Num() });
+	Regions.shrink_to_fit();
+	ScanMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+	ULV_PROFILE_WORK(Lines->Num(), 0);
+
+	const bool bFound = !bCancelled;
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		bDone = true;
+		Done.notify_all();
+	}
+	if (bFound && OnDone) OnDone();
+}
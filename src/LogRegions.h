@@ -0,0 +1,74 @@
+#pragma once
+
+#include "GlobalSearch.h"
+#include "LineStore.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/** Lines [FirstLine, EndLine) of a log */
+struct FLogRegion
+{
+	uint64_t FirstLine = 0;
+	uint64_t EndLine = 0;
+};
+
+/** Lines covered by both lists of sorted, disjoint regions, in one pass over both */
+std::vector<FLogRegion> IntersectRegions(const std::vector<FLogRegion>& A, const FLogRegion* B, size_t NumB);
+
+/**
+ * Regions of a log between marker lines, such as everything from "LogLoad: LoadMap" to the next "LogLoad: Took".
+ * A region starts at a line matching the start query and runs up to and including the next line matching the end query,
+ * or up to the next start if there is no end query. A region still open at the end of the log runs to its last line.
+ * The regions are found by one pass over the lines on a worker, after which filtering by them costs nothing per line.
+ */
+class FLogRegions
+{
+public:
+	~FLogRegions() { Cancel(); }
+
+	/**
+	 * Cancels any scan in progress and starts finding the regions of a file, OnDone is called from the worker once they are found.
+	 * The lines must stay put until the scan finishes or is cancelled.
+	 */
+	void Start(const FLineStore& Lines, const FSearchQuery& StartQuery, const FSearchQuery& EndQuery, std::function<void()> OnDone);
+
+	/** Stops the scan and waits until the worker is not looking at the lines, the regions are only kept if they were found */
+	void Cancel();
+
+	bool IsScanning() const { return Scan && !Scan->bDone; }
+	/** Set once the scan finishes, until the next Start */
+	bool IsFound() const { return Scan && Scan->bDone && !Scan->bCancelled; }
+	double GetScanMs() const { return Scan ? Scan->ScanMs : 0.0; }
+
+	/** Sorted and disjoint, empty until they are found */
+	const std::vector<FLogRegion>& GetRegions() const { return IsFound() ? Scan->Regions : NoRegions; }
+
+	uint64_t GetAllocatedBytes() const { return IsFound() ? Scan->Regions.capacity() * sizeof(FLogRegion) : 0; }
+
+private:
+	struct FScan
+	{
+		const FLineStore* Lines = nullptr;
+		FSearchMatcher StartMatcher;
+		FSearchMatcher EndMatcher;
+		bool bHasEnd = false;
+		std::function<void()> OnDone;
+		// Only read once bDone is set
+		std::vector<FLogRegion> Regions;
+		double ScanMs = 0.0;
+		std::atomic<bool> bCancelled{ false };
+		std::atomic<bool> bDone{ false };
+		std::mutex Mutex;
+		std::condition_variable Done;
+
+		void Run();
+	};
+
+	static const std::vector<FLogRegion> NoRegions;
+	std::shared_ptr<FScan> Scan;
+};
@@ -0,0 +1,304 @@
+#include "LogTemplates.h"
+#include "Jobs.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static uint64_t MixHash(uint64_t Hash, uint64_t Value)
+{
+	Hash = (Hash ^ (Value * 0x9E3779B97F4A7C15ull)) * 0xD6E8FEB86659FD93ull;
+	return Hash ^ (Hash >> 32);
+}
+
+/** Hashes a token 8 bytes at a time, never 0 */
+static uint64_t HashToken(const char* Text, const char* End)
+{
+	uint64_t Hash = uint64_t(End - Text);
+	for (; End - Text >= 8; Text += 8)
+	{
+		uint64_t Word;
+		memcpy(&Word, Text, 8);
+		Hash = MixHash(Hash, Word);
+	}
+	if (Text < End)
+	{
+		uint64_t Word = 0;
+		memcpy(&Word, Text, size_t(End - Text));
+		Hash = MixHash(Hash, Word);
+	}
+	return Hash | 1;
+}
+
+enum : uint8_t
+{
+	CharSpace = 1,
+	CharDigit = 2
+};
+
+struct FCharClasses
+{
+	uint8_t Classes[256] = {};
+
+	FCharClasses()
+	{
+		Classes[uint8_t(' ')] = Classes[uint8_t('\t')] = CharSpace;
+		for (char Char = '0'; Char <= '9'; ++Char) Classes[uint8_t(Char)] = CharDigit;
+	}
+};
+static const FCharClasses CharClasses;
+
+/** Calls Func(Token, Hash) for every run of characters between spaces, Hash is 0 for tokens with a digit in them */
+template<typename TFunc>
+static void ForEachToken(FStringView Text, TFunc Func)
+{
+	for (const char* It = Text.begin(), *End = Text.end(); ; )
+	{
+		while (It < End && CharClasses.Classes[uint8_t(*It)] == CharSpace) ++It;
+		if (It == End) return;
+		const char* TokenStart = It;
+		uint8_t TokenClasses = 0;
+		for (uint8_t Class; It < End && (Class = CharClasses.Classes[uint8_t(*It)]) != CharSpace; ++It)
+		{
+			TokenClasses |= Class;
+		}
+		Func(FStringView(TokenStart, size_t(It - TokenStart)), TokenClasses & CharDigit ? 0 : HashToken(TokenStart, It));
+	}
+}
+
+/** The text after the [timestamp][frame] prefix */
+static FStringView GetLineBody(FStringView Line)
+{
+	int64_t TimestampMs;
+	int Frame;
+	return ParseLinePrefix(Line.Data, Line.Size, TimestampMs, Frame) ? FStringView(Line.Data + LinePrefixSize, Line.Size - LinePrefixSize) : Line;
+}
+
+/** Lines with the same masked tokens hash the same */
+static uint64_t HashShape(FStringView Body)
+{
+	uint64_t Hash = 0;
+	uint64_t NumTokens = 0;
+	ForEachToken(Body, [&](FStringView, uint64_t TokenHash)
+	{
+		Hash = MixHash(Hash, TokenHash);
+		++NumTokens;
+	});
+	return MixHash(Hash, NumTokens);
+}
+
+void FLogTemplates::Update(const FLineStore& Lines, const std::atomic<bool>* bCancelled, std::atomic<float>* Progress)
+{
+	const uint64_t FirstLine = NumLines();
+	if (FirstLine >= Lines.Num()) return;
+	ULV_PROFILE_SCOPE("FLogTemplates::Update");
+	const auto StartTime = std::chrono::steady_clock::now();
+	LineTemplateIds.reserve(size_t(Lines.Num()));
+	const size_t FirstBlock = size_t(FirstLine >> FLineStore::LinesPerBlockLog2);
+
+	// Hashing is the first half of the work and matching the shapes in line order the second
+	auto IsCancelled = [bCancelled]() { return bCancelled && *bCancelled; };
+	std::atomic<uint64_t> NumHashed{ 0 };
+	auto AddHashed = [&](uint64_t NumDone, uint64_t NumTotal)
+	{
+		if (Progress) *Progress = 0.5f * float(NumHashed += NumDone) / float(NumTotal);
+	};
+	auto SetMatched = [&](size_t BlockIdx)
+	{
+		if (Progress) *Progress = 0.5f + 0.5f * float(BlockIdx - FirstBlock) / float(Lines.NumBlocks() - FirstBlock);
+	};
+
+	if (Lines.HasBodies())
+	{
+		// Mine each distinct body once. Body ids go up in the order the bodies first appear, so sorting keeps that order.
+		BodyTemplateIds.resize(Lines.NumBodies(), uint32_t(NoTemplate));
+		std::vector<uint32_t> NewBodies;
+		for (size_t BlockIdx = FirstBlock; BlockIdx < Lines.NumBlocks(); ++BlockIdx)
+		{
+			const uint32_t* BodyIds = Lines.GetBlockBodyIds(BlockIdx);
+			const uint64_t BlockFirstLine = uint64_t(BlockIdx) << FLineStore::LinesPerBlockLog2;
+			for (size_t LocalIdx = size_t(std::max(FirstLine, BlockFirstLine) - BlockFirstLine); LocalIdx < Lines.NumLinesInBlock(BlockIdx); ++LocalIdx)
+			{
+				const uint32_t BodyId = BodyIds[LocalIdx] & ~FLineStore::BodyIdPrefixBit;
+				if (BodyTemplateIds[BodyId] == NoTemplate) NewBodies.push_back(BodyId);
+			}
+		}
+		std::sort(NewBodies.begin(), NewBodies.end());
+		NewBodies.erase(std::unique(NewBodies.begin(), NewBodies.end()), NewBodies.end());
+
+		std::vector<uint64_t> BodyHashes(NewBodies.size());
+		Jobs::ParallelFor(NewBodies.size(), FLineStore::LinesPerBlock, [&](uint64_t Begin, uint64_t End)
+		{
+			if (IsCancelled()) return;
+			for (uint64_t Idx = Begin; Idx < End; ++Idx)
+			{
+				BodyHashes[size_t(Idx)] = HashShape(GetLineBody(Lines.GetBody(NewBodies[size_t(Idx)])));
+			}
+			AddHashed(End - Begin, NewBodies.size());
+		});
+		if (IsCancelled()) return;
+		for (size_t Idx = 0; Idx < NewBodies.size(); ++Idx)
+		{
+			auto It = ShapeTemplates.find(BodyHashes[Idx]);
+			if (It == ShapeTemplates.end())
+			{
+				It = ShapeTemplates.emplace(BodyHashes[Idx], AddShape(GetLineBody(Lines.GetBody(NewBodies[Idx])))).first;
+			}
+			BodyTemplateIds[NewBodies[Idx]] = It->second;
+		}
+
+		for (size_t BlockIdx = FirstBlock; BlockIdx < Lines.NumBlocks(); ++BlockIdx)
+		{
+			if (IsCancelled()) return;
+			SetMatched(BlockIdx);
+			const uint32_t* BodyIds = Lines.GetBlockBodyIds(BlockIdx);
+			const uint64_t BlockFirstLine = uint64_t(BlockIdx) << FLineStore::LinesPerBlockLog2;
+			for (size_t LocalIdx = size_t(std::max(FirstLine, BlockFirstLine) - BlockFirstLine); LocalIdx < Lines.NumLinesInBlock(BlockIdx); ++LocalIdx)
+			{
+				AddLine(BlockFirstLine + LocalIdx, BodyTemplateIds[BodyIds[LocalIdx] & ~FLineStore::BodyIdPrefixBit]);
+			}
+		}
+	}
+	else
+	{
+		// Hash on all workers, then match the shapes to templates in line order
+		std::vector<uint64_t> Hashes(size_t(Lines.Num() - FirstLine));
+		Jobs::ParallelFor(Lines.NumBlocks() - FirstBlock, 1, [&](uint64_t BeginBlock, uint64_t EndBlock)
+		{
+			if (IsCancelled()) return;
+			AddHashed(EndBlock - BeginBlock, Lines.NumBlocks() - FirstBlock);
+			const uint64_t BeginLine = std::max(FirstLine, uint64_t(FirstBlock + BeginBlock) << FLineStore::LinesPerBlockLog2);
+			const uint64_t EndLine = std::min(Lines.Num(), uint64_t(FirstBlock + EndBlock) << FLineStore::LinesPerBlockLog2);
+			Lines.ForEachLine(BeginLine, EndLine, [&](uint64_t LineIdx, FStringView Line)
+			{
+				Hashes[size_t(LineIdx - FirstLine)] = HashShape(GetLineBody(Line));
+			});
+		});
+		if (IsCancelled()) return;
+		for (uint64_t LineIdx = FirstLine; LineIdx < Lines.Num(); ++LineIdx)
+		{
+			if ((LineIdx & (FLineStore::LinesPerBlock - 1)) == 0)
+			{
+				if (IsCancelled()) return;
+				SetMatched(size_t(LineIdx >> FLineStore::LinesPerBlockLog2));
+			}
+			const uint64_t Hash = Hashes[size_t(LineIdx - FirstLine)];
+			auto It = ShapeTemplates.find(Hash);
+			if (It == ShapeTemplates.end())
+			{
+				It = ShapeTemplates.emplace(Hash, AddShape(GetLineBody(Lines.GetLine(LineIdx).Text))).first;
+			}
+			AddLine(LineIdx, It->second);
+		}
+	}
+
+	if (Progress) *Progress = 1.0f;
+	UpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+	ULV_PROFILE_WORK(Lines.Num() - FirstLine, 0);
+}
+
+uint32_t FLogTemplates::AddShape(FStringView Body)
+{
+	FTokens Tokens;
+	ForEachToken(Body, [&](FStringView Token, uint64_t Hash)
+	{
+		Tokens.Hashes.push_back(Hash);
+		Tokens.Texts.push_back(Hash ? Token.ToString() : std::string());
+	});
+	const size_t NumTokens = Tokens.Hashes.size();
+
+	// Join the template that most tokens match if at least half of them do, ties go to the template with more variables
+	std::vector<uint32_t>& Group = TemplateGroups[MixHash(NumTokens, NumTokens ? Tokens.Hashes[0] : 0)];
+	uint32_t BestTemplateId = NoTemplate;
+	size_t BestNumMatches = 0;
+	size_t BestNumVariables = 0;
+	for (uint32_t TemplateId : Group)
+	{
+		const std::vector<uint64_t>& Hashes = TemplateTokens[TemplateId].Hashes;
+		size_t NumMatches = 0;
+		size_t NumVariables = 0;
+		for (size_t TokenIdx = 0; TokenIdx < NumTokens; ++TokenIdx)
+		{
+			NumMatches += Hashes[TokenIdx] == Tokens.Hashes[TokenIdx];
+			NumVariables += Hashes[TokenIdx] == 0;
+		}
+		if (BestTemplateId == NoTemplate || NumMatches > BestNumMatches || (NumMatches == BestNumMatches && NumVariables > BestNumVariables))
+		{
+			BestTemplateId = TemplateId;
+			BestNumMatches = NumMatches;
+			BestNumVariables = NumVariables;
+		}
+	}
+
+	uint32_t TemplateId = BestTemplateId;
+	if (BestTemplateId != NoTemplate && BestNumMatches * 2 >= NumTokens)
+	{
+		FTokens& Template = TemplateTokens[TemplateId];
+		for (size_t TokenIdx = 0; TokenIdx < NumTokens; ++TokenIdx)
+		{
+			if (Template.Hashes[TokenIdx] != Tokens.Hashes[TokenIdx])
+			{
+				Template.Hashes[TokenIdx] = 0;
+				Template.Texts[TokenIdx].clear();
+			}
+		}
+	}
+	else
+	{
+		TemplateId = uint32_t(Templates.size());
+		Templates.emplace_back();
+		TemplateTokens.push_back(std::move(Tokens));
+		Group.push_back(TemplateId);
+	}
+
+	std::string& Text = Templates[TemplateId].Text;
+	Text.clear();
+	const FTokens& Template = TemplateTokens[TemplateId];
+	for (size_t TokenIdx = 0; TokenIdx < NumTokens; ++TokenIdx)
+	{
+		if (TokenIdx > 0) Text += ' ';
+		Text += Template.Hashes[TokenIdx] ? Template.Texts[TokenIdx] : "<*>";
+	}
+	return TemplateId;
+}
+
+void FLogTemplates::AddLine(uint64_t LineIdx, uint32_t TemplateId)
+{
+	FLogTemplate& Template = Templates[TemplateId];
+	if (Template.NumLines++ == 0) Template.FirstLine = LineIdx;
+	Template.LastLine = LineIdx;
+	LineTemplateIds.push_back(TemplateId);
+}
+
+const uint32_t* FLogTemplates::GetSparkline(uint32_t TemplateId, const FLineTimes& Times)
+{
+	const size_t NumLines = LineTemplateIds.size();
+	if (SparklineNumLines != NumLines || Sparklines.size() != Templates.size() * NumSparklineBuckets)
+	{
+		ULV_PROFILE_SCOPE("FLogTemplates sparklines");
+		Sparklines.assign(Templates.size() * NumSparklineBuckets, 0);
+		const bool bUseTimes = NumLines > 0 && Times.HasTimes() && Times.Num() >= NumLines;
+		const int64_t FirstPos = bUseTimes ? Times[0] : 0;
+		const uint64_t Span = bUseTimes ? uint64_t(Times[NumLines - 1] - FirstPos) + 1 : NumLines;
+		for (size_t LineIdx = 0; LineIdx < NumLines; ++LineIdx)
+		{
+			const uint64_t Pos = bUseTimes ? uint64_t(Times[LineIdx] - FirstPos) : LineIdx;
+			++Sparklines[LineTemplateIds[LineIdx] * size_t(NumSparklineBuckets) + size_t(Pos * NumSparklineBuckets / Span)];
+		}
+		SparklineNumLines = NumLines;
+	}
+	return Sparklines.data() + TemplateId * size_t(NumSparklineBuckets);
+}
+
+uint64_t FLogTemplates::GetAllocatedBytes() const
+{
+	uint64_t NumBytes = (LineTemplateIds.capacity() + BodyTemplateIds.capacity() + Sparklines.capacity()) * sizeof(uint32_t);
+	NumBytes += Templates.capacity() * sizeof(FLogTemplate) + TemplateTokens.capacity() * sizeof(FTokens);
+	for (const FTokens& Tokens : TemplateTokens)
+	{
+		NumBytes += Tokens.Hashes.capacity() * sizeof(uint64_t) + Tokens.Texts.capacity() * sizeof(std::string);
+	}
+	NumBytes += ShapeTemplates.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void*));
+	return NumBytes;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "LineStore.h"
+#include "LineTimes.h"
+#include "StringView.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Message shape shared by many lines, with "<*>" where their variables go */
+struct FLogTemplate
+{
+	std::string Text;
+	uint64_t NumLines = 0;
+	uint64_t FirstLine = 0;
+	uint64_t LastLine = 0;
+};
+
+/**
+ * Template of every line of a log, mined the way Drain does.
+ * Lines are split into tokens at spaces and tokens with a digit in them are masked as variables, which runs on all workers.
+ * Lines whose masked tokens are the same have the same shape, and each new shape joins the template with as many tokens
+ * and the same first token that most of its tokens match, with the tokens that differ becoming variables.
+ * The [timestamp][frame] prefix is left out.
+ */
+class FLogTemplates
+{
+public:
+	static const uint32_t NoTemplate = UINT32_MAX;
+	static const int NumSparklineBuckets = 64;
+
+	/**
+	 * Mines the lines added since the last update, templates keep their ids as more lines join them.
+	 * Progress is set to the fraction of the new lines mined as it goes. Once bCancelled is set it stops early
+	 * and leaves the templates half updated, to be thrown away.
+	 */
+	void Update(const FLineStore& Lines, const std::atomic<bool>* bCancelled = nullptr, std::atomic<float>* Progress = nullptr);
+
+	uint64_t NumLines() const { return LineTemplateIds.size(); }
+	uint32_t Num() const { return uint32_t(Templates.size()); }
+	const FLogTemplate& operator[](uint32_t TemplateId) const { return Templates[TemplateId]; }
+
+	/** NoTemplate for lines that have not been mined yet */
+	uint32_t GetLineTemplate(uint64_t LineIdx) const { return LineIdx < LineTemplateIds.size() ? LineTemplateIds[size_t(LineIdx)] : NoTemplate; }
+
+	/**
+	 * Lines of a template in each of NumSparklineBuckets slices of the time the log spans, or of its lines if it has no times.
+	 * The sparklines of every template are counted in one pass the first time they are asked for after an update.
+	 */
+	const uint32_t* GetSparkline(uint32_t TemplateId, const FLineTimes& Times);
+
+	double GetUpdateMs() const { return UpdateMs; }
+	uint64_t GetAllocatedBytes() const;
+
+private:
+	struct FTokens
+	{
+		// Hash of each token, 0 for variables
+		std::vector<uint64_t> Hashes;
+		std::vector<std::string> Texts;
+	};
+
+	uint32_t AddShape(FStringView Body);
+	void AddLine(uint64_t LineIdx, uint32_t TemplateId);
+
+	std::vector<FLogTemplate> Templates;
+	std::vector<FTokens> TemplateTokens;
+	std::vector<uint32_t> LineTemplateIds;
+	// Template of each shape hash
+	std::unordered_map<uint64_t, uint32_t> ShapeTemplates;
+	// Templates with the same number of tokens and first token
+	std::unordered_map<uint64_t, std::vector<uint32_t>> TemplateGroups;
+	// Template of each distinct body, with deduplicated storage
+	std::vector<uint32_t> BodyTemplateIds;
+	double UpdateMs = 0.0;
+
+	std::vector<uint32_t> Sparklines;
+	uint64_t SparklineNumLines = 0;
+};
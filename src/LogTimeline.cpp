@@ -0,0 +1,93 @@
+#include "LogTimeline.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <numeric>
+
+const char* ETimelineStackStrings[(int)ETimelineStack::MAX + 1] =
+{
+	"Verbosity",
+	"Category"
+};
+
+uint32_t FLogTimeline::FindCategory(FStringView Body)
+{
+	size_t NameSize = 0;
+	while (NameSize < Body.Size && (isalnum((unsigned char)Body[NameSize]) || Body[NameSize] == '_')) ++NameSize;
+	if (NameSize == 0 || NameSize == Body.Size || Body[NameSize] != ':') return NoCategory;
+
+	// Lines of the same category tend to come together
+	if (LastCategory != NoCategory)
+	{
+		const std::string& Name = CategoryNames[LastCategory];
+		if (Name.size() == NameSize && memcmp(Name.data(), Body.Data, NameSize) == 0) return LastCategory;
+	}
+	LookupName.assign(Body.Data, NameSize);
+	auto It = CategoryIds.find(LookupName);
+	if (It == CategoryIds.end())
+	{
+		It = CategoryIds.emplace(LookupName, uint32_t(CategoryNames.size())).first;
+		CategoryNames.push_back(LookupName);
+		CategoryTotals.push_back(0);
+	}
+	return LastCategory = It->second;
+}
+
+void FLogTimeline::AddLine(ELevel Level, uint32_t Category)
+{
+	AddedLines.push_back((Category == NoCategory ? 0 : (Category + 1) * NumLevels) + Level);
+	if (Category != NoCategory) ++CategoryTotals[Category];
+	++NumAddedLines;
+}
+
+void FLogTimeline::Finish()
+{
+	// The categories with the most lines get a series each
+	std::vector<uint32_t> Categories(CategoryNames.size());
+	std::iota(Categories.begin(), Categories.end(), 0);
+	const size_t NumCounted = std::min<size_t>(Categories.size(), MaxCategories);
+	std::partial_sort(Categories.begin(), Categories.begin() + NumCounted, Categories.end(), [this](uint32_t A, uint32_t B) { return CategoryTotals[A] > CategoryTotals[B]; });
+	CategorySeries.assign(CategoryNames.size(), uint8_t(OtherSeries));
+	for (size_t Idx = 0; Idx < NumCounted; ++Idx)
+	{
+		CategorySeries[Categories[Idx]] = uint8_t(Idx);
+	}
+
+	Steps.clear();
+	std::fill(Totals, Totals + NumSeries, 0);
+	for (size_t LineIdx = 0; LineIdx < AddedLines.size(); ++LineIdx)
+	{
+		if ((LineIdx & (LinesPerStep - 1)) == 0)
+		{
+			Steps.insert(Steps.end(), Totals, Totals + NumSeries);
+		}
+		const uint32_t Line = AddedLines[LineIdx];
+		++Totals[Line % NumLevels];
+		++Totals[NumLevels + (Line < NumLevels ? OtherSeries : CategorySeries[Line / NumLevels - 1])];
+	}
+	std::vector<uint32_t>().swap(AddedLines);
+}
+
+double FLogTimeline::GetCount(int Series, uint64_t LineIdx) const
+{
+	if (LineIdx >= NumAddedLines) return double(Totals[Series]);
+
+	const size_t StepIdx = size_t(LineIdx >> LinesPerStepLog2);
+	const uint64_t StepFirstLine = uint64_t(StepIdx) << LinesPerStepLog2;
+	const uint32_t StepCount = Steps[StepIdx * NumSeries + Series];
+	const bool bLastStep = (StepIdx + 1) * NumSeries == Steps.size();
+	const uint32_t NextStepCount = bLastStep ? uint32_t(Totals[Series]) : Steps[(StepIdx + 1) * NumSeries + Series];
+	const uint64_t NumStepLines = bLastStep ? NumAddedLines - StepFirstLine : LinesPerStep;
+	return StepCount + double(NextStepCount - StepCount) * double(LineIdx - StepFirstLine) / double(NumStepLines);
+}
+
+uint64_t FLogTimeline::GetAllocatedBytes() const
+{
+	uint64_t Bytes = (AddedLines.capacity() + Steps.capacity()) * sizeof(uint32_t) + CategoryTotals.capacity() * sizeof(uint64_t) + CategorySeries.capacity();
+	for (const std::string& Name : CategoryNames)
+	{
+		Bytes += Name.capacity();
+	}
+	return Bytes;
+}
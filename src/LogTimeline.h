@@ -0,0 +1,78 @@
+#pragma once
+
+#include "StringView.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class ETimelineStack : int
+{
+	Verbosity = 0,
+	Category,
+	MAX
+};
+
+extern const char* ETimelineStackStrings[(int)ETimelineStack::MAX + 1];
+
+/**
+ * Number of lines of each verbosity and category before any line, for drawing how much a log says over time.
+ * Running totals are kept at every LinesPerStep lines and interpolated in between,
+ * so counting the lines of a range costs the same however many lines it spans.
+ * Every category is counted, and once every line is added the MaxCategories with the most lines get running totals.
+ */
+class FLogTimeline
+{
+public:
+	enum ELevel { Error, Warning, Log, NumLevels };
+
+	static const int LinesPerStepLog2 = 8;
+	static const int LinesPerStep = 1 << LinesPerStepLog2;
+	// Categories with running totals, the lines of the others are counted with the lines without one
+	static const int MaxCategories = 31;
+	static const uint32_t NoCategory = UINT32_MAX;
+
+	/** Category a line body starts with, "LogNet" for "LogNet: Warning: ...", which is added if it is new. NoCategory if there is none. */
+	uint32_t FindCategory(FStringView Body);
+
+	/** Lines are added in order, then Finish works out the running totals once, after the last one */
+	void AddLine(ELevel Level, uint32_t Category);
+	void Finish();
+
+	uint64_t NumLines() const { return NumAddedLines; }
+	int NumCategories() const { return int(CategoryNames.size()); }
+	const std::string& GetCategoryName(int Category) const { return CategoryNames[Category]; }
+	uint64_t GetCategoryTotal(int Category) const { return CategoryTotals[Category]; }
+	/** True for the MaxCategories categories with the most lines */
+	bool HasCategoryCounts(int Category) const { return CategorySeries[Category] != OtherSeries; }
+
+	/** Lines before LineIdx at a level */
+	double GetLevelCount(ELevel Level, uint64_t LineIdx) const { return GetCount(Level, LineIdx); }
+	/** Lines before LineIdx of a category with counts */
+	double GetCategoryCount(int Category, uint64_t LineIdx) const { return GetCount(NumLevels + CategorySeries[Category], LineIdx); }
+
+	uint64_t GetAllocatedBytes() const;
+
+private:
+	static const uint8_t OtherSeries = MaxCategories;
+	static const int NumSeries = NumLevels + MaxCategories + 1;
+
+	double GetCount(int Series, uint64_t LineIdx) const;
+
+	// Level and category of each line until Finish, as (Category + 1) * NumLevels + Level, or just Level without a category
+	std::vector<uint32_t> AddedLines;
+	// Totals of every series at the first line of each step
+	std::vector<uint32_t> Steps;
+	uint64_t Totals[NumSeries] = {};
+	uint64_t NumAddedLines = 0;
+
+	std::vector<std::string> CategoryNames;
+	std::vector<uint64_t> CategoryTotals;
+	// Series of each category, OtherSeries for the ones without counts
+	std::vector<uint8_t> CategorySeries;
+	std::unordered_map<std::string, uint32_t> CategoryIds;
+	// Name being looked up, kept to reuse its memory
+	std::string LookupName;
+	uint32_t LastCategory = NoCategory;
+};
@@ -0,0 +1,205 @@
+#include "Lz4.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+static int CountTrailingZeros(uint64_t Value) { unsigned long Idx; _BitScanForward64(&Idx, Value); return int(Idx); }
+#else
+static int CountTrailingZeros(uint64_t Value) { return __builtin_ctzll(Value); }
+#endif
+
+namespace Lz4
+{
+
+static const int MinMatch = 4;
+// The format requires the last 5 bytes to be literals and the last match to start at least 12 bytes from the end
+static const int LastLiterals = 5;
+static const int MatchFindLimit = 12;
+static const int MaxOffset = 65535;
+static const int HashLog = 14;
+
+static uint32_t Read32(const uint8_t* Ptr) { uint32_t Value; memcpy(&Value, Ptr, sizeof(Value)); return Value; }
+static uint64_t Read64(const uint8_t* Ptr) { uint64_t Value; memcpy(&Value, Ptr, sizeof(Value)); return Value; }
+static uint32_t Hash(uint32_t Sequence) { return (Sequence * 2654435761u) >> (32 - HashLog); }
+
+/** Number of equal bytes at A and B, not reading past Limit */
+static size_t CountMatch(const uint8_t* A, const uint8_t* B, const uint8_t* Limit)
+{
+	const uint8_t* Start = A;
+	while (A + 8 <= Limit)
+	{
+		// Little endian, the lowest differing bit is in the first differing byte
+		const uint64_t Diff = Read64(A) ^ Read64(B);
+		if (Diff) return (A - Start) + CountTrailingZeros(Diff) / 8;
+		A += 8;
+		B += 8;
+	}
+	while (A < Limit && *A == *B)
+	{
+		++A;
+		++B;
+	}
+	return A - Start;
+}
+
+static uint8_t* WriteLength(uint8_t* Op, size_t Length)
+{
+	for (; Length >= 255; Length -= 255) *Op++ = 255;
+	*Op++ = uint8_t(Length);
+	return Op;
+}
+
+static uint8_t* WriteSequence(uint8_t* Op, const uint8_t* Literals, size_t NumLiterals, size_t Offset, size_t MatchLength)
+{
+	uint8_t* Token = Op++;
+	*Token = uint8_t(NumLiterals >= 15 ? 15 << 4 : NumLiterals << 4);
+	if (NumLiterals >= 15) Op = WriteLength(Op, NumLiterals - 15);
+	memcpy(Op, Literals, NumLiterals);
+	Op += NumLiterals;
+
+	// The last sequence is literals only
+	if (MatchLength == 0) return Op;
+
+	*Op++ = uint8_t(Offset);
+	*Op++ = uint8_t(Offset >> 8);
+	const size_t Length = MatchLength - MinMatch;
+	*Token |= uint8_t(Length >= 15 ? 15 : Length);
+	if (Length >= 15) Op = WriteLength(Op, Length - 15);
+	return Op;
+}
+
+size_t GetMaxCompressedSize(size_t SrcSize)
+{
+	return SrcSize + SrcSize / 255 + 16;
+}
+
+size_t Compress(const char* InSrc, size_t SrcSize, char* InDst)
+{
+	const uint8_t* const Src = (const uint8_t*)InSrc;
+	const uint8_t* const End = Src + SrcSize;
+	const uint8_t* Ip = Src;
+	const uint8_t* Anchor = Src;
+	uint8_t* Op = (uint8_t*)InDst;
+
+	// Empty input is a single token with no literals, and may come without a buffer to copy from
+	if (SrcSize == 0)
+	{
+		*Op = 0;
+		return 1;
+	}
+
+	if (SrcSize > MatchFindLimit)
+	{
+		std::unique_ptr<uint32_t[]> HashTable(new uint32_t[1 << HashLog]());
+		const uint8_t* const MatchLimit = End - LastLiterals;
+		const uint8_t* const MatchFindEnd = End - MatchFindLimit;
+		while (Ip < MatchFindEnd)
+		{
+			const uint32_t Sequence = Read32(Ip);
+			uint32_t& Entry = HashTable[Hash(Sequence)];
+			const uint8_t* Candidate = Src + Entry;
+			Entry = uint32_t(Ip - Src);
+			if (Candidate >= Ip || Ip - Candidate > MaxOffset || Read32(Candidate) != Sequence)
+			{
+				// Skip ahead faster the longer we go without a match
+				Ip += 1 + ((Ip - Anchor) >> 6);
+				continue;
+			}
+
+			while (Ip > Anchor && Candidate > Src && Ip[-1] == Candidate[-1])
+			{
+				--Ip;
+				--Candidate;
+			}
+			const size_t MatchLength = MinMatch + CountMatch(Ip + MinMatch, Candidate + MinMatch, MatchLimit);
+			Op = WriteSequence(Op, Anchor, Ip - Anchor, Ip - Candidate, MatchLength);
+			Ip += MatchLength;
+			Anchor = Ip;
+			if (Ip < MatchFindEnd)
+			{
+				HashTable[Hash(Read32(Ip - 2))] = uint32_t(Ip - 2 - Src);
+			}
+		}
+	}
+
+	Op = WriteSequence(Op, Anchor, End - Anchor, 0, 0);
+	return Op - (uint8_t*)InDst;
+}
+
+bool Decompress(const char* InSrc, size_t SrcSize, char* InDst, size_t DstSize)
+{
+	const uint8_t* Ip = (const uint8_t*)InSrc;
+	const uint8_t* const IEnd = Ip + SrcSize;
+	uint8_t* const Dst = (uint8_t*)InDst;
+	uint8_t* Op = Dst;
+	uint8_t* const OEnd = Dst + DstSize;
+	if (DstSize == 0) return SrcSize == 1 && *Ip == 0;
+
+	auto ReadLength = [&Ip, IEnd](size_t& InOutLength)
+	{
+		uint8_t Byte;
+		do
+		{
+			if (Ip >= IEnd) return false;
+			Byte = *Ip++;
+			InOutLength += Byte;
+		} while (Byte == 255);
+		return true;
+	};
+
+	for (;;)
+	{
+		if (Ip >= IEnd) return false;
+		const uint8_t Token = *Ip++;
+
+		size_t NumLiterals = Token >> 4;
+		if (NumLiterals == 15 && !ReadLength(NumLiterals)) return false;
+		if (NumLiterals > size_t(IEnd - Ip) || NumLiterals > size_t(OEnd - Op)) return false;
+		if (NumLiterals <= 16 && IEnd - Ip >= 16 && OEnd - Op >= 16)
+		{
+			// Copying a fixed size is much faster than a variable one, the extra bytes get overwritten
+			memcpy(Op, Ip, 16);
+		}
+		else
+		{
+			memcpy(Op, Ip, NumLiterals);
+		}
+		Op += NumLiterals;
+		Ip += NumLiterals;
+		if (Ip == IEnd) return Op == OEnd;
+
+		if (IEnd - Ip < 2) return false;
+		const size_t Offset = Ip[0] | (Ip[1] << 8);
+		Ip += 2;
+		if (Offset == 0 || Offset > size_t(Op - Dst)) return false;
+
+		size_t MatchLength = Token & 15;
+		if (MatchLength == 15 && !ReadLength(MatchLength)) return false;
+		MatchLength += MinMatch;
+		if (MatchLength > size_t(OEnd - Op)) return false;
+
+		const uint8_t* Match = Op - Offset;
+		if (Offset >= 8 && size_t(OEnd - Op) >= MatchLength + 8)
+		{
+			// Each 8 byte chunk only reads bytes that are already final, since the match is at least 8 bytes back
+			uint8_t* const MatchEnd = Op + MatchLength;
+			for (uint8_t* Out = Op; Out < MatchEnd; Out += 8, Match += 8) memcpy(Out, Match, 8);
+			Op = MatchEnd;
+		}
+		else if (Offset >= MatchLength)
+		{
+			memcpy(Op, Match, MatchLength);
+			Op += MatchLength;
+		}
+		else
+		{
+			// Overlapping copy repeats the last Offset bytes
+			for (size_t Idx = 0; Idx < MatchLength; ++Idx) *Op++ = *Match++;
+		}
+	}
+}
+
+}
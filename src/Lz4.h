@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+// Compressor and decompressor for the LZ4 block format, used to keep cold log text compressed in memory.
+
+namespace Lz4
+{
+	/** Size of the output buffer Compress needs in the worst case */
+	size_t GetMaxCompressedSize(size_t SrcSize);
+
+	/** Returns the compressed size, Dst must hold at least GetMaxCompressedSize(SrcSize) bytes */
+	size_t Compress(const char* Src, size_t SrcSize, char* Dst);
+
+	/** Returns false if the data is corrupt or does not decompress to exactly DstSize bytes */
+	bool Decompress(const char* Src, size_t SrcSize, char* Dst, size_t DstSize);
+}
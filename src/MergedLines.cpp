@@ -0,0 +1,144 @@
+#include "MergedLines.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+FMergedRow FMergedLines::FCursor::operator*() const
+{
+	FMergedRow Row;
+	Row.SourceIdx = CurrentSource;
+	Row.LineIdx = (*Merged->SourceDisplayLines[CurrentSource])[SourceRows[CurrentSource]];
+	return Row;
+}
+
+void FMergedLines::FCursor::Next()
+{
+	const uint64_t SourceRow = ++SourceRows[CurrentSource];
+	if (SourceRow < Merged->SourceDisplayLines[CurrentSource]->Num())
+	{
+		SourceTimes[CurrentSource] = Merged->GetRowTime(CurrentSource, SourceRow);
+	}
+	PickCurrentSource();
+}
+
+void FMergedLines::FCursor::PickCurrentSource()
+{
+	// Ties go to the earlier source, a linear scan beats a heap for the handful of files we merge
+	CurrentSource = -1;
+	for (size_t SourceIdx = 0; SourceIdx < SourceRows.size(); ++SourceIdx)
+	{
+		if (SourceRows[SourceIdx] < Merged->SourceDisplayLines[SourceIdx]->Num()
+			&& (CurrentSource < 0 || SourceTimes[SourceIdx] < SourceTimes[CurrentSource]))
+		{
+			CurrentSource = int(SourceIdx);
+		}
+	}
+}
+
+void FMergedLines::SetSources(const std::vector<const FLogFile*>& InSources)
+{
+	Sources = InSources;
+	SourceDisplayLines.clear();
+	NumRows = 0;
+	for (const FLogFile* Source : Sources)
+	{
+		SourceDisplayLines.push_back(&Source->GetDisplayLines());
+		NumRows += SourceDisplayLines.back()->Num();
+	}
+}
+
+int64_t FMergedLines::GetRowTime(size_t SourceIdx, uint64_t SourceRow) const
+{
+	return Sources[SourceIdx]->LineTimes[(*SourceDisplayLines[SourceIdx])[SourceRow]];
+}
+
+uint64_t FMergedLines::CountRowsUntil(size_t SourceIdx, int64_t TimeMs) const
+{
+	uint64_t Lo = 0, Hi = SourceDisplayLines[SourceIdx]->Num();
+	while (Lo < Hi)
+	{
+		const uint64_t Mid = Lo + (Hi - Lo) / 2;
+		if (GetRowTime(SourceIdx, Mid) <= TimeMs) Lo = Mid + 1;
+		else Hi = Mid;
+	}
+	return Lo;
+}
+
+FMergedLines::FCursor FMergedLines::Seek(uint64_t Row) const
+{
+	ULV_PROFILE_SCOPE("FMergedLines::Seek");
+	FCursor Cursor;
+	Cursor.Merged = this;
+	Cursor.SourceRows.resize(Sources.size());
+	Cursor.SourceTimes.resize(Sources.size());
+	if (Row >= NumRows) return Cursor;
+
+	// Find the time of the row, the earliest time that more than Row rows are at or before
+	int64_t LoTime = INT64_MAX, HiTime = INT64_MIN;
+	for (size_t SourceIdx = 0; SourceIdx < Sources.size(); ++SourceIdx)
+	{
+		const uint64_t NumSourceRows = SourceDisplayLines[SourceIdx]->Num();
+		if (NumSourceRows == 0) continue;
+		LoTime = std::min(LoTime, GetRowTime(SourceIdx, 0));
+		HiTime = std::max(HiTime, GetRowTime(SourceIdx, NumSourceRows - 1));
+	}
+	while (LoTime < HiTime)
+	{
+		const int64_t MidTime = LoTime + int64_t((uint64_t(HiTime) - uint64_t(LoTime)) / 2);
+		uint64_t NumRowsUntil = 0;
+		for (size_t SourceIdx = 0; SourceIdx < Sources.size(); ++SourceIdx)
+		{
+			NumRowsUntil += CountRowsUntil(SourceIdx, MidTime);
+		}
+		if (NumRowsUntil > Row) HiTime = MidTime;
+		else LoTime = MidTime + 1;
+	}
+
+	// Start every source at its first row at that time, then hand out the remaining rows at that time in source order
+	uint64_t NumRowsBefore = 0;
+	for (size_t SourceIdx = 0; SourceIdx < Sources.size(); ++SourceIdx)
+	{
+		Cursor.SourceRows[SourceIdx] = LoTime == INT64_MIN ? 0 : CountRowsUntil(SourceIdx, LoTime - 1);
+		NumRowsBefore += Cursor.SourceRows[SourceIdx];
+	}
+	uint64_t NumRemainingRows = Row - NumRowsBefore;
+	for (size_t SourceIdx = 0; SourceIdx < Sources.size(); ++SourceIdx)
+	{
+		const uint64_t NumRowsAtTime = CountRowsUntil(SourceIdx, LoTime) - Cursor.SourceRows[SourceIdx];
+		const uint64_t NumSkippedRows = std::min(NumRemainingRows, NumRowsAtTime);
+		Cursor.SourceRows[SourceIdx] += NumSkippedRows;
+		NumRemainingRows -= NumSkippedRows;
+	}
+
+	for (size_t SourceIdx = 0; SourceIdx < Sources.size(); ++SourceIdx)
+	{
+		if (Cursor.SourceRows[SourceIdx] < SourceDisplayLines[SourceIdx]->Num())
+		{
+			Cursor.SourceTimes[SourceIdx] = GetRowTime(SourceIdx, Cursor.SourceRows[SourceIdx]);
+		}
+	}
+	Cursor.PickCurrentSource();
+	return Cursor;
+}
+
+uint64_t FMergedLines::FindTimeRow(int64_t TimeMs) const
+{
+	uint64_t Row = 0;
+	for (const FLogFile* Source : Sources)
+	{
+		Row += Source->FindDisplayRow(TimeMs);
+	}
+	return Row;
+}
+
+uint64_t FMergedLines::FindRow(int SourceIdx, uint64_t SourceRow) const
+{
+	const int64_t TimeMs = GetRowTime(SourceIdx, SourceRow);
+	uint64_t Row = SourceRow;
+	for (size_t OtherIdx = 0; OtherIdx < Sources.size(); ++OtherIdx)
+	{
+		if (int(OtherIdx) < SourceIdx) Row += CountRowsUntil(OtherIdx, TimeMs);
+		else if (int(OtherIdx) > SourceIdx && TimeMs != INT64_MIN) Row += CountRowsUntil(OtherIdx, TimeMs - 1);
+	}
+	return Row;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "LogFile.h"
+
+#include <cstdint>
+#include <vector>
+
+struct FMergedRow
+{
+	int SourceIdx = 0;
+	uint64_t LineIdx = 0;
+};
+
+/**
+ * Display lines of several log files interleaved by time, without copying any of them.
+ * Rows are ordered by line time, then by source, then by display row. The rows before a given row are
+ * counted by binary searching the time column of every source, and the rows after it come from a
+ * lazy k-way merge, so only the rows that are shown are ever visited.
+ */
+class FMergedLines
+{
+public:
+	/** Walks the merged rows in order */
+	class FCursor
+	{
+	public:
+		bool IsValid() const { return CurrentSource >= 0; }
+		FMergedRow operator*() const;
+		void Next();
+
+	private:
+		friend class FMergedLines;
+		void PickCurrentSource();
+
+		const FMergedLines* Merged = nullptr;
+		// Next display row of every source, and the time of the line on it
+		std::vector<uint64_t> SourceRows;
+		std::vector<int64_t> SourceTimes;
+		int CurrentSource = -1;
+	};
+
+	/** Call whenever the files or their filters may have changed, the files must outlive any cursors */
+	void SetSources(const std::vector<const FLogFile*>& InSources);
+
+	uint64_t Num() const { return NumRows; }
+	size_t NumSources() const { return Sources.size(); }
+	const FLogFile& GetSource(int SourceIdx) const { return *Sources[SourceIdx]; }
+
+	/** Cursor at a merged row, O(k log n log t) for k sources of n rows spanning t milliseconds */
+	FCursor Seek(uint64_t Row) const;
+
+	/** First merged row at or after a time */
+	uint64_t FindTimeRow(int64_t TimeMs) const;
+
+	/** Merged row a display row of one of the sources ends up on */
+	uint64_t FindRow(int SourceIdx, uint64_t SourceRow) const;
+
+private:
+	int64_t GetRowTime(size_t SourceIdx, uint64_t SourceRow) const;
+
+	/** Number of display rows of a source at or before a time */
+	uint64_t CountRowsUntil(size_t SourceIdx, int64_t TimeMs) const;
+
+	std::vector<const FLogFile*> Sources;
+	std::vector<const FDisplayLines*> SourceDisplayLines;
+	uint64_t NumRows = 0;
+};
@@ -0,0 +1,346 @@
+#include "Profiler.h"
+
+#if ULV_WITH_PROFILER
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace Profiler
+{
+
+// Each thread writes into its own slot so that worker threads never contend on a cache line
+static const int NumThreadSlots = 64;
+
+struct FStatSlot
+{
+	std::atomic<uint64_t> TimeNs;
+	std::atomic<uint64_t> Calls;
+	std::atomic<uint64_t> Count;
+	char Padding[64 - 3 * sizeof(std::atomic<uint64_t>)];
+};
+
+struct FStat
+{
+	const char* Name = nullptr;
+	FStatSlot Slots[NumThreadSlots];
+
+	std::atomic<uint64_t> LastRunNs;
+	std::atomic<uint64_t> LastRunLines;
+	std::atomic<uint64_t> LastRunBytes;
+
+	// Only touched by the main thread in EndFrame
+	uint64_t PrevTimeNs = 0;
+	uint64_t PrevCalls = 0;
+	uint64_t PrevCount = 0;
+	float HistoryMs[NumFrameHistory] = {};
+	FStatSnapshot Snapshot;
+};
+
+static std::mutex StatsMutex;
+static std::vector<FStat*> Stats;
+
+static std::mutex JobsMutex;
+static std::vector<FJob*> Jobs;
+
+static float FrameHistoryMs[NumFrameHistory] = {};
+static int FrameHistoryOffset = 0;
+
+static std::atomic<int> NextThreadSlot(0);
+static thread_local int ThreadSlot = NextThreadSlot++ % NumThreadSlots;
+static thread_local FScope* CurrentScope = nullptr;
+
+struct FTraceEvent
+{
+	const char* Name;
+	uint64_t StartNs;
+	uint64_t DurationNs;
+};
+
+/** Single producer ring buffer owned by one thread. Old events are overwritten once it is full. */
+struct FTraceBuffer
+{
+	static const uint64_t NumEvents = 1 << 16;
+
+	int ThreadId = 0;
+	std::string ThreadName;
+	std::atomic<uint64_t> WriteIdx;
+	FTraceEvent Events[NumEvents];
+
+	FTraceBuffer() : WriteIdx(0) {}
+
+	void Push(const FTraceEvent& Event)
+	{
+		const uint64_t Idx = WriteIdx.load(std::memory_order_relaxed);
+		Events[Idx % NumEvents] = Event;
+		WriteIdx.store(Idx + 1, std::memory_order_release);
+	}
+};
+
+static std::atomic<bool> bTraceEnabled(false);
+static const uint64_t TraceStartNs = GetTimeNs();
+static std::mutex TraceBuffersMutex;
+static std::vector<std::unique_ptr<FTraceBuffer>> TraceBuffers;
+static thread_local FTraceBuffer* ThreadTraceBuffer = nullptr;
+static thread_local std::string ThreadName;
+
+static FTraceBuffer& GetThreadTraceBuffer()
+{
+	if (!ThreadTraceBuffer)
+	{
+		std::lock_guard<std::mutex> Lock(TraceBuffersMutex);
+		TraceBuffers.emplace_back(new FTraceBuffer());
+		ThreadTraceBuffer = TraceBuffers.back().get();
+		ThreadTraceBuffer->ThreadId = (int)TraceBuffers.size();
+		ThreadTraceBuffer->ThreadName = !ThreadName.empty() ? ThreadName : "Thread " + std::to_string(TraceBuffers.size());
+	}
+	return *ThreadTraceBuffer;
+}
+
+static void RecordTraceEvent(const char* Name, uint64_t StartNs, uint64_t DurationNs)
+{
+	if (bTraceEnabled.load(std::memory_order_relaxed))
+	{
+		GetThreadTraceBuffer().Push(FTraceEvent{ Name, StartNs, DurationNs });
+	}
+}
+
+FStat* RegisterStat(const char* Name)
+{
+	std::lock_guard<std::mutex> Lock(StatsMutex);
+	for (FStat* Stat : Stats)
+	{
+		if (strcmp(Stat->Name, Name) == 0) return Stat;
+	}
+
+	// Value initialisation zeroes the atomics
+	FStat* Stat = new FStat();
+	Stat->Name = Name;
+	Stat->Snapshot.Name = Name;
+	Stats.push_back(Stat);
+	return Stat;
+}
+
+uint64_t GetTimeNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FScope::FScope(FStat* InStat)
+	: Stat(InStat)
+	, Parent(CurrentScope)
+	, StartNs(GetTimeNs())
+{
+	CurrentScope = this;
+}
+
+FScope::~FScope()
+{
+	const uint64_t ElapsedNs = GetTimeNs() - StartNs;
+	RecordTraceEvent(Stat->Name, StartNs, ElapsedNs);
+	FStatSlot& Slot = Stat->Slots[ThreadSlot];
+	Slot.TimeNs.fetch_add(ElapsedNs, std::memory_order_relaxed);
+	Slot.Calls.fetch_add(1, std::memory_order_relaxed);
+	if (NumLines || NumBytes)
+	{
+		Slot.Count.fetch_add(NumLines, std::memory_order_relaxed);
+		Stat->LastRunNs.store(ElapsedNs, std::memory_order_relaxed);
+		Stat->LastRunLines.store(NumLines, std::memory_order_relaxed);
+		Stat->LastRunBytes.store(NumBytes, std::memory_order_relaxed);
+	}
+	CurrentScope = Parent;
+}
+
+void FScope::AddWork(uint64_t NumLines, uint64_t NumBytes)
+{
+	if (FScope* Scope = CurrentScope)
+	{
+		Scope->NumLines += NumLines;
+		Scope->NumBytes += NumBytes;
+	}
+}
+
+void AddCount(FStat* Stat, uint64_t Count)
+{
+	Stat->Slots[ThreadSlot].Count.fetch_add(Count, std::memory_order_relaxed);
+}
+
+FJob::FJob(const std::string& InName)
+	: Name(InName)
+	, Done(0)
+	, Total(0)
+{
+	std::lock_guard<std::mutex> Lock(JobsMutex);
+	Jobs.push_back(this);
+}
+
+FJob::~FJob()
+{
+	std::lock_guard<std::mutex> Lock(JobsMutex);
+	Jobs.erase(std::find(Jobs.begin(), Jobs.end(), this));
+}
+
+void FJob::SetProgress(uint64_t InDone, uint64_t InTotal)
+{
+	Done.store(InDone, std::memory_order_relaxed);
+	Total.store(InTotal, std::memory_order_relaxed);
+}
+
+void EndFrame(uint64_t FrameStartNs)
+{
+	const uint64_t FrameNs = GetTimeNs() - FrameStartNs;
+	RecordTraceEvent("Frame", FrameStartNs, FrameNs);
+
+	FrameHistoryMs[FrameHistoryOffset] = FrameNs / 1e6f;
+	const int HistoryIdx = FrameHistoryOffset;
+	FrameHistoryOffset = (FrameHistoryOffset + 1) % NumFrameHistory;
+
+	std::lock_guard<std::mutex> Lock(StatsMutex);
+	for (FStat* Stat : Stats)
+	{
+		uint64_t TimeNs = 0, Calls = 0, Count = 0;
+		for (const FStatSlot& Slot : Stat->Slots)
+		{
+			TimeNs += Slot.TimeNs.load(std::memory_order_relaxed);
+			Calls += Slot.Calls.load(std::memory_order_relaxed);
+			Count += Slot.Count.load(std::memory_order_relaxed);
+		}
+
+		FStatSnapshot& Snapshot = Stat->Snapshot;
+		Snapshot.FrameMs = (TimeNs - Stat->PrevTimeNs) / 1e6;
+		Snapshot.FrameCalls = Calls - Stat->PrevCalls;
+		Snapshot.FrameCount = Count - Stat->PrevCount;
+		Snapshot.TotalCount = Count;
+		Stat->PrevTimeNs = TimeNs;
+		Stat->PrevCalls = Calls;
+		Stat->PrevCount = Count;
+
+		Stat->HistoryMs[HistoryIdx] = (float)Snapshot.FrameMs;
+		double SumMs = 0.0;
+		Snapshot.MaxMs = 0.0;
+		for (float HistoryMs : Stat->HistoryMs)
+		{
+			SumMs += HistoryMs;
+			Snapshot.MaxMs = std::max(Snapshot.MaxMs, (double)HistoryMs);
+		}
+		Snapshot.AverageMs = SumMs / NumFrameHistory;
+
+		Snapshot.LastRunMs = Stat->LastRunNs.load(std::memory_order_relaxed) / 1e6;
+		Snapshot.LastRunLines = Stat->LastRunLines.load(std::memory_order_relaxed);
+		Snapshot.LastRunBytes = Stat->LastRunBytes.load(std::memory_order_relaxed);
+	}
+}
+
+void GetStats(std::vector<FStatSnapshot>& OutStats)
+{
+	std::lock_guard<std::mutex> Lock(StatsMutex);
+	OutStats.clear();
+	for (const FStat* Stat : Stats)
+	{
+		OutStats.push_back(Stat->Snapshot);
+	}
+}
+
+void GetJobs(std::vector<FJobSnapshot>& OutJobs)
+{
+	std::lock_guard<std::mutex> Lock(JobsMutex);
+	OutJobs.clear();
+	for (const FJob* Job : Jobs)
+	{
+		FJobSnapshot Snapshot;
+		Snapshot.Name = Job->Name;
+		Snapshot.Done = Job->Done.load(std::memory_order_relaxed);
+		Snapshot.Total = Job->Total.load(std::memory_order_relaxed);
+		OutJobs.push_back(Snapshot);
+	}
+}
+
+void GetFrameHistory(float (&OutFrameMs)[NumFrameHistory])
+{
+	for (int HistoryIdx = 0; HistoryIdx < NumFrameHistory; ++HistoryIdx)
+	{
+		OutFrameMs[HistoryIdx] = FrameHistoryMs[(FrameHistoryOffset + HistoryIdx) % NumFrameHistory];
+	}
+}
+
+void SetTraceEnabled(bool bEnable)
+{
+	bTraceEnabled = bEnable;
+}
+
+bool IsTraceEnabled()
+{
+	return bTraceEnabled;
+}
+
+void SetThreadName(const std::string& Name)
+{
+	ThreadName = Name;
+	if (ThreadTraceBuffer)
+	{
+		std::lock_guard<std::mutex> Lock(TraceBuffersMutex);
+		ThreadTraceBuffer->ThreadName = Name;
+	}
+}
+
+static void WriteJsonString(FILE* File, const char* Text)
+{
+	fputc('"', File);
+	for (; *Text; ++Text)
+	{
+		if (*Text == '"' || *Text == '\\') fputc('\\', File);
+		fputc(*Text, File);
+	}
+	fputc('"', File);
+}
+
+bool WriteChromeTrace(const std::string& FilePath)
+{
+	FILE* File = fopen(FilePath.c_str(), "w");
+	if (!File) return false;
+
+	fprintf(File, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool bFirstEvent = true;
+	std::vector<FTraceEvent> Events;
+
+	std::lock_guard<std::mutex> Lock(TraceBuffersMutex);
+	for (const std::unique_ptr<FTraceBuffer>& Buffer : TraceBuffers)
+	{
+		fprintf(File, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", bFirstEvent ? "" : ",\n", Buffer->ThreadId);
+		WriteJsonString(File, Buffer->ThreadName.c_str());
+		fprintf(File, "}}");
+		bFirstEvent = false;
+
+		// The owning thread may keep writing while we copy, so drop anything it could have overwritten meanwhile,
+		// including the slot of the event it may be halfway through writing after the last one it published
+		const uint64_t EndIdx = Buffer->WriteIdx.load(std::memory_order_acquire);
+		uint64_t BeginIdx = EndIdx > FTraceBuffer::NumEvents ? EndIdx - FTraceBuffer::NumEvents : 0;
+		Events.clear();
+		for (uint64_t Idx = BeginIdx; Idx < EndIdx; ++Idx)
+		{
+			Events.push_back(Buffer->Events[Idx % FTraceBuffer::NumEvents]);
+		}
+		const uint64_t NewEndIdx = Buffer->WriteIdx.load(std::memory_order_acquire);
+		const uint64_t NumOverwritten = NewEndIdx + 1 > BeginIdx + FTraceBuffer::NumEvents ? NewEndIdx + 1 - BeginIdx - FTraceBuffer::NumEvents : 0;
+
+		for (size_t EventIdx = std::min<size_t>(NumOverwritten, Events.size()); EventIdx < Events.size(); ++EventIdx)
+		{
+			const FTraceEvent& Event = Events[EventIdx];
+			if (Event.StartNs < TraceStartNs) continue;
+			fprintf(File, ",\n{\"name\":");
+			WriteJsonString(File, Event.Name);
+			fprintf(File, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				Buffer->ThreadId, (Event.StartNs - TraceStartNs) / 1000.0, Event.DurationNs / 1000.0);
+		}
+	}
+
+	fprintf(File, "\n]}\n");
+	return fclose(File) == 0;
+}
+
+} // namespace Profiler
+
+#endif // ULV_WITH_PROFILER
@@ -0,0 +1,130 @@
+#pragma once
+
+// Lightweight instrumentation for the load, parse, filter and render phases.
+// Set ULV_WITH_PROFILER to 0 to compile all of it out.
+
+#ifndef ULV_WITH_PROFILER
+#define ULV_WITH_PROFILER 1
+#endif
+
+#if ULV_WITH_PROFILER
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Profiler
+{
+	struct FStat;
+
+	/** Returns the stat with this name, creating it on first use. Name must be a string literal. */
+	FStat* RegisterStat(const char* Name);
+
+	uint64_t GetTimeNs();
+
+	/** Times a block of code into a stat. Work reported with ULV_PROFILE_WORK is added to the innermost scope. */
+	class FScope
+	{
+	public:
+		FScope(FStat* InStat);
+		~FScope();
+
+		static void AddWork(uint64_t NumLines, uint64_t NumBytes);
+
+	private:
+		FStat* Stat;
+		FScope* Parent;
+		uint64_t StartNs;
+		uint64_t NumLines = 0;
+		uint64_t NumBytes = 0;
+	};
+
+	void AddCount(FStat* Stat, uint64_t Count);
+
+	/** A long running job, listed with its progress in the overlay while it is alive */
+	class FJob
+	{
+	public:
+		FJob(const std::string& Name);
+		~FJob();
+
+		void SetProgress(uint64_t Done, uint64_t Total);
+
+		std::string Name;
+		std::atomic<uint64_t> Done;
+		std::atomic<uint64_t> Total;
+	};
+
+	/** Rolls the per-frame stats, call once at the end of every frame */
+	void EndFrame(uint64_t FrameStartNs);
+
+	// Trace recording. While enabled every scope is also recorded into a per-thread ring buffer,
+	// which can be written out as a Chrome trace event file for chrome://tracing or Perfetto.
+
+	void SetTraceEnabled(bool bEnable);
+	bool IsTraceEnabled();
+
+	/** Names the calling thread in traces */
+	void SetThreadName(const std::string& Name);
+
+	/** Writes the recorded events of every thread, returns false if the file could not be written */
+	bool WriteChromeTrace(const std::string& FilePath);
+
+	struct FStatSnapshot
+	{
+		const char* Name = nullptr;
+		double FrameMs = 0.0;
+		double AverageMs = 0.0;
+		double MaxMs = 0.0;
+		uint64_t FrameCalls = 0;
+		uint64_t FrameCount = 0;
+		uint64_t TotalCount = 0;
+
+		// The most recent completed scope, used for throughput
+		double LastRunMs = 0.0;
+		uint64_t LastRunLines = 0;
+		uint64_t LastRunBytes = 0;
+	};
+
+	void GetStats(std::vector<FStatSnapshot>& OutStats);
+
+	struct FJobSnapshot
+	{
+		std::string Name;
+		uint64_t Done = 0;
+		uint64_t Total = 0;
+	};
+
+	void GetJobs(std::vector<FJobSnapshot>& OutJobs);
+
+	static const int NumFrameHistory = 240;
+
+	/** Rolling history of frame times in milliseconds, oldest first */
+	void GetFrameHistory(float (&OutFrameMs)[NumFrameHistory]);
+}
+
+#define ULV_PROFILE_JOIN_INNER(A, B) A##B
+#define ULV_PROFILE_JOIN(A, B) ULV_PROFILE_JOIN_INNER(A, B)
+
+#define ULV_PROFILE_SCOPE(Name) \
+	static Profiler::FStat* const ULV_PROFILE_JOIN(ProfileStat, __LINE__) = Profiler::RegisterStat(Name); \
+	Profiler::FScope ULV_PROFILE_JOIN(ProfileScope, __LINE__)(ULV_PROFILE_JOIN(ProfileStat, __LINE__))
+
+#define ULV_PROFILE_WORK(NumLines, NumBytes) Profiler::FScope::AddWork(NumLines, NumBytes)
+
+#define ULV_PROFILE_COUNTER(Name, Count) \
+	do { static Profiler::FStat* const Stat = Profiler::RegisterStat(Name); Profiler::AddCount(Stat, Count); } while (0)
+
+#define ULV_PROFILE_JOB(Name) Profiler::FJob ProfileJob(Name)
+#define ULV_PROFILE_JOB_PROGRESS(Done, Total) ProfileJob.SetProgress(Done, Total)
+
+#else
+
+#define ULV_PROFILE_SCOPE(Name)
+#define ULV_PROFILE_WORK(NumLines, NumBytes)
+#define ULV_PROFILE_COUNTER(Name, Count)
+#define ULV_PROFILE_JOB(Name)
+#define ULV_PROFILE_JOB_PROGRESS(Done, Total)
+
+#endif
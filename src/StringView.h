@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+/** Non-owning view of a run of characters, in place of std::string_view which needs C++17 */
+struct FStringView
+{
+	const char* Data = nullptr;
+	size_t Size = 0;
+
+	FStringView() {}
+	FStringView(const char* InData, size_t InSize) : Data(InData), Size(InSize) {}
+	FStringView(const char* InString) : Data(InString), Size(strlen(InString)) {}
+	FStringView(const std::string& InString) : Data(InString.data()), Size(InString.size()) {}
+
+	const char* begin() const { return Data; }
+	const char* end() const { return Data + Size; }
+	bool empty() const { return Size == 0; }
+	char operator[](size_t Idx) const { return Data[Idx]; }
+
+	std::string ToString() const { return std::string(Data, Size); }
+
+	bool StartsWith(size_t Pos, FStringView Prefix) const
+	{
+		return Pos <= Size && Size - Pos >= Prefix.Size && memcmp(Data + Pos, Prefix.Data, Prefix.Size) == 0;
+	}
+
+	/** Returns the position of Needle at or after StartPos, or npos */
+	size_t Find(FStringView Needle, size_t StartPos = 0) const
+	{
+		if (StartPos > Size || Needle.Size > Size - StartPos) return npos;
+		if (Needle.Size == 0) return StartPos;
+		const char* Last = Data + Size - Needle.Size;
+		for (const char* Pos = Data + StartPos; Pos <= Last; ++Pos)
+		{
+			Pos = (const char*)memchr(Pos, Needle.Data[0], Last - Pos + 1);
+			if (!Pos) break;
+			if (memcmp(Pos, Needle.Data, Needle.Size) == 0) return Pos - Data;
+		}
+		return npos;
+	}
+
+	static const size_t npos = size_t(-1);
+};
@@ -1,8 +1,22 @@
 #include "imgui/imgui.h"
+#include "app.h"
 #include "FileUtils.h"
+#include "GlobalSearch.h"
+#include "LogFile.h"
+#include "LogDiff.h"
+#include "LogFields.h"
+#include "LogIndexCache.h"
+#include "MergedLines.h"
+#include "Profiler.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -13,305 +27,1507 @@
 #define STRNCPY strncpy
 #endif
 
-enum class EFilterType : int
+static std::vector<FLogFile> OpenFiles;
+static ImVec4 TextColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+static ImVec4 TextColor_Warning = ImVec4(1.0f, 1.0f, 0.0f, 1.0f);
+static ImVec4 TextColor_Error = ImVec4(1.0f, 0.0f, 0.0f, 1.0f);
+static ImVec4 TextColor_Bookmark = ImVec4(0.3f, 0.8f, 1.0f, 1.0f);
+static bool bWordWrap = true;
+static bool bDisplayTimestamps = true;
+static bool bShowDemoWindow = true;
+static bool bShowProfiler = false;
+static bool bShowMemory = false;
+static std::string TraceOutputPath;
+static float PendingScrollLines = 0.0f;
+
+// Once the open files use more than this, caches of the least recently viewed files are evicted. 0 means no limit.
+static uint64_t MemoryBudgetBytes = 0;
+
+// Storage for files opened from now on. Auto pages the text of files that are large compared to the memory budget.
+static bool bAutoStorage = true;
+static ELineStorage Storage = ELineStorage::Memory;
+static uint64_t PageCacheBytes = 256ull * 1024 * 1024;
+
+// Keep the line index of large files in a cache file, so opening them again does not scan them
+static bool bUseIndexCache = true;
+
+// Lines of the open files interleaved by time
+static bool bShowMergedView = false;
+static bool bFocusMergedView = false;
+static FMergedLines MergedLines;
+static double MergedScrollRow = 0.0;
+static int MergedScrollDirection = 1;
+
+// Keeps every view at the time at the top of the one that was scrolled last
+static bool bSyncScrolling = false;
+static const int MergedViewSyncLeader = -2;
+static const int NotSyncedView = -3;
+// Lists such as search hits, which neither sync nor take scripted scrolling
+static const int ListView = -4;
+static int SyncLeader = -1;
+static int64_t SyncTimeMs = FLineTimes::NoTime;
+
+// Diff between two of the open files
+static bool bShowDiff = false;
+static bool bFocusDiff = false;
+static int DiffLeftFileIdx = 0;
+static int DiffRightFileIdx = 1;
+static FDiffOptions DiffOptions;
+static FLogDiff LogDiff;
+static bool bDiffShowOps[(int)EDiffOp::MAX] = { false, true, true };
+static double DiffScrollRow = 0.0;
+static int DiffScrollDirection = 1;
+
+// Search of every open file at once
+static bool bShowSearch = false;
+static bool bFocusSearch = false;
+static FSearchQuery SearchQuery;
+static bool bSearchQueryValid = true;
+static FGlobalSearch GlobalSearch;
+static double SearchScrollRow = 0.0;
+static int SearchScrollDirection = 1;
+
+// Scroll position of the list in the region combo of a region filter, only one of them is open at a time
+static double RegionListScrollRow = 0.0;
+static int RegionListScrollDirection = 1;
+// Bumped by every search, so the minimaps know the hits are new ones
+static uint64_t SearchGeneration = 0;
+
+// Templates of the lines of one of the open files, most common first
+static bool bShowPatterns = false;
+static bool bFocusPatterns = false;
+static int PatternsFileIdx = 0;
+static std::vector<uint32_t> PatternOrder;
+static int PatternOrderFileIdx = -1;
+static uint64_t PatternOrderNumLines = 0;
+
+// Values of a field in the display lines of one of the open files, extracted again on a worker whenever those change
+static bool bShowFields = false;
+static bool bFocusFields = false;
+static int FieldsFileIdx = 0;
+static FFieldRule FieldRule;
+static FFieldRule ExtractedFieldRule;
+static FFieldExtraction FieldExtraction;
+// File and display lines the last extraction started from, and the file of the column shown
+static int FieldExtractionFileIdx = -1;
+static uint64_t FieldExtractionDisplayLinesVersion = 0;
+static int FieldColumnFileIdx = -1;
+static double FieldsScrollRow = 0.0;
+static int FieldsScrollDirection = 1;
+static bool bFieldsByValue = false;
+static bool bFieldsDescending = false;
+
+// Timeline strip above each text window
+static bool bShowTimeline = true;
+static ETimelineStack TimelineStack = ETimelineStack::Verbosity;
+static int TimelineNumCategories = 5;
+static const int MaxTimelineBuckets = 512;
+
+// Errors, warnings, search hits and bookmarks drawn over the scrollbar of each text window
+static bool bShowDensityMap = true;
+
+// Render-on-demand state. The host sleeps between frames unless one of these says otherwise.
+static std::atomic<bool> bRedrawRequested(true);
+static std::atomic<void (*)()> RedrawCallback(nullptr);
+static double RedrawTimeout = 0.0;
+static int SettleFramesRemaining = 0;
+
+// ImGui needs a couple of frames after an input change before hover states and layout stop changing
+static const int NumSettleFrames = 3;
+// Rate at which we redraw while a text field is focused, so the cursor keeps blinking
+static const double TextInputRedrawTimeout = 0.2;
+
+/** The ImGui inputs from the previous frame, used to detect whether anything changed since then */
+struct FInputState
 {
-	TextInclude = 0,
-	TextExclude,
-	LogCategory,
-	MAX
+	ImVec2 DisplaySize = ImVec2(-1.0f, -1.0f);
+	ImVec2 MousePos = ImVec2(-FLT_MAX, -FLT_MAX);
+	bool MouseDown[5] = {};
+	bool KeysDown[512] = {};
+	bool KeyCtrl = false;
+	bool KeyShift = false;
+	bool KeyAlt = false;
+	bool KeySuper = false;
 };
+static FInputState PrevInputState;
 
-const char* EFilterTypeStrings[(int)EFilterType::MAX + 1] =
+bool UpdateInputState(const ImGuiIO& IO)
 {
-	"Text Include",
-	"Text Exclude",
-	"Log Category"
-};
+	bool bChanged = IO.MouseWheel != 0.0f || IO.MouseWheelH != 0.0f || IO.InputQueueCharacters.Size > 0;
+	bChanged |= IO.DisplaySize.x != PrevInputState.DisplaySize.x || IO.DisplaySize.y != PrevInputState.DisplaySize.y;
+	bChanged |= IO.MousePos.x != PrevInputState.MousePos.x || IO.MousePos.y != PrevInputState.MousePos.y;
+	bChanged |= memcmp(IO.MouseDown, PrevInputState.MouseDown, sizeof(IO.MouseDown)) != 0;
+	bChanged |= memcmp(IO.KeysDown, PrevInputState.KeysDown, sizeof(IO.KeysDown)) != 0;
+	bChanged |= IO.KeyCtrl != PrevInputState.KeyCtrl || IO.KeyShift != PrevInputState.KeyShift
+		|| IO.KeyAlt != PrevInputState.KeyAlt || IO.KeySuper != PrevInputState.KeySuper;
 
-enum class ELogVerbosity : int
+	PrevInputState.DisplaySize = IO.DisplaySize;
+	PrevInputState.MousePos = IO.MousePos;
+	memcpy(PrevInputState.MouseDown, IO.MouseDown, sizeof(IO.MouseDown));
+	memcpy(PrevInputState.KeysDown, IO.KeysDown, sizeof(IO.KeysDown));
+	PrevInputState.KeyCtrl = IO.KeyCtrl;
+	PrevInputState.KeyShift = IO.KeyShift;
+	PrevInputState.KeyAlt = IO.KeyAlt;
+	PrevInputState.KeySuper = IO.KeySuper;
+	return bChanged;
+}
+
+void BeginRedrawFrame()
 {
-	Off = 0,
-	Error,
-	Warning,
-	Log,
-	Verbose,
-	VeryVerbose,
-	MAX
-};
+	// This frame satisfies any redraw requested before it started, but give the layout time to settle
+	if (bRedrawRequested.exchange(false))
+	{
+		SettleFramesRemaining = std::max(SettleFramesRemaining, NumSettleFrames);
+	}
+}
 
-const char* ELogVerbosityStrings[(int)ELogVerbosity::MAX + 1] =
+void EndRedrawFrame()
 {
-	"Off",
-	"Error",
-	"Warning",
-	"Log",
-	"Verbose",
-	"VeryVerbose"
-};
+	const ImGuiIO& IO = ImGui::GetIO();
+	if (UpdateInputState(IO))
+	{
+		SettleFramesRemaining = NumSettleFrames;
+	}
+	else if (SettleFramesRemaining > 0)
+	{
+		--SettleFramesRemaining;
+	}
+
+	if (bRedrawRequested || SettleFramesRemaining > 0 || ImGui::IsAnyMouseDown() || ImGui::IsAnyItemActive())
+	{
+		RedrawTimeout = 0.0;
+	}
+	else if (IO.WantTextInput)
+	{
+		RedrawTimeout = TextInputRedrawTimeout;
+	}
+	else
+	{
+		RedrawTimeout = -1.0;
+	}
+}
+
+bool InputTextBox(const char* Label, std::string& InOutText)
+{
+	static char Buf[1024];
+	STRNCPY(Buf, InOutText.c_str(), InOutText.size());
+	if (ImGui::InputText(Label, Buf, 1024))
+	{
+		InOutText = Buf;
+		return true;
+	}
+	return false;
+}
+
+int GetNumLineNumberChars(const FLogFile& LogFile)
+{
+	const FDisplayLines& DisplayLines = LogFile.GetDisplayLines();
+	int NumLineNumChars = 1;
+	if (!DisplayLines.IsEmpty())
+	{
+		uint64_t BiggestLine = DisplayLines[DisplayLines.Num() - 1];
+		while (BiggestLine /= 10) ++NumLineNumChars;
+	}
+	return NumLineNumChars;
+}
+
+/** Adds or removes a bookmark on a line */
+void ToggleBookmark(FLogFile& LogFile, uint64_t LineIdx)
+{
+	auto It = std::lower_bound(LogFile.Bookmarks.begin(), LogFile.Bookmarks.end(), LineIdx);
+	if (It != LogFile.Bookmarks.end() && *It == LineIdx) LogFile.Bookmarks.erase(It);
+	else LogFile.Bookmarks.insert(It, LineIdx);
+	++LogFile.BookmarksVersion;
+}
+
+/** First filter of a type in a file, added if it has none, and enabled */
+FLineFilter& EnableRangeFilter(FLogFile& File, EFilterType Type, bool& bOutAdded)
+{
+	auto Filter = std::find_if(File.Filters.begin(), File.Filters.end(), [Type](const FLineFilter& Filter) { return Filter.Type == Type; });
+	bOutAdded = Filter == File.Filters.end();
+	if (bOutAdded)
+	{
+		File.Filters.emplace_back(FLineFilter());
+		Filter = File.Filters.end() - 1;
+		Filter->Type = Type;
+	}
+	Filter->bEnable = true;
+	File.bDisplayTextDirty = true;
+	return *Filter;
+}
+
+/** Enables the time range filter of a file, adding one if it has none */
+void SetTimeRangeFilter(FLogFile& File, int64_t StartMs, int64_t EndMs)
+{
+	bool bAdded;
+	FLineFilter& Filter = EnableRangeFilter(File, EFilterType::TimeRange, bAdded);
+	Filter.TimeRangeData.StartMs = StartMs;
+	Filter.TimeRangeData.EndMs = EndMs;
+}
+
+/** Starts or ends the frame range filter of a file at the frame of a line, a new one runs from the first to the last frame */
+void SetFrameRangeFilterAt(FLogFile& File, uint64_t LineIdx, bool bStart)
+{
+	bool bAdded;
+	FLineFilter& Filter = EnableRangeFilter(File, EFilterType::FrameRange, bAdded);
+	if (bAdded)
+	{
+		Filter.FrameRangeData.FirstFrame = File.LineTimes.GetFrame(0);
+		Filter.FrameRangeData.LastFrame = File.LineTimes.GetFrame(File.LineTimes.Num() - 1);
+	}
+	(bStart ? Filter.FrameRangeData.FirstFrame : Filter.FrameRangeData.LastFrame) = File.LineTimes.GetFrame(LineIdx);
+}
 
-struct FLineFilter
+void RenderLogLine(FLogFile& LogFile, uint64_t LineNumber, int NumLineNumChars)
 {
-	EFilterType Type = EFilterType::TextInclude;
-	struct
+	const FLineRef LogLine = LogFile.Lines.GetLine(LineNumber);
+	const FLogLineMetadata& LogLineMetadata = LogFile.LineMetadatas[LineNumber];
+
+	ImVec4 TextStyleColor;
+	switch (LogLineMetadata.LineType)
 	{
-		std::string Token;
-		bool bCaseMatch = false;
-	} TextData;
-	struct
+	case ELogLineType::Warning: TextStyleColor = TextColor_Warning; break;
+	case ELogLineType::Error: TextStyleColor = TextColor_Error; break;
+	default: TextStyleColor = TextColor; break;
+	}
+	const float StartX = ImGui::GetCursorPosX();
+	ImGui::PushStyleColor(ImGuiCol_Text, TextStyleColor);
+	const bool bBookmarked = std::binary_search(LogFile.Bookmarks.begin(), LogFile.Bookmarks.end(), LineNumber);
+	ImGui::TextColored(bBookmarked ? TextColor_Bookmark : TextStyleColor, "%llu", (unsigned long long)(LineNumber + 1));
+	ImGui::SameLine(StartX + NumLineNumChars * ImGui::GetFontSize());
+
+	const char* TextPtr = LogLine.Text.begin();
+	TextPtr += !bDisplayTimestamps && LogLineMetadata.bContainsTimestamp ? FLogLineMetadata::FrameEndIdx+1 : 0;
+	ImGui::TextUnformatted(TextPtr, LogLine.Text.end());
+
+	ImGui::PopStyleColor();
+
+	// Content menu
+	if (ImGui::BeginPopupContextItem("DisplayText context menu"))
 	{
-		std::string Category;
-		ELogVerbosity Verbosity = ELogVerbosity::Log;
-	} LogCategoryData;
-	bool bEnable = false;
+		if (ImGui::Selectable("Copy")) ImGui::SetClipboardText(LogLine.Text.ToString().c_str());
+		if (ImGui::Selectable(bBookmarked ? "Remove Bookmark" : "Add Bookmark")) ToggleBookmark(LogFile, LineNumber);
+		if (LogFile.LineTimes.HasTimes())
+		{
+			// Frames count on from the first line's frame column, the engine's own frame counter isn't in the log
+			ImGui::TextDisabled("Relative frame %lld", (long long)LogFile.LineTimes.GetFrame(LineNumber));
+			if (ImGui::Selectable("Show Frames From Here")) SetFrameRangeFilterAt(LogFile, LineNumber, true);
+			if (ImGui::Selectable("Show Frames Up To Here")) SetFrameRangeFilterAt(LogFile, LineNumber, false);
+		}
+		ImGui::EndPopup();
+	}
+}
+
+struct FVisibleRows
+{
+	uint64_t FirstRow = 0;
+	uint64_t EndRow = 0;
+	uint64_t NumPageRows = 1;
+	// Scrolled by the user this frame rather than moved by the view being synced or clamped
+	bool bUserScrolled = false;
+	// Screen rectangle of the scrollbar
+	ImVec2 ScrollbarMin;
+	ImVec2 ScrollbarMax;
 };
 
-int FindPos(const std::string& A, int AStartPos, const std::string& B)
+/**
+ * Scrollable view of NumRows rows, RenderRow is called in order for each visible row.
+ * SyncView is the file index of the view, MergedViewSyncLeader, NotSyncedView or ListView. Scripted scrolling moves every view
+ * but the lists, and only counts as the user scrolling the sync leader, or the first file if there is none, so it keeps the lead.
+ */
+template <typename RenderRowType>
+FVisibleRows RenderScrolledRows(uint64_t NumRows, double& ScrollRow, int& ScrollDirection, int SyncView, RenderRowType RenderRow)
 {
-	return A.find(B, AStartPos);
+	// We scroll vertically in rows rather than pixels, a float pixel offset loses precision long before we run out of lines
+	FVisibleRows Visible;
+	const ImGuiStyle& Style = ImGui::GetStyle();
+	const ImVec2 RegionSize = ImGui::GetContentRegionAvail();
+	Visible.NumPageRows = std::max(1, int(RegionSize.y / ImGui::GetTextLineHeightWithSpacing()));
+	const uint64_t MaxScrollRow = NumRows > Visible.NumPageRows ? NumRows - Visible.NumPageRows : 0;
+	const double StartScrollRow = ScrollRow;
+	if (ImGui::IsWindowHovered(ImGuiHoveredFlags_ChildWindows))
+	{
+		ScrollRow -= ImGui::GetIO().MouseWheel * 5.0;
+	}
+	Visible.bUserScrolled = ScrollRow != StartScrollRow;
+	if (SyncView != ListView)
+	{
+		ScrollRow += PendingScrollLines;
+		Visible.bUserScrolled |= PendingScrollLines != 0.0f && SyncView == (SyncLeader == -1 ? 0 : SyncLeader);
+	}
+	ScrollRow = std::min(std::max(ScrollRow, 0.0), double(MaxScrollRow));
+
+	// Rows are clipped by hand, so only let the text scroll horizontally
+	Visible.FirstRow = uint64_t(ScrollRow);
+	uint64_t Row = Visible.FirstRow;
+	ImGui::SetNextWindowContentSize(ImVec2(0.0f, 1.0f));
+	if (ImGui::BeginChild("TextLines", ImVec2(RegionSize.x - Style.ScrollbarSize, 0.0f), false, ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_NoScrollWithMouse))
+	{
+		if (bWordWrap)
+		{
+			ImGui::PushTextWrapPos(ImGui::GetWindowContentRegionWidth());
+		}
+		const float WindowHeight = ImGui::GetWindowHeight();
+		for (; Row < NumRows && ImGui::GetCursorPosY() < WindowHeight; ++Row)
+		{
+			ImGui::PushID((const void*)(uintptr_t)Row);
+			RenderRow(Row);
+			ImGui::PopID();
+		}
+		ULV_PROFILE_COUNTER("RenderTextWindow rows", Row - Visible.FirstRow);
+		if (bWordWrap)
+		{
+			ImGui::PopTextWrapPos();
+		}
+	}
+	ImGui::EndChild();
+	Visible.EndRow = Row;
+
+	// Vertical scrollbar, the slider runs bottom to top
+	ImGui::SameLine(0.0f, 0.0f);
+	const uint64_t SliderMin = 0;
+	uint64_t SliderValue = MaxScrollRow - uint64_t(ScrollRow);
+	if (ImGui::VSliderScalar("##ScrollRow", ImVec2(Style.ScrollbarSize, RegionSize.y), ImGuiDataType_U64, &SliderValue, &SliderMin, &MaxScrollRow, ""))
+	{
+		ScrollRow = double(MaxScrollRow - SliderValue);
+		Visible.bUserScrolled = true;
+	}
+	Visible.ScrollbarMin = ImGui::GetItemRectMin();
+	Visible.ScrollbarMax = ImGui::GetItemRectMax();
+
+	if (ScrollRow != StartScrollRow)
+	{
+		ScrollDirection = ScrollRow > StartScrollRow ? 1 : -1;
+	}
+	return Visible;
 }
 
-bool StartsWith(const std::string& A, int AStartPos, const std::string& B)
+/** Row a page past the visible ones in the scroll direction, its text should be loaded before we get there */
+uint64_t GetPrefetchRow(const FVisibleRows& Visible, uint64_t NumRows, int ScrollDirection)
 {
-	return A.compare(AStartPos, B.size(), B) == 0;
+	return ScrollDirection > 0 ? std::min(Visible.EndRow + Visible.NumPageRows, NumRows - 1) : (Visible.FirstRow > Visible.NumPageRows ? Visible.FirstRow - Visible.NumPageRows : 0);
 }
 
-bool Contains(const std::string& Haystack, const std::string& Needle)
+/**
+ * Lines per slice of time, stacked by verbosity or by the categories with the most lines. Click to jump to a time,
+ * drag to filter the file to a time range, scroll to zoom and drag with the right button to pan.
+ * Each bucket is counted from the running totals of the timeline at its first and last line, so a frame costs O(buckets log n).
+ */
+void RenderTimeline(FLogFile& LogFile, int FileIdx, int64_t ScrollTimeMs)
 {
-	return std::search(Haystack.begin(), Haystack.end(), Needle.begin(), Needle.end()) != Haystack.end();
+	ULV_PROFILE_SCOPE("RenderTimeline");
+	const FLineTimes& Times = LogFile.LineTimes;
+	const FLogTimeline& Timeline = LogFile.GetTimeline();
+	const int64_t LogStartMs = Times[0];
+	const int64_t LogEndMs = Times[Times.Num() - 1] + 1;
+	const bool bZoomed = LogFile.TimelineEndMs > LogFile.TimelineStartMs;
+	const int64_t StartMs = bZoomed ? LogFile.TimelineStartMs : LogStartMs;
+	const int64_t EndMs = bZoomed ? LogFile.TimelineEndMs : LogEndMs;
+
+	// Series in stacking order, the last one is whatever lines the others leave
+	int SeriesCategories[FLogTimeline::MaxCategories + 1];
+	int NumSeries = 0;
+	if (TimelineStack == ETimelineStack::Verbosity)
+	{
+		NumSeries = FLogTimeline::NumLevels;
+	}
+	else
+	{
+		// Every category is counted, the ones with the most lines have counts over time
+		for (int Category = 0; Category < Timeline.NumCategories(); ++Category)
+		{
+			if (Timeline.HasCategoryCounts(Category)) SeriesCategories[NumSeries++] = Category;
+		}
+		std::sort(SeriesCategories, SeriesCategories + NumSeries, [&](int A, int B) { return Timeline.GetCategoryTotal(A) > Timeline.GetCategoryTotal(B); });
+		NumSeries = std::min(NumSeries, TimelineNumCategories) + 1;
+	}
+	auto GetSeriesCount = [&](int Series, uint64_t LineIdx)
+	{
+		return TimelineStack == ETimelineStack::Verbosity ? Timeline.GetLevelCount(FLogTimeline::ELevel(Series), LineIdx) : Timeline.GetCategoryCount(SeriesCategories[Series], LineIdx);
+	};
+	auto GetSeriesName = [&](int Series)
+	{
+		if (TimelineStack == ETimelineStack::Verbosity) return Series == FLogTimeline::Error ? "Error" : Series == FLogTimeline::Warning ? "Warning" : "Log";
+		return Series == NumSeries - 1 ? "Other" : Timeline.GetCategoryName(SeriesCategories[Series]).c_str();
+	};
+	auto GetSeriesColor = [&](int Series)
+	{
+		if (TimelineStack == ETimelineStack::Verbosity)
+		{
+			return ImGui::GetColorU32(Series == FLogTimeline::Error ? TextColor_Error : Series == FLogTimeline::Warning ? TextColor_Warning : ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
+		}
+		return Series == NumSeries - 1 ? ImGui::GetColorU32(ImVec4(0.5f, 0.5f, 0.5f, 1.0f)) : ImU32(ImColor::HSV(fmodf(Series * 0.618f, 1.0f), 0.6f, 0.9f));
+	};
+
+	const float Width = ImGui::GetContentRegionAvail().x;
+	const float Height = ImGui::GetTextLineHeight() * 3.0f;
+	if (Width < 1.0f) return;
+	const int NumBuckets = std::max(1, std::min(MaxTimelineBuckets, int(Width / 3.0f)));
+	const double MsPerPixel = double(EndMs - StartMs) / Width;
+	std::vector<uint64_t>& BucketLines = LogFile.TimelineBucketLines;
+	std::vector<float>& BucketCounts = LogFile.TimelineBucketCounts;
+	BucketLines.resize(NumBuckets + 1);
+	BucketCounts.resize(NumBuckets * NumSeries);
+	double SeriesCounts[2][FLogTimeline::MaxCategories + 1];
+	float MaxBucketLines = 1.0f;
+	for (int Bucket = 0; Bucket <= NumBuckets; ++Bucket)
+	{
+		BucketLines[Bucket] = Times.FindLine(StartMs + (EndMs - StartMs) * Bucket / NumBuckets);
+		double* Counts = SeriesCounts[Bucket & 1];
+		for (int Series = 0; Series < NumSeries - 1; ++Series)
+		{
+			Counts[Series] = GetSeriesCount(Series, BucketLines[Bucket]);
+		}
+		if (Bucket == 0) continue;
+
+		const double* PrevCounts = SeriesCounts[(Bucket - 1) & 1];
+		float* BucketSeriesCounts = &BucketCounts[(Bucket - 1) * NumSeries];
+		const float NumLines = float(BucketLines[Bucket] - BucketLines[Bucket - 1]);
+		float NumOtherLines = NumLines;
+		for (int Series = 0; Series < NumSeries - 1; ++Series)
+		{
+			BucketSeriesCounts[Series] = float(Counts[Series] - PrevCounts[Series]);
+			NumOtherLines -= BucketSeriesCounts[Series];
+		}
+		BucketSeriesCounts[NumSeries - 1] = std::max(0.0f, NumOtherLines);
+		MaxBucketLines = std::max(MaxBucketLines, NumLines);
+	}
+
+	const ImVec2 Pos = ImGui::GetCursorScreenPos();
+	ImGui::InvisibleButton("Timeline", ImVec2(Width, Height));
+	ImDrawList* DrawList = ImGui::GetWindowDrawList();
+	DrawList->AddRectFilled(Pos, ImVec2(Pos.x + Width, Pos.y + Height), ImGui::GetColorU32(ImGuiCol_FrameBg));
+	for (int Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		const float MinX = Pos.x + Width * Bucket / NumBuckets;
+		const float MaxX = std::max(MinX + 1.0f, Pos.x + Width * (Bucket + 1) / NumBuckets - 1.0f);
+		float Y = Pos.y + Height;
+		for (int Series = 0; Series < NumSeries; ++Series)
+		{
+			const float SeriesHeight = BucketCounts[Bucket * NumSeries + Series] / MaxBucketLines * Height;
+			if (SeriesHeight <= 0.0f) continue;
+			DrawList->AddRectFilled(ImVec2(MinX, Y - SeriesHeight), ImVec2(MaxX, Y), GetSeriesColor(Series));
+			Y -= SeriesHeight;
+		}
+	}
+	if (ScrollTimeMs >= StartMs && ScrollTimeMs < EndMs)
+	{
+		const float ScrollX = Pos.x + float((ScrollTimeMs - StartMs) / MsPerPixel);
+		DrawList->AddLine(ImVec2(ScrollX, Pos.y), ImVec2(ScrollX, Pos.y + Height), ImGui::GetColorU32(ImGuiCol_Text));
+	}
+
+	ImGuiIO& IO = ImGui::GetIO();
+	auto GetTimeAt = [&](float X) { return StartMs + int64_t(std::min(std::max(X - Pos.x, 0.0f), Width) * MsPerPixel); };
+	auto SetView = [&](int64_t NewStartMs, int64_t NewSpanMs)
+	{
+		NewSpanMs = std::min(std::max(NewSpanMs, int64_t(NumBuckets)), LogEndMs - LogStartMs);
+		LogFile.TimelineStartMs = std::min(std::max(NewStartMs, LogStartMs), LogEndMs - NewSpanMs);
+		LogFile.TimelineEndMs = LogFile.TimelineStartMs + NewSpanMs;
+	};
+	if (ImGui::IsItemHovered())
+	{
+		if (IO.MouseWheel != 0.0f)
+		{
+			// Zoom about the time under the mouse, and keep the text below from scrolling too
+			const int64_t MouseTimeMs = GetTimeAt(IO.MousePos.x);
+			const double NewSpanMs = double(EndMs - StartMs) * pow(0.8, IO.MouseWheel);
+			SetView(MouseTimeMs - int64_t(NewSpanMs * (IO.MousePos.x - Pos.x) / Width), int64_t(NewSpanMs));
+			IO.MouseWheel = 0.0f;
+		}
+		if (ImGui::IsMouseDragging(ImGuiMouseButton_Right))
+		{
+			SetView(StartMs - int64_t(IO.MouseDelta.x * MsPerPixel), EndMs - StartMs);
+		}
+		if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+		{
+			LogFile.TimelineStartMs = LogFile.TimelineEndMs = 0;
+		}
+		if (!ImGui::IsItemActive())
+		{
+			const int Bucket = std::min(NumBuckets - 1, int((IO.MousePos.x - Pos.x) / Width * NumBuckets));
+			char StartText[TimeTextSize + 1] = {};
+			char EndText[TimeTextSize + 1] = {};
+			FormatTime(StartMs + (EndMs - StartMs) * Bucket / NumBuckets, StartText);
+			FormatTime(StartMs + (EndMs - StartMs) * (Bucket + 1) / NumBuckets, EndText);
+			ImGui::BeginTooltip();
+			ImGui::Text("%s - %s", StartText, EndText);
+			ImGui::Text("%llu lines", (unsigned long long)(BucketLines[Bucket + 1] - BucketLines[Bucket]));
+			for (int Series = 0; Series < NumSeries; ++Series)
+			{
+				ImGui::TextColored(ImColor(GetSeriesColor(Series)), "%s: %.0f", GetSeriesName(Series), BucketCounts[Bucket * NumSeries + Series]);
+			}
+			ImGui::EndTooltip();
+		}
+	}
+	if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left))
+	{
+		DrawList->AddRectFilled(ImVec2(std::min(IO.MouseClickedPos[0].x, IO.MousePos.x), Pos.y), ImVec2(std::max(IO.MouseClickedPos[0].x, IO.MousePos.x), Pos.y + Height),
+			ImGui::GetColorU32(ImGuiCol_TextSelectedBg));
+	}
+	if (ImGui::IsItemDeactivated())
+	{
+		if (ImGui::GetMouseDragDelta(ImGuiMouseButton_Left).x != 0.0f)
+		{
+			const int64_t DragStartMs = GetTimeAt(IO.MouseClickedPos[0].x);
+			const int64_t DragEndMs = GetTimeAt(IO.MousePos.x);
+			SetTimeRangeFilter(LogFile, std::min(DragStartMs, DragEndMs), std::max(DragStartMs, DragEndMs) + 1);
+		}
+		else
+		{
+			// Jump to the start of the clicked bucket
+			const int Bucket = std::min(NumBuckets - 1, int((IO.MousePos.x - Pos.x) / Width * NumBuckets));
+			const int64_t JumpTimeMs = StartMs + (EndMs - StartMs) * Bucket / NumBuckets;
+			LogFile.ScrollRow = double(LogFile.GetDuplicateRuns().FindRow(LogFile.FindDisplayRow(JumpTimeMs)));
+			if (bSyncScrolling)
+			{
+				SyncLeader = FileIdx;
+				SyncTimeMs = JumpTimeMs;
+			}
+		}
+	}
 }
 
-template<class TPred>
-bool ContainsByPred(const std::string& Haystack, const std::string& Needle, TPred Pred)
+/**
+ * Density of errors, warnings, search hits and bookmarks along the display lines, drawn over the scrollbar in a column each.
+ * The layers are binned to one bin per pixel on the workers, so drawing costs O(pixels) however many lines there are.
+ */
+void RenderDensityMap(FLogFile& LogFile, int FileIdx, const FVisibleRows& Visible)
 {
-	return std::search(Haystack.begin(), Haystack.end(), Needle.begin(), Needle.end(), Pred) != Haystack.end();
+	ULV_PROFILE_SCOPE("RenderDensityMap");
+	const FDisplayLines& DisplayLines = LogFile.GetDisplayLines();
+	const FDuplicateRuns& DuplicateRuns = LogFile.GetDuplicateRuns();
+	const float Height = Visible.ScrollbarMax.y - Visible.ScrollbarMin.y;
+	const int NumBins = std::max(1, int(Height));
+	FDensityMap& DensityMap = LogFile.DensityMap;
+	DensityMap.SetDisplayLines(LogFile.ShareDisplayLines(), LogFile.GetDisplayLinesVersion(), NumBins);
+	DensityMap.UpdateLayer(EDensityLayer::Errors, 0, [&]() { return LogFile.ErrorLines; }, App::RequestRedraw);
+	DensityMap.UpdateLayer(EDensityLayer::Warnings, 0, [&]() { return LogFile.WarningLines; }, App::RequestRedraw);
+	// Hits are only binned again at every sixteenth of a search and once it finishes, rather than whenever a chunk does
+	const uint64_t SearchStep = GlobalSearch.IsRunning() ? uint64_t(GlobalSearch.GetProgress() * 16.0f) : 16;
+	const uint64_t HitsVersion = (SearchGeneration << 8) + SearchStep;
+	DensityMap.UpdateSearchHits(HitsVersion, [&]() { return GlobalSearch.GetFileHits(size_t(FileIdx)); }, App::RequestRedraw);
+	DensityMap.UpdateLayer(EDensityLayer::Bookmarks, LogFile.BookmarksVersion, [&]() { return LogFile.Bookmarks; }, App::RequestRedraw);
+	DensityMap.Poll();
+
+	static const ImVec4 SearchHitColor(1.0f, 0.5f, 0.0f, 1.0f);
+	const ImVec4* LayerColors[(int)EDensityLayer::MAX] = { &TextColor_Error, &TextColor_Warning, &SearchHitColor, &TextColor_Bookmark };
+	const float LayerWidth = (Visible.ScrollbarMax.x - Visible.ScrollbarMin.x) / float(EDensityLayer::MAX);
+	const uint64_t NumDisplayRows = DisplayLines.Num();
+	const bool bCollapsed = DuplicateRuns.Num() != NumDisplayRows;
+	ImDrawList* DrawList = ImGui::GetWindowDrawList();
+	for (int Layer = 0; Layer < (int)EDensityLayer::MAX; ++Layer)
+	{
+		const std::vector<uint32_t>& Bins = DensityMap.GetBins(EDensityLayer(Layer));
+		const float MaxBin = float(DensityMap.GetMaxBin(EDensityLayer(Layer)));
+		const float MinX = Visible.ScrollbarMin.x + Layer * LayerWidth;
+		for (size_t Bin = 0; Bin < Bins.size(); ++Bin)
+		{
+			if (Bins[Bin] == 0) continue;
+			// Bins split the display rows, collapsed runs of duplicates squeeze the rows of the scrollbar
+			float Y = Height * Bin / Bins.size();
+			if (bCollapsed)
+			{
+				Y = Height * float(DuplicateRuns.FindRow(NumDisplayRows * Bin / Bins.size())) / float(std::max<uint64_t>(DuplicateRuns.Num(), 1));
+			}
+			ImVec4 Color = *LayerColors[Layer];
+			Color.w = 0.35f + 0.65f * sqrtf(Bins[Bin] / MaxBin);
+			DrawList->AddRectFilled(ImVec2(MinX, Visible.ScrollbarMin.y + Y), ImVec2(MinX + LayerWidth, Visible.ScrollbarMin.y + Y + 1.0f), ImGui::GetColorU32(Color));
+		}
+	}
 }
 
-/** Returns true if we should include the line */
-bool DoFilterLine(const std::vector<FLineFilter>& Filters, const std::string& Line)
+void RenderTextWindow(FLogFile& LogFile, int FileIdx)
 {
-	auto SearchPredCaseInvariant = [](char ch1, char ch2) { return toupper(ch1) == toupper(ch2); };
+	ULV_PROFILE_SCOPE("RenderTextWindow");
+	const FDisplayLines& DisplayLines = LogFile.GetDisplayLines();
+	// Rows are display rows with the collapsed runs of duplicates left out
+	const FDuplicateRuns& DuplicateRuns = LogFile.GetDuplicateRuns();
+	const uint64_t NumRows = DuplicateRuns.Num();
+	const int NumLineNumChars = GetNumLineNumberChars(LogFile);
+	const bool bSyncTimes = bSyncScrolling && LogFile.LineTimes.HasTimes();
+	if (bSyncTimes && SyncLeader != FileIdx && SyncTimeMs != FLineTimes::NoTime)
+	{
+		LogFile.ScrollRow = double(DuplicateRuns.FindRow(LogFile.FindDisplayRow(SyncTimeMs)));
+	}
+	if (bShowTimeline && LogFile.LineTimes.HasTimes())
+	{
+		const uint64_t ScrollRow = std::min(uint64_t(LogFile.ScrollRow), NumRows);
+		RenderTimeline(LogFile, FileIdx, ScrollRow < NumRows ? LogFile.LineTimes[DisplayLines[DuplicateRuns.GetDisplayRow(ScrollRow)]] : FLineTimes::NoTime);
+	}
+
+	int64_t ToggledRunIdx = -1;
+	const bool bContextGroups = LogFile.HasContextGroups();
+	const FVisibleRows Visible = RenderScrolledRows(NumRows, LogFile.ScrollRow, LogFile.ScrollDirection, FileIdx, [&](uint64_t Row)
+	{
+		int64_t RunIdx;
+		const uint64_t DisplayRow = DuplicateRuns.GetDisplayRow(Row, RunIdx);
+		if (bContextGroups && DisplayRow > 0 && DisplayLines[DisplayRow] != DisplayLines[DisplayRow - 1] + 1)
+		{
+			// Lines were skipped between this group of matches and context lines and the one before it
+			const ImVec2 Pos = ImGui::GetCursorScreenPos();
+			ImGui::GetWindowDrawList()->AddLine(ImVec2(Pos.x, Pos.y), ImVec2(Pos.x + ImGui::GetContentRegionAvail().x, Pos.y), ImGui::GetColorU32(ImGuiCol_Separator));
+		}
+		if (RunIdx >= 0)
+		{
+			// "xN" and the time from the first to the last line of the run, click to expand or collapse it
+			const uint64_t RunNumRows = DuplicateRuns.GetRunNumDisplayRows(size_t(RunIdx));
+			const uint64_t LastLine = DisplayLines[DuplicateRuns.GetRunFirstDisplayRow(size_t(RunIdx)) + RunNumRows - 1];
+			const double SpanSeconds = LogFile.LineTimes.HasTimes() ? (LogFile.LineTimes[LastLine] - LogFile.LineTimes[DisplayLines[DisplayRow]]) / 1000.0 : 0.0;
+			char Label[64];
+			snprintf(Label, sizeof(Label), "%s\xC3\x97%llu %.1fs", DuplicateRuns.IsRunExpanded(size_t(RunIdx)) ? "-" : "+", (unsigned long long)RunNumRows, SpanSeconds);
+			if (ImGui::SmallButton(Label))
+			{
+				ToggledRunIdx = RunIdx;
+			}
+			ImGui::SameLine();
+		}
+		RenderLogLine(LogFile, DisplayLines[DisplayRow], NumLineNumChars);
+	});
+	if (ToggledRunIdx >= 0)
+	{
+		LogFile.SetDuplicateRunExpanded(size_t(ToggledRunIdx), !DuplicateRuns.IsRunExpanded(size_t(ToggledRunIdx)));
+	}
+	if (bShowDensityMap)
+	{
+		RenderDensityMap(LogFile, FileIdx, Visible);
+	}
+	if (bSyncTimes && Visible.bUserScrolled && Visible.FirstRow < NumRows)
+	{
+		SyncLeader = FileIdx;
+		SyncTimeMs = LogFile.LineTimes[DisplayLines[DuplicateRuns.GetDisplayRow(Visible.FirstRow)]];
+	}
+
+	if (NumRows > 0)
+	{
+		const uint64_t PrefetchRow = DuplicateRuns.GetDisplayRow(GetPrefetchRow(Visible, NumRows, LogFile.ScrollDirection));
+		LogFile.Lines.Prefetch(size_t(DisplayLines[PrefetchRow] >> FLineStore::LinesPerBlockLog2));
+	}
+}
+
+ImVec4 GetMergedSourceColor(size_t FileIdx)
+{
+	return ImColor::HSV(fmodf(FileIdx * 0.618f, 1.0f), 0.6f, 1.0f);
+}
+
+void RenderMergedWindow()
+{
+	ULV_PROFILE_SCOPE("RenderMergedWindow");
+	if (bFocusMergedView)
+	{
+		// Bring the view to the front of its dock node when it is turned on
+		ImGui::SetNextWindowFocus();
+		bFocusMergedView = false;
+	}
+	if (!ImGui::Begin("Merged View", &bShowMergedView))
+	{
+		ImGui::End();
+		return;
+	}
+
+	// Legend, which doubles as the choice of files to merge
+	std::vector<const FLogFile*> Sources;
+	std::vector<size_t> SourceFileIdxs;
+	int NumLineNumChars = 1;
+	for (size_t FileIdx = 0; FileIdx < OpenFiles.size(); ++FileIdx)
+	{
+		FLogFile& File = OpenFiles[FileIdx];
+		ImGui::PushID(int(FileIdx));
+		ImGui::Checkbox("##InMergedView", &File.bInMergedView);
+		ImGui::SameLine();
+		ImGui::TextColored(GetMergedSourceColor(FileIdx), "[%d] %s", int(FileIdx + 1), File.FilePath.c_str());
+		if (!File.LineTimes.HasTimes())
+		{
+			ImGui::SameLine();
+			ImGui::TextDisabled("(no timestamps)");
+		}
+		ImGui::PopID();
+		if (File.bInMergedView)
+		{
+			File.LastViewedFrame = ImGui::GetFrameCount();
+			Sources.push_back(&File);
+			SourceFileIdxs.push_back(FileIdx);
+			NumLineNumChars = std::max(NumLineNumChars, GetNumLineNumberChars(File));
+		}
+	}
+	ImGui::Separator();
+	MergedLines.SetSources(Sources);
+	if (bSyncScrolling && SyncLeader != MergedViewSyncLeader && SyncTimeMs != FLineTimes::NoTime)
+	{
+		MergedScrollRow = double(MergedLines.FindTimeRow(SyncTimeMs));
+	}
+
+	// Only the first visible row is seeked to, every row after it is the next step of the merge
+	FMergedLines::FCursor Cursor;
+	bool bCursorValid = false;
+	const uint64_t NumRows = MergedLines.Num();
+	const FVisibleRows Visible = RenderScrolledRows(NumRows, MergedScrollRow, MergedScrollDirection, MergedViewSyncLeader, [&](uint64_t Row)
+	{
+		if (!bCursorValid)
+		{
+			Cursor = MergedLines.Seek(Row);
+			bCursorValid = true;
+		}
+		const FMergedRow MergedRow = *Cursor;
+		const size_t FileIdx = SourceFileIdxs[MergedRow.SourceIdx];
+		ImGui::TextColored(GetMergedSourceColor(FileIdx), "[%d]", int(FileIdx + 1));
+		ImGui::SameLine();
+		RenderLogLine(OpenFiles[FileIdx], MergedRow.LineIdx, NumLineNumChars);
+		Cursor.Next();
+	});
+	if (bSyncScrolling && Visible.bUserScrolled && Visible.FirstRow < NumRows)
+	{
+		const FMergedRow FirstRow = *MergedLines.Seek(Visible.FirstRow);
+		SyncLeader = MergedViewSyncLeader;
+		SyncTimeMs = OpenFiles[SourceFileIdxs[FirstRow.SourceIdx]].LineTimes[FirstRow.LineIdx];
+	}
+
+	if (NumRows > 0)
+	{
+		const FMergedRow PrefetchRow = *MergedLines.Seek(GetPrefetchRow(Visible, NumRows, MergedScrollDirection));
+		OpenFiles[SourceFileIdxs[PrefetchRow.SourceIdx]].Lines.Prefetch(size_t(PrefetchRow.LineIdx >> FLineStore::LinesPerBlockLog2));
+	}
+	ImGui::End();
+}
+
+void CompareDiffFiles()
+{
+	if (DiffLeftFileIdx >= int(OpenFiles.size()) || DiffRightFileIdx >= int(OpenFiles.size())) return;
+	LogDiff.Compare(OpenFiles[DiffLeftFileIdx], OpenFiles[DiffRightFileIdx], DiffOptions, App::RequestRedraw);
+	DiffScrollRow = 0.0;
+}
+
+void RenderDiffWindow()
+{
+	ULV_PROFILE_SCOPE("RenderDiffWindow");
+	LogDiff.Poll();
+	if (bFocusDiff)
+	{
+		ImGui::SetNextWindowFocus();
+		bFocusDiff = false;
+	}
+	if (!ImGui::Begin("Diff", &bShowDiff))
+	{
+		ImGui::End();
+		return;
+	}
+
+	auto GetFilePath = [](void*, int Idx, const char** OutText) { *OutText = OpenFiles[Idx].FilePath.c_str(); return true; };
+	ImGui::PushItemWidth(ImGui::GetWindowContentRegionWidth() * 0.3f);
+	bool bFilesChanged = ImGui::Combo("Left", &DiffLeftFileIdx, GetFilePath, nullptr, int(OpenFiles.size()));
+	ImGui::SameLine();
+	bFilesChanged |= ImGui::Combo("Right", &DiffRightFileIdx, GetFilePath, nullptr, int(OpenFiles.size()));
+	ImGui::PopItemWidth();
+	if (bFilesChanged)
+	{
+		LogDiff.Cancel();
+		LogDiff.Reset();
+	}
+	ImGui::Checkbox("Ignore Numbers", &DiffOptions.bIgnoreNumbers);
+	ImGui::SameLine();
+	ImGui::Checkbox("Ignore GUIDs", &DiffOptions.bIgnoreGuids);
+	ImGui::SameLine();
+	ImGui::Checkbox("Ignore Addresses", &DiffOptions.bIgnoreAddresses);
+	ImGui::SameLine();
+	if (LogDiff.IsRunning())
+	{
+		ImGui::ProgressBar(LogDiff.GetProgress(), ImVec2(ImGui::GetWindowContentRegionWidth() * 0.2f, 0.0f), LogDiff.GetProgress() < 1.0f ? nullptr : "Diffing");
+		ImGui::SameLine();
+		if (ImGui::Button("Cancel"))
+		{
+			LogDiff.Cancel();
+		}
+		// Keep the progress bar moving, the compare only wakes us up once it is done
+		App::RequestRedraw();
+	}
+	else if (ImGui::Button("Compare"))
+	{
+		CompareDiffFiles();
+	}
+
+	// Which lines to show, on top of the filters of each file
+	uint32_t ShownOpsMask = 0;
+	for (int Op = 0; Op < (int)EDiffOp::MAX; ++Op)
+	{
+		if (Op > 0) ImGui::SameLine();
+		ImGui::Checkbox(EDiffOpStrings[Op], &bDiffShowOps[Op]);
+		ShownOpsMask |= bDiffShowOps[Op] ? 1u << Op : 0;
+	}
+	ImGui::SameLine();
+	ImGui::TextDisabled("%llu removed, %llu added, %llu in common, took %.0f ms", (unsigned long long)LogDiff.GetNumLines(EDiffOp::Removed),
+		(unsigned long long)LogDiff.GetNumLines(EDiffOp::Added), (unsigned long long)LogDiff.GetNumLines(EDiffOp::Common), LogDiff.GetCompareMs());
+	ImGui::Separator();
+
+	if (LogDiff.IsEmpty() || DiffLeftFileIdx >= int(OpenFiles.size()) || DiffRightFileIdx >= int(OpenFiles.size()))
+	{
+		ImGui::TextDisabled(LogDiff.IsRunning() ? "Comparing..." : "Pick two files and Compare them");
+		ImGui::End();
+		return;
+	}
+
+	FLogFile& LeftFile = OpenFiles[DiffLeftFileIdx];
+	FLogFile& RightFile = OpenFiles[DiffRightFileIdx];
+	LeftFile.LastViewedFrame = RightFile.LastViewedFrame = ImGui::GetFrameCount();
+	LogDiff.UpdateRows(LeftFile, RightFile, ShownOpsMask);
+	const int NumLineNumChars = std::max(GetNumLineNumberChars(LeftFile), GetNumLineNumberChars(RightFile));
+	const uint64_t NumRows = LogDiff.Num();
+	const FVisibleRows Visible = RenderScrolledRows(NumRows, DiffScrollRow, DiffScrollDirection, NotSyncedView, [&](uint64_t Row)
+	{
+		static const char* OpMarkers[(int)EDiffOp::MAX] = { " ", "-", "+" };
+		static const ImVec4 OpColors[(int)EDiffOp::MAX] = { ImVec4(0.5f, 0.5f, 0.5f, 1.0f), ImVec4(1.0f, 0.4f, 0.4f, 1.0f), ImVec4(0.4f, 1.0f, 0.4f, 1.0f) };
+		const FDiffRow DiffRow = LogDiff[Row];
+		ImGui::TextColored(OpColors[(int)DiffRow.Op], "%s", OpMarkers[(int)DiffRow.Op]);
+		ImGui::SameLine();
+		RenderLogLine(DiffRow.Op == EDiffOp::Added ? RightFile : LeftFile, DiffRow.LineIdx, NumLineNumChars);
+	});
+
+	if (NumRows > 0)
+	{
+		const FDiffRow PrefetchRow = LogDiff[GetPrefetchRow(Visible, NumRows, DiffScrollDirection)];
+		(PrefetchRow.Op == EDiffOp::Added ? RightFile : LeftFile).Lines.Prefetch(size_t(PrefetchRow.LineIdx >> FLineStore::LinesPerBlockLog2));
+	}
+	ImGui::End();
+}
+
+void StartSearch()
+{
+	std::vector<const FLineStore*> Files;
+	for (const FLogFile& File : OpenFiles)
+	{
+		Files.push_back(&File.Lines);
+	}
+	bSearchQueryValid = GlobalSearch.Start(Files, SearchQuery, App::RequestRedraw);
+	++SearchGeneration;
+}
+
+/** Scrolls a file to a line, or the first line after it that passes the filters, and brings its window to the front */
+void JumpToLine(int FileIdx, uint64_t LineIdx)
+{
+	FLogFile& File = OpenFiles[FileIdx];
+	File.ScrollRow = double(File.GetDuplicateRuns().FindRow(File.GetDisplayLines().FindRow(LineIdx)));
+	if (bSyncScrolling && File.LineTimes.HasTimes())
+	{
+		SyncLeader = FileIdx;
+		SyncTimeMs = File.LineTimes[LineIdx];
+	}
+	ImGui::SetWindowFocus(File.FilePath.c_str());
+}
+
+void RenderSearchWindow()
+{
+	ULV_PROFILE_SCOPE("RenderSearchWindow");
+	if (bFocusSearch)
+	{
+		ImGui::SetNextWindowFocus();
+		bFocusSearch = false;
+	}
+	if (!ImGui::Begin("Search", &bShowSearch))
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::PushItemWidth(ImGui::GetWindowContentRegionWidth() * 0.5f);
+	InputTextBox("##Query", SearchQuery.Text);
+	ImGui::PopItemWidth();
+	bool bStartSearch = ImGui::IsItemFocused() && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Enter));
+	ImGui::SameLine();
+	ImGui::Checkbox("Case Sensitive", &SearchQuery.bCaseMatch);
+	ImGui::SameLine();
+	ImGui::Checkbox("Regex", &SearchQuery.bRegex);
+	ImGui::SameLine();
+	bStartSearch |= ImGui::Button("Search");
+	if (bStartSearch)
+	{
+		StartSearch();
+	}
+
+	if (!bSearchQueryValid)
+	{
+		ImGui::TextColored(TextColor_Error, "Invalid regex");
+	}
+	else if (GlobalSearch.IsRunning())
+	{
+		ImGui::ProgressBar(GlobalSearch.GetProgress(), ImVec2(ImGui::GetWindowContentRegionWidth() * 0.5f, 0.0f));
+		ImGui::SameLine();
+		if (ImGui::Button("Cancel"))
+		{
+			GlobalSearch.Cancel();
+		}
+	}
+	else if (GlobalSearch.NumFiles() > 0)
+	{
+		ImGui::TextDisabled("Searched %d files in %.0f ms", int(GlobalSearch.NumFiles()), GlobalSearch.GetSearchMs());
+	}
+	ImGui::Separator();
+
+	// Hits grouped under a row per file, a click on a hit scrolls the file to it
+	std::vector<FGlobalSearch::FFileHits> FileHits;
+	FileHits.reserve(GlobalSearch.NumFiles());
+	uint64_t NumRows = 0;
+	for (size_t FileIdx = 0; FileIdx < GlobalSearch.NumFiles() && FileIdx < OpenFiles.size(); ++FileIdx)
+	{
+		FileHits.push_back(GlobalSearch.GetFileHits(FileIdx));
+		NumRows += 1 + (OpenFiles[FileIdx].bSearchHitsCollapsed ? 0 : FileHits.back().Num());
+	}
+	if (ImGui::BeginChild("Hits"))
+	{
+		size_t FileIdx = 0;
+		uint64_t FileFirstRow = 0;
+		int ToggledFileIdx = -1;
+		RenderScrolledRows(NumRows, SearchScrollRow, SearchScrollDirection, ListView, [&](uint64_t Row)
+		{
+			while (Row >= FileFirstRow + 1 + (OpenFiles[FileIdx].bSearchHitsCollapsed ? 0 : FileHits[FileIdx].Num()))
+			{
+				FileFirstRow += 1 + (OpenFiles[FileIdx].bSearchHitsCollapsed ? 0 : FileHits[FileIdx].Num());
+				++FileIdx;
+			}
+			FLogFile& File = OpenFiles[FileIdx];
+			const FGlobalSearch::FFileHits& Hits = FileHits[FileIdx];
+			if (Row == FileFirstRow)
+			{
+				ImGui::SetNextItemOpen(!File.bSearchHitsCollapsed);
+				if (ImGui::TreeNodeEx("##File", ImGuiTreeNodeFlags_NoTreePushOnOpen, "%s (%llu hits)", File.FilePath.c_str(), (unsigned long long)Hits.Num()) == File.bSearchHitsCollapsed)
+				{
+					ToggledFileIdx = int(FileIdx);
+				}
+				return;
+			}
+			const uint64_t LineIdx = Hits[Row - FileFirstRow - 1];
+			const FLineRef Line = File.Lines.GetLine(LineIdx);
+			const float StartX = ImGui::GetCursorPosX();
+			if (ImGui::Selectable("##Hit"))
+			{
+				JumpToLine(int(FileIdx), LineIdx);
+			}
+			ImGui::SameLine(StartX);
+			ImGui::TextDisabled("%llu", (unsigned long long)(LineIdx + 1));
+			ImGui::SameLine(StartX + GetNumLineNumberChars(File) * ImGui::GetFontSize());
+			ImGui::TextUnformatted(Line.Text.begin(), Line.Text.end());
+		});
+		if (ToggledFileIdx >= 0)
+		{
+			OpenFiles[ToggledFileIdx].bSearchHitsCollapsed = !OpenFiles[ToggledFileIdx].bSearchHitsCollapsed;
+		}
+	}
+	ImGui::EndChild();
+	ImGui::End();
+}
+
+/** Includes or excludes the lines of a template, reusing the filter of that template if there is one */
+void AddTemplateFilter(FLogFile& File, uint32_t TemplateId, bool bExclude)
+{
+	const EFilterType Type = bExclude ? EFilterType::TemplateExclude : EFilterType::TemplateInclude;
+	auto FilterIt = std::find_if(File.Filters.begin(), File.Filters.end(), [&](const FLineFilter& Filter)
+	{
+		return (Filter.Type == EFilterType::TemplateInclude || Filter.Type == EFilterType::TemplateExclude) && Filter.TemplateData.TemplateId == TemplateId;
+	});
+	if (FilterIt == File.Filters.end())
+	{
+		FilterIt = File.Filters.emplace(File.Filters.end());
+		FilterIt->TemplateData.TemplateId = TemplateId;
+	}
+	FilterIt->Type = Type;
+	FilterIt->TemplateData.Text = File.Templates[TemplateId].Text;
+	FilterIt->bEnable = true;
+	File.bDisplayTextDirty = true;
+}
+
+void RenderPatternsWindow()
+{
+	ULV_PROFILE_SCOPE("RenderPatternsWindow");
+	if (bFocusPatterns)
+	{
+		ImGui::SetNextWindowFocus();
+		bFocusPatterns = false;
+	}
+	if (!ImGui::Begin("Patterns", &bShowPatterns))
+	{
+		ImGui::End();
+		return;
+	}
+
+	auto GetFilePath = [](void*, int Idx, const char** OutText) { *OutText = OpenFiles[Idx].FilePath.c_str(); return true; };
+	ImGui::PushItemWidth(ImGui::GetWindowContentRegionWidth() * 0.5f);
+	ImGui::Combo("File", &PatternsFileIdx, GetFilePath, nullptr, int(OpenFiles.size()));
+	ImGui::PopItemWidth();
+	if (PatternsFileIdx >= int(OpenFiles.size()))
+	{
+		ImGui::End();
+		return;
+	}
+
+	FLogFile& File = OpenFiles[PatternsFileIdx];
+	FLogTemplates& Templates = File.Templates;
+	File.UpdateTemplates(App::RequestRedraw);
+	if (File.IsMiningTemplates())
+	{
+		ImGui::SameLine();
+		ImGui::ProgressBar(File.GetMiningProgress(), ImVec2(ImGui::GetWindowContentRegionWidth() * 0.3f, 0.0f), "Mining...");
+		// Keep the progress bar moving, mining only wakes us up once it is done
+		App::RequestRedraw();
+		ImGui::End();
+		return;
+	}
+	if (PatternOrderFileIdx != PatternsFileIdx || PatternOrderNumLines != Templates.NumLines())
+	{
+		PatternOrder.resize(Templates.Num());
+		for (uint32_t TemplateId = 0; TemplateId < Templates.Num(); ++TemplateId)
+		{
+			PatternOrder[TemplateId] = TemplateId;
+		}
+		std::stable_sort(PatternOrder.begin(), PatternOrder.end(), [&](uint32_t A, uint32_t B) { return Templates[A].NumLines > Templates[B].NumLines; });
+		PatternOrderFileIdx = PatternsFileIdx;
+		PatternOrderNumLines = Templates.NumLines();
+	}
+	ImGui::SameLine();
+	ImGui::TextDisabled("%u patterns in %llu lines, mined in %.0f ms", Templates.Num(), (unsigned long long)Templates.NumLines(), Templates.GetUpdateMs());
+	ImGui::Separator();
+
+	// One row per template: include and exclude buttons, line count, first and last line, lines over time and the template
+	const float FontSize = ImGui::GetFontSize();
+	const float CountX = 3.0f * FontSize;
+	const float FirstLineX = CountX + 4.0f * FontSize;
+	const float LastLineX = FirstLineX + 4.0f * FontSize;
+	const float SparklineX = LastLineX + 4.0f * FontSize;
+	const float TextX = SparklineX + 7.0f * FontSize;
+	const float StartX = ImGui::GetCursorPosX();
+	ImGui::TextDisabled("Filter");
+	ImGui::SameLine(StartX + CountX);
+	ImGui::TextDisabled("Lines");
+	ImGui::SameLine(StartX + FirstLineX);
+	ImGui::TextDisabled("First");
+	ImGui::SameLine(StartX + LastLineX);
+	ImGui::TextDisabled("Last");
+	ImGui::SameLine(StartX + SparklineX);
+	ImGui::TextDisabled("Over Time");
+	ImGui::SameLine(StartX + TextX);
+	ImGui::TextDisabled("Pattern");
+
+	if (ImGui::BeginChild("PatternRows", ImVec2(0.0f, 0.0f), false, ImGuiWindowFlags_HorizontalScrollbar))
+	{
+		ImGuiListClipper Clipper(int(PatternOrder.size()));
+		while (Clipper.Step())
+		{
+			for (int RowIdx = Clipper.DisplayStart; RowIdx < Clipper.DisplayEnd; ++RowIdx)
+			{
+				const uint32_t TemplateId = PatternOrder[RowIdx];
+				const FLogTemplate& Template = Templates[TemplateId];
+				ImGui::PushID(int(TemplateId));
+				const float RowX = ImGui::GetCursorPosX();
+				if (ImGui::SmallButton("+"))
+				{
+					AddTemplateFilter(File, TemplateId, false);
+				}
+				ImGui::SameLine();
+				if (ImGui::SmallButton("-"))
+				{
+					AddTemplateFilter(File, TemplateId, true);
+				}
+				ImGui::SameLine(RowX + CountX);
+				ImGui::Text("%llu", (unsigned long long)Template.NumLines);
+				ImGui::SameLine(RowX + FirstLineX);
+				char Label[32];
+				snprintf(Label, sizeof(Label), "%llu##First", (unsigned long long)(Template.FirstLine + 1));
+				if (ImGui::Selectable(Label, false, 0, ImVec2(3.5f * FontSize, 0.0f)))
+				{
+					JumpToLine(PatternsFileIdx, Template.FirstLine);
+				}
+				ImGui::SameLine(RowX + LastLineX);
+				snprintf(Label, sizeof(Label), "%llu##Last", (unsigned long long)(Template.LastLine + 1));
+				if (ImGui::Selectable(Label, false, 0, ImVec2(3.5f * FontSize, 0.0f)))
+				{
+					JumpToLine(PatternsFileIdx, Template.LastLine);
+				}
+				ImGui::SameLine(RowX + SparklineX);
+				const uint32_t* Sparkline = Templates.GetSparkline(TemplateId, File.LineTimes);
+				float SparklineValues[FLogTemplates::NumSparklineBuckets];
+				for (int BucketIdx = 0; BucketIdx < FLogTemplates::NumSparklineBuckets; ++BucketIdx)
+				{
+					SparklineValues[BucketIdx] = float(Sparkline[BucketIdx]);
+				}
+				ImGui::PlotHistogram("##Sparkline", SparklineValues, FLogTemplates::NumSparklineBuckets, 0, nullptr, 0.0f, FLT_MAX, ImVec2(6.5f * FontSize, ImGui::GetTextLineHeight()));
+				ImGui::SameLine(RowX + TextX);
+				ImGui::TextUnformatted(Template.Text.c_str(), Template.Text.c_str() + Template.Text.size());
+				ImGui::PopID();
+			}
+		}
+	}
+	ImGui::EndChild();
+	ImGui::End();
+}
+
+void RenderFieldsWindow()
+{
+	ULV_PROFILE_SCOPE("RenderFieldsWindow");
+	if (bFocusFields)
+	{
+		ImGui::SetNextWindowFocus();
+		bFocusFields = false;
+	}
+	if (!ImGui::Begin("Fields", &bShowFields))
+	{
+		ImGui::End();
+		return;
+	}
+
+	auto GetFilePath = [](void*, int Idx, const char** OutText) { *OutText = OpenFiles[Idx].FilePath.c_str(); return true; };
+	ImGui::PushItemWidth(ImGui::GetWindowContentRegionWidth() * 0.5f);
+	ImGui::Combo("File", &FieldsFileIdx, GetFilePath, nullptr, int(OpenFiles.size()));
+	InputTextBox("Anchor", FieldRule.Anchor);
+	bool bExtract = ImGui::IsItemFocused() && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Enter));
+	ImGui::PopItemWidth();
+	ImGui::PushItemWidth(8.0f * ImGui::GetFontSize());
+	ImGui::Combo("Type", (int*)&FieldRule.Type, EFieldTypeStrings, (int)EFieldType::MAX);
+	ImGui::PopItemWidth();
+	ImGui::SameLine();
+	bExtract |= ImGui::Button("Extract");
+	if (bExtract)
+	{
+		ExtractedFieldRule = FieldRule;
+		FieldExtractionFileIdx = -1;
+	}
+	if (FieldsFileIdx >= int(OpenFiles.size()) || ExtractedFieldRule.Anchor.empty())
+	{
+		ImGui::End();
+		return;
+	}
+
+	// The last column is shown until the next one is extracted
+	FLogFile& ExtractedFile = OpenFiles[FieldsFileIdx];
+	if (FieldExtractionFileIdx != FieldsFileIdx || FieldExtractionDisplayLinesVersion != ExtractedFile.GetDisplayLinesVersion())
+	{
+		FieldExtraction.Start(ExtractedFile.Lines, ExtractedFile.ShareDisplayLines(), ExtractedFile.LineTimes, ExtractedFieldRule, App::RequestRedraw);
+		FieldExtractionFileIdx = FieldsFileIdx;
+		FieldExtractionDisplayLinesVersion = ExtractedFile.GetDisplayLinesVersion();
+	}
+	if (FieldExtraction.Poll())
+	{
+		FieldColumnFileIdx = FieldExtractionFileIdx;
+		FieldsScrollRow = 0.0;
+	}
+	if (FieldExtraction.IsRunning())
+	{
+		ImGui::TextDisabled("Extracting...");
+		if (FieldColumnFileIdx < 0)
+		{
+			ImGui::End();
+			return;
+		}
+	}
+
+	FLogFile& File = OpenFiles[FieldColumnFileIdx];
+	const FFieldColumn& FieldColumn = FieldExtraction.GetColumn();
+	const FFieldStats& Stats = FieldColumn.GetStats();
+	ImGui::TextDisabled("%llu values of \"%s\", extracted in %.0f ms and sorted in %.0f ms", (unsigned long long)Stats.Count,
+		FieldColumn.GetRule().Anchor.c_str(), FieldColumn.GetExtractMs(), FieldColumn.GetSortMs());
+	ImGui::Text("Min %g  Max %g  Mean %g  P50 %g  P95 %g  P99 %g", Stats.Min, Stats.Max, Stats.Mean, Stats.P50, Stats.P95, Stats.P99);
+
+	// Spread of the values from the smallest to the largest, and their mean over time
+	const float FontSize = ImGui::GetFontSize();
+	const ImVec2 PlotSize((ImGui::GetWindowContentRegionWidth() - ImGui::GetStyle().ItemSpacing.x) * 0.5f, 5.0f * FontSize);
+	const std::vector<float>& Histogram = FieldColumn.GetHistogram();
+	const std::vector<float>& TimeMeans = FieldColumn.GetTimeMeans();
+	ImGui::PlotHistogram("##Histogram", Histogram.data(), int(Histogram.size()), 0, "Distribution", 0.0f, FLT_MAX, PlotSize);
+	ImGui::SameLine();
+	ImGui::PlotLines("##OverTime", TimeMeans.data(), int(TimeMeans.size()), 0, "Mean Over Time", FLT_MAX, FLT_MAX, PlotSize);
+
+	ImGui::Checkbox("Sort by Value", &bFieldsByValue);
+	ImGui::SameLine();
+	ImGui::Checkbox("Descending", &bFieldsDescending);
+	ImGui::Separator();
+
+	// One row per value, in line order or by value, a click scrolls the file to the line
+	if (ImGui::BeginChild("FieldRows"))
+	{
+		const uint64_t NumValues = FieldColumn.Num();
+		const int NumLineNumChars = GetNumLineNumberChars(File);
+		RenderScrolledRows(NumValues, FieldsScrollRow, FieldsScrollDirection, ListView, [&](uint64_t Row)
+		{
+			const uint64_t Rank = bFieldsDescending ? NumValues - 1 - Row : Row;
+			const uint64_t ValueIdx = bFieldsByValue ? FieldColumn.GetSortedIdx(Rank) : Rank;
+			const uint64_t LineIdx = FieldColumn.GetLine(ValueIdx);
+			const FLineRef Line = File.Lines.GetLine(LineIdx);
+			const float StartX = ImGui::GetCursorPosX();
+			if (ImGui::Selectable("##Value"))
+			{
+				JumpToLine(FieldColumnFileIdx, LineIdx);
+			}
+			ImGui::SameLine(StartX);
+			ImGui::TextDisabled("%llu", (unsigned long long)(LineIdx + 1));
+			ImGui::SameLine(StartX + NumLineNumChars * FontSize);
+			ImGui::Text("%g", FieldColumn.GetValue(ValueIdx));
+			ImGui::SameLine(StartX + (NumLineNumChars + 6) * FontSize);
+			ImGui::TextUnformatted(Line.Text.begin(), Line.Text.end());
+		});
+	}
+	ImGui::EndChild();
+	ImGui::End();
+}
+
+void FormatBytes(char (&OutText)[32], uint64_t NumBytes)
+{
+	if (NumBytes >= 1024ull * 1024 * 1024) snprintf(OutText, sizeof(OutText), "%.2f GB", NumBytes / (1024.0 * 1024.0 * 1024.0));
+	else if (NumBytes >= 1024ull * 1024) snprintf(OutText, sizeof(OutText), "%.1f MB", NumBytes / (1024.0 * 1024.0));
+	else if (NumBytes >= 1024ull) snprintf(OutText, sizeof(OutText), "%.1f KB", NumBytes / 1024.0);
+	else snprintf(OutText, sizeof(OutText), "%llu B", (unsigned long long)NumBytes);
+}
+
+uint64_t GetTotalMemoryUsage()
+{
+	uint64_t TotalBytes = 0;
+	for (const FLogFile& File : OpenFiles)
+	{
+		TotalBytes += File.GetMemoryUsage().GetTotal();
+	}
+	return TotalBytes;
+}
+
+/** Evicts caches, least recently viewed file first, until we are back under budget. Files visible this frame are kept. */
+void EnforceMemoryBudget()
+{
+	if (MemoryBudgetBytes == 0) return;
+
+	uint64_t TotalBytes = GetTotalMemoryUsage();
+	if (TotalBytes <= MemoryBudgetBytes) return;
+
+	ULV_PROFILE_SCOPE("EnforceMemoryBudget");
+	const uint64_t CurrentFrame = ImGui::GetFrameCount();
+	std::vector<FLogFile*> EvictableFiles;
+	for (FLogFile& File : OpenFiles)
+	{
+		if (File.LastViewedFrame != CurrentFrame) EvictableFiles.push_back(&File);
+	}
+	std::sort(EvictableFiles.begin(), EvictableFiles.end(), [](const FLogFile* A, const FLogFile* B) { return A->LastViewedFrame < B->LastViewedFrame; });
+	for (FLogFile* File : EvictableFiles)
+	{
+		TotalBytes -= File->EvictCaches();
+		if (TotalBytes <= MemoryBudgetBytes) break;
+	}
+}
+
+void RenderMemoryWindow()
+{
+	if (!ImGui::Begin("Memory", &bShowMemory))
+	{
+		ImGui::End();
+		return;
+	}
 
-	bool bIncluded = false;
-	bool bExcluded = false;
-	bool bIncludeFilterEncountered = false;
+	int BudgetMB = int(MemoryBudgetBytes / (1024 * 1024));
+	if (ImGui::InputInt("Budget (MB, 0 = unlimited)", &BudgetMB, 64, 1024))
+	{
+		MemoryBudgetBytes = uint64_t(std::max(BudgetMB, 0)) * 1024 * 1024;
+	}
+	int PageCacheMB = int(PageCacheBytes / (1024 * 1024));
+	if (ImGui::InputInt("Page cache per file (MB)", &PageCacheMB, 64, 1024))
+	{
+		PageCacheBytes = uint64_t(std::max(PageCacheMB, 1)) * 1024 * 1024;
+		for (FLogFile& File : OpenFiles) File.Lines.SetCacheBudget(PageCacheBytes);
+	}
+	if (ImGui::Button("Evict Caches"))
+	{
+		for (FLogFile& File : OpenFiles) File.EvictCaches();
+	}
 
-	for (const FLineFilter& Filter : Filters)
+	ImGui::Separator();
+	ImGui::Columns(8, "MemoryUsage");
+	const char* Headers[] = { "File", "Text", "Line index", "Metadata", "Display lines", "Filter caches", "Search indexes", "Total" };
+	for (const char* Header : Headers)
 	{
-		if (bExcluded) break;
-		if (!Filter.bEnable) continue;
+		ImGui::TextUnformatted(Header); ImGui::NextColumn();
+	}
+	ImGui::Separator();
 
-		if (Filter.Type == EFilterType::TextInclude || Filter.Type == EFilterType::TextExclude)
+	char Text[32];
+	auto AddUsageRow = [&Text](const char* Name, const FLogFileMemoryUsage& Usage)
+	{
+		ImGui::TextUnformatted(Name); ImGui::NextColumn();
+		const uint64_t Values[] = { Usage.Text, Usage.LineIndex, Usage.Metadata, Usage.DisplayLines, Usage.FilterCaches, Usage.SearchIndexes, Usage.GetTotal() };
+		for (uint64_t Value : Values)
 		{
-			const auto& FilterData = Filter.TextData;
-			bool bContains = FilterData.Token.empty() ? false :
-				FilterData.bCaseMatch ? Contains(Line, FilterData.Token) : ContainsByPred(Line, FilterData.Token, SearchPredCaseInvariant);
-
-			if (Filter.Type == EFilterType::TextInclude)
-			{
-				bIncludeFilterEncountered = true;
-				bIncluded |= bContains;
-			}
-			else if (Filter.Type == EFilterType::TextExclude)
-			{
-				bExcluded |= bContains;
-			}
+			FormatBytes(Text, Value);
+			ImGui::TextUnformatted(Text); ImGui::NextColumn();
 		}
-		else if (Filter.Type == EFilterType::LogCategory)
-		{
-			const auto& FilterData = Filter.LogCategoryData;
+	};
+	FLogFileMemoryUsage TotalUsage;
+	for (const FLogFile& File : OpenFiles)
+	{
+		const FLogFileMemoryUsage Usage = File.GetMemoryUsage();
+		AddUsageRow((File.FilePath + " (" + ELineStorageStrings[(int)File.Lines.GetStorage()] + ")").c_str(), Usage);
+		TotalUsage += Usage;
+	}
+	ImGui::Separator();
+	AddUsageRow("Total", TotalUsage);
+	ImGui::Columns(1);
 
-			if (FilterData.Verbosity != ELogVerbosity::VeryVerbose
-				&& !FilterData.Category.empty()
-				&& Contains(Line, FilterData.Category + ":"))
-			{
-				switch (FilterData.Verbosity)
-				{
-				case ELogVerbosity::Off:
-					bExcluded = true;
-					break;
-				case ELogVerbosity::Error:
-					bExcluded = !Contains(Line, FilterData.Category + ": Error:");
-					break;
-				case ELogVerbosity::Warning:
-					bExcluded = !(Contains(Line, FilterData.Category + ": Error:")
-						|| Contains(Line, FilterData.Category + ": Warning:"));
-					break;
-				case ELogVerbosity::Log:
-					bExcluded = Contains(Line, FilterData.Category + ": VeryVerbose:")
-						|| Contains(Line, FilterData.Category + ": Verbose:");
-					break;
-				case ELogVerbosity::Verbose:
-					bExcluded = Contains(Line, FilterData.Category + ": VeryVerbose:");
-					break;
-				}
-			}
-		}
-		else assert(false);
+	if (MemoryBudgetBytes > 0 && TotalUsage.GetTotal() > MemoryBudgetBytes)
+	{
+		ImGui::Separator();
+		ImGui::TextColored(TextColor_Warning, "Over budget, the visible files need more than the budget allows");
 	}
 
-	return !bExcluded && (bIncluded || !bIncludeFilterEncountered);
+	ImGui::End();
 }
 
-enum class ELogLineType
+#if ULV_WITH_PROFILER
+void SaveTrace()
 {
-	Normal,
-	Warning,
-	Error
-};
+	std::string FilePath = TraceOutputPath;
+	if (FilePath.empty())
+	{
+		char TimeString[32];
+		const time_t Now = time(nullptr);
+		strftime(TimeString, sizeof(TimeString), "%Y%m%d-%H%M%S", localtime(&Now));
+		FilePath = std::string("UnrealLogViewer-") + TimeString + ".trace.json";
+	}
+	Profiler::WriteChromeTrace(FilePath);
+}
 
-struct FLogLineMetadata
+void RenderProfilerWindow()
 {
-	FLogLineMetadata(const std::string& InText);
-	bool bContainsTimestamp = false;
-	ELogLineType LineType = ELogLineType::Normal;
+	if (!ImGui::Begin("Profiler", &bShowProfiler))
+	{
+		ImGui::End();
+		return;
+	}
 
-	static const int TimestampStartIdx = 0;
-	static const int TimestampEndIdx = TimestampStartIdx + 24;
-	static const int FrameStartIdx = TimestampEndIdx + 1;
-	static const int FrameEndIdx = FrameStartIdx + 4;
-};
+	float FrameHistoryMs[Profiler::NumFrameHistory];
+	Profiler::GetFrameHistory(FrameHistoryMs);
+	float MaxFrameMs = 0.0f, TotalFrameMs = 0.0f;
+	for (float FrameMs : FrameHistoryMs)
+	{
+		MaxFrameMs = std::max(MaxFrameMs, FrameMs);
+		TotalFrameMs += FrameMs;
+	}
+	ImGui::Text("Frame %.2f ms, average %.2f ms, max %.2f ms", FrameHistoryMs[Profiler::NumFrameHistory - 1], TotalFrameMs / Profiler::NumFrameHistory, MaxFrameMs);
+	ImGui::PlotLines("##FrameTimes", FrameHistoryMs, Profiler::NumFrameHistory, 0, nullptr, 0.0f, std::max(MaxFrameMs * 1.2f, 1.0f), ImVec2(-1.0f, 80.0f));
 
-FLogLineMetadata::FLogLineMetadata(const std::string& Text)
-{
-	if (Text[TimestampStartIdx] == '[' && Text[TimestampEndIdx] == ']' && Text[FrameStartIdx] == '[' && Text[FrameEndIdx] == ']') bContainsTimestamp = true;
-	
-	const int PostTimestampPos = bContainsTimestamp ? FrameEndIdx + 1 : 0;
-	if (StartsWith(Text, PostTimestampPos, "Log"))
+	static std::vector<Profiler::FJobSnapshot> Jobs;
+	Profiler::GetJobs(Jobs);
+	if (!Jobs.empty())
 	{
-		const int PosOfColon = FindPos(Text, PostTimestampPos, ": ");
-		if (PosOfColon > 0)
+		ImGui::Separator();
+		for (const Profiler::FJobSnapshot& Job : Jobs)
 		{
-			const int PosOfLogLevel = PosOfColon + 2;
-			if (StartsWith(Text, PosOfLogLevel, "Warning: ")) LineType = ELogLineType::Warning;
-			else if (StartsWith(Text, PosOfLogLevel, "Error: ")) LineType = ELogLineType::Error;
+			const float Fraction = Job.Total ? float(double(Job.Done) / Job.Total) : 0.0f;
+			ImGui::ProgressBar(Fraction, ImVec2(-1.0f, 0.0f), Job.Name.c_str());
 		}
+		// Keep the progress bars moving
+		App::RequestRedraw();
 	}
-}
 
-typedef std::vector<int> FDisplayLines;
-
-struct FLogFile
-{
-public:
-	FLogFile(const std::string& FilePath, std::vector<std::string>&& InLines);
-	std::string FilePath;
-	std::vector<std::string> Lines;
-	std::vector<FLogLineMetadata> LineMetadatas;
-	std::vector<FLineFilter> Filters;
-	mutable bool bDisplayTextDirty = true;
-
-	const FDisplayLines& GetDisplayLines() const
+	ImGui::Separator();
+	static std::vector<Profiler::FStatSnapshot> Stats;
+	Profiler::GetStats(Stats);
+	ImGui::Columns(7, "ProfilerStats");
+	ImGui::Text("Scope"); ImGui::NextColumn();
+	ImGui::Text("Frame ms"); ImGui::NextColumn();
+	ImGui::Text("Avg ms"); ImGui::NextColumn();
+	ImGui::Text("Max ms"); ImGui::NextColumn();
+	ImGui::Text("Calls"); ImGui::NextColumn();
+	ImGui::Text("Count"); ImGui::NextColumn();
+	ImGui::Text("Last run"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (const Profiler::FStatSnapshot& Stat : Stats)
 	{
-		if (bDisplayTextDirty)
+		ImGui::TextUnformatted(Stat.Name); ImGui::NextColumn();
+		ImGui::Text("%.3f", Stat.FrameMs); ImGui::NextColumn();
+		ImGui::Text("%.3f", Stat.AverageMs); ImGui::NextColumn();
+		ImGui::Text("%.3f", Stat.MaxMs); ImGui::NextColumn();
+		ImGui::Text("%llu", (unsigned long long)Stat.FrameCalls); ImGui::NextColumn();
+		ImGui::Text("%llu", (unsigned long long)Stat.TotalCount); ImGui::NextColumn();
+		if (Stat.LastRunMs > 0.0)
 		{
-			DisplayLines.clear();
-			DisplayLines.reserve(Lines.size());
-
-			std::string Line;
-			for (int LineIdx = 0; LineIdx < Lines.size(); ++LineIdx)
-			{
-				const std::string& Line = Lines[LineIdx];
-				if (DoFilterLine(Filters, Line))
-				{
-					DisplayLines.emplace_back(LineIdx);
-				}
-			}
-			bDisplayTextDirty = false;
+			const double Seconds = Stat.LastRunMs / 1000.0;
+			ImGui::Text("%.1f ms, %.2f Mlines/s, %.1f MB/s", Stat.LastRunMs, Stat.LastRunLines / Seconds / 1e6, Stat.LastRunBytes / Seconds / (1024.0 * 1024.0));
 		}
-		return DisplayLines;
+		ImGui::NextColumn();
 	}
+	ImGui::Columns(1);
 
-private:
-	mutable FDisplayLines DisplayLines;
-};
+	ImGui::End();
+}
+#endif
 
-FLogFile::FLogFile(const std::string& FilePath, std::vector<std::string>&& InLines)
-	: FilePath(FilePath)
-	, Lines(std::move(InLines))
+/** Lines of context an include filter shows around its matches, returns true if they changed */
+bool RenderFilterContext(FLineFilter& Filter)
 {
-	LineMetadatas.reserve(Lines.size());
-	for(int LineIdx = 0; LineIdx < Lines.size(); ++LineIdx)
-	{
-		const std::string& Line = Lines[LineIdx];
-		LineMetadatas.emplace_back(FLogLineMetadata(Line));
-	}
+	bool bChanged = ImGui::InputInt("Lines Before", &Filter.ContextBefore);
+	bChanged |= ImGui::InputInt("Lines After", &Filter.ContextAfter);
+	Filter.ContextBefore = std::max(0, std::min(Filter.ContextBefore, MaxContextLines));
+	Filter.ContextAfter = std::max(0, std::min(Filter.ContextAfter, MaxContextLines));
+	return bChanged;
 }
 
-static std::vector<FLogFile> OpenFiles;
-static ImVec4 TextColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
-static ImVec4 TextColor_Warning = ImVec4(1.0f, 1.0f, 0.0f, 1.0f);
-static ImVec4 TextColor_Error = ImVec4(1.0f, 0.0f, 0.0f, 1.0f);
-static bool bWordWrap = true;
-static bool bDisplayTimestamps = true;
-
-bool InputTextBox(const char* Label, std::string& InOutText)
+/** Editor of a region filter, with a list of the regions found to pick one of them from. Returns true if the filter changed. */
+bool RenderRegionFilter(FLogFile& File, int FileIdx, FLineFilter& Filter)
 {
-	static char Buf[1024];
-	STRNCPY(Buf, InOutText.c_str(), InOutText.size());
-	if (ImGui::InputText(Label, Buf, 1024))
+	auto& FilterData = Filter.RegionData;
+	bool bQueryChanged = InputTextBox("Start", FilterData.Start.Text);
+	bQueryChanged |= InputTextBox("End", FilterData.End.Text);
+	bQueryChanged |= ImGui::Checkbox("Case Sensitive", &FilterData.Start.bCaseMatch);
+	ImGui::SameLine();
+	bQueryChanged |= ImGui::Checkbox("Regex", &FilterData.Start.bRegex);
+	if (bQueryChanged)
 	{
-		InOutText = Buf;
+		// Found again by the next UpdateRegions
+		FilterData.End.bCaseMatch = FilterData.Start.bCaseMatch;
+		FilterData.End.bRegex = FilterData.Start.bRegex;
+		FilterData.Regions.reset();
+		FilterData.RegionIdx = -1;
 		return true;
 	}
-	return false;
-}
 
-void RenderTextWindow(const FLogFile& LogFile)
-{
-	const FDisplayLines& DisplayLines = LogFile.GetDisplayLines();
-	// Get width of the line number section
-	int NumLineNumChars = 1;
+	if (!FilterData.Regions || !FilterData.Regions->IsFound())
 	{
-		size_t BiggestLine = DisplayLines[DisplayLines.size()-1];
-		while (BiggestLine /= 10) ++NumLineNumChars;
+		ImGui::TextDisabled(Filter.bEnable ? "Finding regions..." : "Regions are found once the filter is enabled");
+		return false;
 	}
+	const std::vector<FLogRegion>& Regions = FilterData.Regions->GetRegions();
+	if (FilterData.RegionIdx >= int64_t(Regions.size())) FilterData.RegionIdx = -1;
 
-	if (bWordWrap)
+	auto FormatRegion = [&](uint64_t RegionIdx, char* Out, size_t OutSize)
 	{
-		ImGui::PushTextWrapPos(ImGui::GetWindowContentRegionWidth());
-	}
-	ImGuiListClipper Clipper((int)DisplayLines.size());
-	while (Clipper.Step())
+		const FLogRegion& Region = Regions[size_t(RegionIdx)];
+		char TimeText[TimeTextSize + 1] = {};
+		if (File.LineTimes.HasTimes()) FormatTime(File.LineTimes[Region.FirstLine], TimeText);
+		snprintf(Out, OutSize, "#%llu  %s  lines %llu-%llu", (unsigned long long)(RegionIdx + 1), TimeText, (unsigned long long)(Region.FirstLine + 1), (unsigned long long)Region.EndLine);
+	};
+	char Preview[128];
+	if (FilterData.RegionIdx < 0) snprintf(Preview, sizeof(Preview), "All %llu regions", (unsigned long long)Regions.size());
+	else FormatRegion(uint64_t(FilterData.RegionIdx), Preview, sizeof(Preview));
+
+	bool bChanged = false;
+	const float ComboWidth = ImGui::CalcItemWidth();
+	if (ImGui::BeginCombo("Region", Preview))
 	{
-		for (int ClipperIdx = Clipper.DisplayStart; ClipperIdx < Clipper.DisplayEnd; ++ClipperIdx)
+		if (ImGui::Selectable("All regions", FilterData.RegionIdx < 0))
 		{
-			int LineNumber = DisplayLines[ClipperIdx];
-			const std::string& LogLine = LogFile.Lines[LineNumber];
-			const FLogLineMetadata& LogLineMetadata = LogFile.LineMetadatas[LineNumber];
-
-			ImVec4 TextStyleColor;
-			switch (LogLineMetadata.LineType)
-			{
-			case ELogLineType::Warning: TextStyleColor = TextColor_Warning; break;
-			case ELogLineType::Error: TextStyleColor = TextColor_Error; break;
-			default: TextStyleColor = TextColor; break;
-			}
-			ImGui::PushStyleColor(ImGuiCol_Text, TextStyleColor);
-			ImGui::Text("%d", LineNumber + 1);
-			ImGui::SameLine(NumLineNumChars * ImGui::GetFontSize());
-
-			const char* TextPtr = LogLine.c_str();
-			TextPtr += !bDisplayTimestamps && LogLineMetadata.bContainsTimestamp ? FLogLineMetadata::FrameEndIdx+1 : 0;
-			ImGui::TextUnformatted(TextPtr);
-
-			ImGui::PopStyleColor();
-
-			// Content menu
+			FilterData.RegionIdx = -1;
+			bChanged = true;
+		}
+		const int NumListRows = int(std::min<size_t>(Regions.size(), 8));
+		if (ImGui::BeginChild("Regions", ImVec2(ComboWidth, NumListRows * ImGui::GetTextLineHeightWithSpacing())))
+		{
+			RenderScrolledRows(Regions.size(), RegionListScrollRow, RegionListScrollDirection, ListView, [&](uint64_t RegionIdx)
 			{
-				ImGui::PushID(ClipperIdx);
-				if (ImGui::BeginPopupContextItem("DisplayText context menu"))
+				char Label[128];
+				FormatRegion(RegionIdx, Label, sizeof(Label));
+				if (ImGui::Selectable(Label, int64_t(RegionIdx) == FilterData.RegionIdx))
 				{
-					if (ImGui::Selectable("Copy")) ImGui::SetClipboardText(LogLine.c_str());
-					ImGui::EndPopup();
+					FilterData.RegionIdx = int64_t(RegionIdx);
+					bChanged = true;
+					// Rebuild the display lines for the region before finding its first row
+					File.bDisplayTextDirty |= Filter.bEnable;
+					JumpToLine(FileIdx, Regions[size_t(RegionIdx)].FirstLine);
 				}
-				ImGui::PopID();
-			}
+			});
 		}
+		ImGui::EndChild();
+		ImGui::EndCombo();
 	}
-	if (bWordWrap)
-	{
-		ImGui::PopTextWrapPos();
-	}
+	ImGui::TextDisabled("Found in %.0f ms", FilterData.Regions->GetScanMs());
+	return bChanged;
 }
 
 namespace App
@@ -319,18 +1535,24 @@ namespace App
 
 bool RenderWindow()
 {
+#if ULV_WITH_PROFILER
+	const uint64_t FrameStartNs = Profiler::GetTimeNs();
+#endif
+	BeginRedrawFrame();
+
 	// Create test file
 	if (OpenFiles.size() == 0)
 	{
-		std::vector<std::string> Lines;
+		FLineStore Lines;
 		std::string TestLine;
 		for (int i = 0; i < 100; ++i)
 		{
 			TestLine += "Lorem ipsom etc ";
 		}
-		Lines.emplace_back(std::move(TestLine));
+		Lines.AddLine(TestLine);
 		for (char a = '0'; a <= 'z'; ++a)
-			Lines.emplace_back(&a);
+			Lines.AddLine(FStringView(&a, 1));
+		Lines.Finish();
 
 		OpenFiles.emplace_back(FLogFile("test", std::move(Lines)));
 	}
@@ -379,6 +1601,37 @@ bool RenderWindow()
 				ImGui::ColorEdit3("Text Color (Error)", &TextColor_Error.x, ImGuiColorEditFlags_None);
 				ImGui::Checkbox("Word Wrap", &bWordWrap);
 				ImGui::Checkbox("Display Timestamps", &bDisplayTimestamps);
+				ImGui::Checkbox("Show Memory", &bShowMemory);
+				bFocusMergedView |= ImGui::Checkbox("Show Merged View", &bShowMergedView) && bShowMergedView;
+				ImGui::Checkbox("Sync Scrolling", &bSyncScrolling);
+				bFocusDiff |= ImGui::Checkbox("Show Diff", &bShowDiff) && bShowDiff;
+				bFocusSearch |= ImGui::Checkbox("Show Search", &bShowSearch) && bShowSearch;
+				bFocusPatterns |= ImGui::Checkbox("Show Patterns", &bShowPatterns) && bShowPatterns;
+				bFocusFields |= ImGui::Checkbox("Show Fields", &bShowFields) && bShowFields;
+				ImGui::Checkbox("Show Timeline", &bShowTimeline);
+				ImGui::Checkbox("Show Density Map", &bShowDensityMap);
+				ImGui::Combo("Timeline Stack", (int*)&TimelineStack, ETimelineStackStrings, (int)ETimelineStack::MAX);
+				ImGui::SliderInt("Timeline Categories", &TimelineNumCategories, 1, FLogTimeline::MaxCategories);
+				int StorageItem = bAutoStorage ? 0 : (int)Storage + 1;
+				auto GetStorageItem = [](void*, int Idx, const char** OutText) { *OutText = Idx == 0 ? "Auto" : ELineStorageStrings[Idx - 1]; return true; };
+				if (ImGui::Combo("Storage", &StorageItem, GetStorageItem, nullptr, (int)ELineStorage::MAX + 1))
+				{
+					bAutoStorage = StorageItem == 0;
+					Storage = bAutoStorage ? ELineStorage::Memory : ELineStorage(StorageItem - 1);
+				}
+				ImGui::Checkbox("Cache Line Indexes", &bUseIndexCache);
+#if ULV_WITH_PROFILER
+				ImGui::Checkbox("Show Profiler", &bShowProfiler);
+				bool bTraceEnabled = Profiler::IsTraceEnabled();
+				if (ImGui::Checkbox("Record Trace", &bTraceEnabled))
+				{
+					Profiler::SetTraceEnabled(bTraceEnabled);
+				}
+				if (ImGui::MenuItem("Save Trace"))
+				{
+					SaveTrace();
+				}
+#endif
 				ImGui::EndMenu();
 			}
 			ImGui::EndMenuBar();
@@ -387,19 +1640,36 @@ bool RenderWindow()
 		ImGui::End();
 	}
 
-	static bool show_demo_window = true;
-	ImGui::SetNextWindowDockID(dockspace_id, ImGuiCond_Once);
-	ImGui::ShowDemoWindow(&show_demo_window);
+	if (bShowDemoWindow)
+	{
+		ImGui::SetNextWindowDockID(dockspace_id, ImGuiCond_Once);
+		ImGui::ShowDemoWindow(&bShowDemoWindow);
+	}
+
+#if ULV_WITH_PROFILER
+	if (bShowProfiler)
+	{
+		RenderProfilerWindow();
+	}
+#endif
+
+	if (bShowMemory)
+	{
+		RenderMemoryWindow();
+	}
 
 	for (FLogFile& File : OpenFiles)
 	{
+		File.UpdateRegions(App::RequestRedraw);
 		ImGui::SetNextWindowDockID(dockspace_id, ImGuiCond_Once);
 
 		if (ImGui::Begin(File.FilePath.c_str(), nullptr, ImGuiWindowFlags_None))
 		{
-			if (ImGui::BeginChild("TextRegion", ImVec2(ImGui::GetWindowContentRegionWidth() * 0.85f, 0), false, ImGuiWindowFlags_HorizontalScrollbar))
+			File.LastViewedFrame = ImGui::GetFrameCount();
+
+			if (ImGui::BeginChild("TextRegion", ImVec2(ImGui::GetWindowContentRegionWidth() * 0.85f, 0), false, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse))
 			{
-				RenderTextWindow(File);
+				RenderTextWindow(File, int(&File - OpenFiles.data()));
 			}
 			ImGui::EndChild();
 
@@ -407,6 +1677,10 @@ bool RenderWindow()
 
 			if (ImGui::BeginChild("ConfigRegion"))
 			{
+				if (ImGui::Checkbox("Collapse Duplicates", &File.bCollapseDuplicates))
+				{
+					File.bDisplayTextDirty = true;
+				}
 				if (ImGui::Button("Add Filter"))
 				{
 					File.Filters.emplace_back(FLineFilter());
@@ -420,12 +1694,23 @@ bool RenderWindow()
 					ImGui::PushID(LineFilterIdx);
 
 					bool bFilterDirty = false;
+					const EFilterType PrevType = LineFilter.Type;
 					bFilterDirty |= ImGui::Combo("Type", (int*)&LineFilter.Type, EFilterTypeStrings, int(EFilterType::MAX));
+					if (LineFilter.Type == EFilterType::TimeRange && PrevType != EFilterType::TimeRange && File.LineTimes.Num() > 0)
+					{
+						// A new time range starts as the whole log, so it shows every line until it is narrowed
+						LineFilter.TimeRangeData.StartMs = File.LineTimes[0];
+						LineFilter.TimeRangeData.EndMs = File.LineTimes[File.LineTimes.Num() - 1] + 1;
+					}
 					if (LineFilter.Type == EFilterType::TextInclude || LineFilter.Type == EFilterType::TextExclude)
 					{
 						auto& FilterData = LineFilter.TextData;
 						bFilterDirty |= InputTextBox("Token", FilterData.Token);
 						bFilterDirty |= ImGui::Checkbox("Case Sensitive", &FilterData.bCaseMatch);
+						if (LineFilter.Type == EFilterType::TextInclude)
+						{
+							bFilterDirty |= RenderFilterContext(LineFilter);
+						}
 						//ImGui::SameLine();
 						//bFilterDirty |= ImGui::Checkbox("Regex", &LineFilter.bRegex);
 					}
@@ -435,6 +1720,42 @@ bool RenderWindow()
 						bFilterDirty |= InputTextBox("Category", FilterData.Category);
 						bFilterDirty |= ImGui::Combo("Verbosity", (int*)&FilterData.Verbosity, ELogVerbosityStrings, int(ELogVerbosity::MAX));
 					}
+					else if (LineFilter.Type == EFilterType::TemplateInclude || LineFilter.Type == EFilterType::TemplateExclude)
+					{
+						const auto& FilterData = LineFilter.TemplateData;
+						ImGui::TextWrapped("%s", FilterData.TemplateId == FLogTemplates::NoTemplate ? "Pick a pattern in the Patterns view" : FilterData.Text.c_str());
+						if (LineFilter.Type == EFilterType::TemplateInclude)
+						{
+							bFilterDirty |= RenderFilterContext(LineFilter);
+						}
+					}
+					else if (LineFilter.Type == EFilterType::TimeRange)
+					{
+						// Edited as text, and only taken once it is a valid time
+						auto& FilterData = LineFilter.TimeRangeData;
+						char TimeText[TimeTextSize + 1] = {};
+						FormatTime(FilterData.StartMs, TimeText);
+						std::string StartText = TimeText;
+						bFilterDirty |= InputTextBox("From", StartText) && ParseTime(StartText.data(), StartText.size(), FilterData.StartMs);
+						FormatTime(FilterData.EndMs, TimeText);
+						std::string EndText = TimeText;
+						bFilterDirty |= InputTextBox("To", EndText) && ParseTime(EndText.data(), EndText.size(), FilterData.EndMs);
+					}
+					else if (LineFilter.Type == EFilterType::FrameRange)
+					{
+						// Relative frames, the line context menu shows the frame of a line
+						auto& FilterData = LineFilter.FrameRangeData;
+						bFilterDirty |= ImGui::InputScalar("First Relative Frame", ImGuiDataType_S64, &FilterData.FirstFrame);
+						bFilterDirty |= ImGui::InputScalar("Last Relative Frame", ImGuiDataType_S64, &FilterData.LastFrame);
+						if (File.LineTimes.Num() > 0)
+						{
+							ImGui::TextDisabled("Log spans frames %lld to %lld", (long long)File.LineTimes.GetFrame(0), (long long)File.LineTimes.GetFrame(File.LineTimes.Num() - 1));
+						}
+					}
+					else if (LineFilter.Type == EFilterType::Region)
+					{
+						bFilterDirty |= RenderRegionFilter(File, int(&File - OpenFiles.data()), LineFilter);
+					}
 
 					bool bEnableChanged = ImGui::Checkbox("Enable", &LineFilter.bEnable);
 					ImGui::SameLine();
@@ -455,18 +1776,336 @@ bool RenderWindow()
 		ImGui::End();
 	}
 
+	if (bShowMergedView)
+	{
+		ImGui::SetNextWindowDockID(dockspace_id, ImGuiCond_Once);
+		RenderMergedWindow();
+	}
+
+	if (bShowDiff)
+	{
+		ImGui::SetNextWindowDockID(dockspace_id, ImGuiCond_Once);
+		RenderDiffWindow();
+	}
+
+	if (bShowSearch)
+	{
+		ImGui::SetNextWindowDockID(dockspace_id, ImGuiCond_Once);
+		RenderSearchWindow();
+	}
+
+	if (bShowPatterns)
+	{
+		ImGui::SetNextWindowDockID(dockspace_id, ImGuiCond_Once);
+		RenderPatternsWindow();
+	}
+
+	if (bShowFields)
+	{
+		ImGui::SetNextWindowDockID(dockspace_id, ImGuiCond_Once);
+		RenderFieldsWindow();
+	}
+
+	PendingScrollLines = 0.0f;
+
+	EnforceMemoryBudget();
+
+	EndRedrawFrame();
+
+#if ULV_WITH_PROFILER
+	Profiler::EndFrame(FrameStartNs);
+#endif
+
 	return bAppContinue;
 }
 
 void OpenAdditionalFile(const std::string& FilePath)
 {
-	OpenFiles.emplace_back(FLogFile(FilePath, FileUtils::ReadFileContents(FilePath)));
+	ULV_PROFILE_SCOPE("App::OpenAdditionalFile");
+	ELineStorage FileStorage = Storage;
+	if (bAutoStorage)
+	{
+		const uint64_t AutoPagedFileSize = MemoryBudgetBytes ? MemoryBudgetBytes / 2 : 4ull * 1024 * 1024 * 1024;
+		FileStorage = FileUtils::GetFileSize(FilePath) > AutoPagedFileSize ? ELineStorage::Paged : ELineStorage::Memory;
+	}
+	// Opening a file can move the others, so they cannot be searched, compared, mined or extracted from meanwhile
+	GlobalSearch.Cancel();
+	LogDiff.Cancel();
+	if (FieldExtraction.IsRunning())
+	{
+		FieldExtraction.Cancel();
+		FieldExtractionFileIdx = -1;
+	}
+	for (FLogFile& File : OpenFiles)
+	{
+		File.CancelRegionScans();
+		File.CancelTemplateMining();
+	}
+	if (bUseIndexCache)
+	{
+		OpenFiles.emplace_back(LogIndexCache::OpenLogFile(FilePath, FileStorage));
+	}
+	else
+	{
+		OpenFiles.emplace_back(FLogFile(FilePath, FileUtils::ReadFileContents(FilePath, FileStorage)));
+	}
+	OpenFiles.back().Lines.SetCacheBudget(PageCacheBytes);
+	RequestRedraw();
+}
+
+void RequestRedraw()
+{
+	bRedrawRequested = true;
+	if (void (*Callback)() = RedrawCallback.load())
+	{
+		Callback();
+	}
+}
+
+void SetRedrawCallback(void (*Callback)())
+{
+	RedrawCallback = Callback;
+}
+
+double GetRedrawTimeout()
+{
+	return bRedrawRequested ? 0.0 : RedrawTimeout;
+}
+
+void SetWordWrap(bool bEnable)
+{
+	bWordWrap = bEnable;
+	RequestRedraw();
+}
+
+void SetShowDemoWindow(bool bShow)
+{
+	bShowDemoWindow = bShow;
+	RequestRedraw();
+}
+
+void SetShowMergedView(bool bShow)
+{
+	bShowMergedView = bShow;
+	bFocusMergedView = bShow;
+	RequestRedraw();
+}
+
+void SetShowTimeline(bool bShow, const std::string& Stack)
+{
+	bShowTimeline = bShow;
+	const char** StackString = std::find(ETimelineStackStrings, ETimelineStackStrings + (int)ETimelineStack::MAX, Stack);
+	if (StackString != ETimelineStackStrings + (int)ETimelineStack::MAX)
+	{
+		TimelineStack = ETimelineStack(StackString - ETimelineStackStrings);
+	}
+	RequestRedraw();
+}
+
+bool ToggleBookmark(int FileIdx, uint64_t LineIdx)
+{
+	if (FileIdx < 0 || FileIdx >= int(OpenFiles.size()) || LineIdx >= OpenFiles[FileIdx].Lines.Num()) return false;
+	::ToggleBookmark(OpenFiles[FileIdx], LineIdx);
+	RequestRedraw();
+	return true;
+}
+
+void SetCollapseDuplicates(bool bEnable)
+{
+	for (FLogFile& File : OpenFiles)
+	{
+		File.bCollapseDuplicates = bEnable;
+		File.bDisplayTextDirty = true;
+	}
+	RequestRedraw();
+}
+
+void SetSyncScrolling(bool bEnable)
+{
+	bSyncScrolling = bEnable;
+	RequestRedraw();
+}
+
+bool ShowDiff(int LeftFileIdx, int RightFileIdx)
+{
+	if (LeftFileIdx < 0 || RightFileIdx < 0 || LeftFileIdx >= int(OpenFiles.size()) || RightFileIdx >= int(OpenFiles.size())) return false;
+	DiffLeftFileIdx = LeftFileIdx;
+	DiffRightFileIdx = RightFileIdx;
+	CompareDiffFiles();
+	bShowDiff = bFocusDiff = true;
+	RequestRedraw();
+	return true;
+}
+
+bool Search(const std::string& Text, bool bCaseMatch, bool bRegex)
+{
+	SearchQuery.Text = Text;
+	SearchQuery.bCaseMatch = bCaseMatch;
+	SearchQuery.bRegex = bRegex;
+	StartSearch();
+	bShowSearch = bFocusSearch = true;
+	RequestRedraw();
+	return bSearchQueryValid;
+}
+
+bool ShowPatterns(int FileIdx)
+{
+	if (FileIdx < 0 || FileIdx >= int(OpenFiles.size())) return false;
+	PatternsFileIdx = FileIdx;
+	bShowPatterns = bFocusPatterns = true;
+	RequestRedraw();
+	return true;
+}
+
+bool ExtractField(int FileIdx, const std::string& Anchor, const std::string& Type)
+{
+	if (FileIdx < 0 || FileIdx >= int(OpenFiles.size()) || Anchor.empty()) return false;
+	const char** TypeName = std::find(EFieldTypeStrings, EFieldTypeStrings + (int)EFieldType::MAX, Type);
+	if (TypeName == EFieldTypeStrings + (int)EFieldType::MAX) return false;
+	FieldsFileIdx = FileIdx;
+	FieldRule.Anchor = Anchor;
+	FieldRule.Type = EFieldType(TypeName - EFieldTypeStrings);
+	ExtractedFieldRule = FieldRule;
+	FieldExtractionFileIdx = -1;
+	bShowFields = bFocusFields = true;
+	RequestRedraw();
+	return true;
+}
+
+bool IsSearching()
+{
+	return GlobalSearch.IsRunning();
+}
+
+bool IsComparing()
+{
+	return LogDiff.IsRunning();
+}
+
+bool IsExtractingFields()
+{
+	return bShowFields && FieldExtraction.IsRunning();
+}
+
+bool IsMiningPatterns()
+{
+	return bShowPatterns && PatternsFileIdx < int(OpenFiles.size()) && OpenFiles[PatternsFileIdx].IsMiningTemplates();
+}
+
+void ScrollTextWindows(float DeltaLines)
+{
+	PendingScrollLines += DeltaLines;
+	RequestRedraw();
+}
+
+bool AddFilter(const std::string& Type, const std::string& Value, const std::string& Option)
+{
+	FLineFilter Filter;
+	Filter.bEnable = true;
+
+	const char** TypeString = std::find(EFilterTypeStrings, EFilterTypeStrings + (int)EFilterType::MAX, Type);
+	if (TypeString == EFilterTypeStrings + (int)EFilterType::MAX) return false;
+	Filter.Type = EFilterType(TypeString - EFilterTypeStrings);
+
+	if (Filter.Type == EFilterType::TextInclude || Filter.Type == EFilterType::TextExclude)
+	{
+		if (!Option.empty() && Option != "case") return false;
+		Filter.TextData.Token = Value;
+		Filter.TextData.bCaseMatch = !Option.empty();
+	}
+	else if (Filter.Type == EFilterType::TimeRange)
+	{
+		if (!ParseTime(Value.data(), Value.size(), Filter.TimeRangeData.StartMs) || !ParseTime(Option.data(), Option.size(), Filter.TimeRangeData.EndMs)) return false;
+	}
+	else if (Filter.Type == EFilterType::FrameRange)
+	{
+		char* ValueEnd;
+		char* OptionEnd;
+		Filter.FrameRangeData.FirstFrame = strtoll(Value.c_str(), &ValueEnd, 10);
+		Filter.FrameRangeData.LastFrame = strtoll(Option.c_str(), &OptionEnd, 10);
+		if (Value.empty() || Option.empty() || *ValueEnd || *OptionEnd) return false;
+	}
+	else if (Filter.Type == EFilterType::Region)
+	{
+		Filter.RegionData.Start.Text = Value;
+		Filter.RegionData.End.Text = Option;
+	}
+	else if (Filter.Type == EFilterType::LogCategory)
+	{
+		Filter.LogCategoryData.Category = Value;
+		if (!Option.empty())
+		{
+			const char** VerbosityString = std::find(ELogVerbosityStrings, ELogVerbosityStrings + (int)ELogVerbosity::MAX, Option);
+			if (VerbosityString == ELogVerbosityStrings + (int)ELogVerbosity::MAX) return false;
+			Filter.LogCategoryData.Verbosity = ELogVerbosity(VerbosityString - ELogVerbosityStrings);
+		}
+	}
+
+	for (FLogFile& File : OpenFiles)
+	{
+		File.Filters.push_back(Filter);
+		File.bDisplayTextDirty = true;
+	}
+	RequestRedraw();
+	return true;
+}
+
+bool SetFilterContext(int Before, int After)
+{
+	for (FLogFile& File : OpenFiles)
+	{
+		if (File.Filters.empty()) return false;
+		File.Filters.back().ContextBefore = Before;
+		File.Filters.back().ContextAfter = After;
+		File.bDisplayTextDirty = true;
+	}
+	RequestRedraw();
+	return true;
 }
 
 void Startup(int argc, char** argv)
 {
+#if ULV_WITH_PROFILER
+	Profiler::SetThreadName("Main");
+#endif
+
+	// "--trace <file>" records a trace from startup and writes it on exit
+	// "--memory-budget <MB>" sets the memory budget of the open files
+	// "--storage Auto|Memory|Paged|Compressed|Deduplicated" sets how the text of the files is stored
+	// "--index-cache On|Off" sets whether line indexes are cached next to the files
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (strcmp(argv[i], "--memory-budget") == 0)
+		{
+			MemoryBudgetBytes = strtoull(argv[i + 1], nullptr, 10) * 1024 * 1024;
+		}
+		else if (strcmp(argv[i], "--storage") == 0)
+		{
+			const char** StorageString = std::find_if(ELineStorageStrings, ELineStorageStrings + (int)ELineStorage::MAX, [&](const char* String) { return strcmp(String, argv[i + 1]) == 0; });
+			bAutoStorage = StorageString == ELineStorageStrings + (int)ELineStorage::MAX;
+			Storage = bAutoStorage ? ELineStorage::Memory : ELineStorage(StorageString - ELineStorageStrings);
+		}
+		else if (strcmp(argv[i], "--index-cache") == 0)
+		{
+			bUseIndexCache = strcmp(argv[i + 1], "Off") != 0;
+		}
+		else if (strcmp(argv[i], "--trace") == 0)
+		{
+#if ULV_WITH_PROFILER
+			TraceOutputPath = argv[i + 1];
+			Profiler::SetTraceEnabled(true);
+			atexit([]() { Profiler::WriteChromeTrace(TraceOutputPath); });
+#endif
+		}
+	}
+
 	for (int i = 1; i < argc; ++i)
 	{
+		if (strcmp(argv[i], "--trace") == 0 || strcmp(argv[i], "--memory-budget") == 0 || strcmp(argv[i], "--storage") == 0 || strcmp(argv[i], "--index-cache") == 0)
+		{
+			++i;
+			continue;
+		}
 		OpenAdditionalFile(argv[i]);
 	}
 }
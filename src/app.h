@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace App
@@ -12,4 +13,57 @@ namespace App
 
 	void OpenAdditionalFile(const std::string& FilePath);
 
+	// Render-on-demand. Hosts should sleep until there is input, a redraw request, or GetRedrawTimeout() has elapsed.
+
+	// Thread safe. Asks the host to render another frame as soon as possible.
+	void RequestRedraw();
+
+	// Called by RequestRedraw (possibly from a worker thread) so the host can wake up its frame loop.
+	void SetRedrawCallback(void (*Callback)());
+
+	// Seconds the host may wait for input before rendering the next frame.
+	// 0 means render again immediately, negative means wait for input indefinitely.
+	double GetRedrawTimeout();
+
+	// Automation hooks, used by the headless host to script interactions without going through input events.
+
+	void SetWordWrap(bool bEnable);
+	void SetShowDemoWindow(bool bShow);
+	void SetShowMergedView(bool bShow);
+	void SetSyncScrolling(bool bEnable);
+	void SetCollapseDuplicates(bool bEnable);
+	bool ToggleBookmark(int FileIdx, uint64_t LineIdx);
+	/** Stack is a timeline stack name, anything else keeps the current one */
+	void SetShowTimeline(bool bShow, const std::string& Stack);
+
+	// Compares two of the open files, by their index in the order they were opened, and shows the diff.
+	// Returns false if there is no such file.
+	bool ShowDiff(int LeftFileIdx, int RightFileIdx);
+	bool IsComparing();
+
+	// Searches every open file in the background and shows the hits. Returns false if the text is an invalid regex.
+	bool Search(const std::string& Text, bool bCaseMatch, bool bRegex);
+	bool IsSearching();
+
+	// Mines the templates of one of the open files and shows them. Returns false if there is no such file.
+	bool ShowPatterns(int FileIdx);
+	bool IsMiningPatterns();
+
+	// Extracts the values that follow Anchor in the display lines of one of the open files and shows their statistics.
+	// Type is one of the field type names shown in the UI. Returns false if there is no such file or type.
+	bool ExtractField(int FileIdx, const std::string& Anchor, const std::string& Type);
+	bool IsExtractingFields();
+
+	// Scrolls every visible text window by the given number of lines on the next frame
+	void ScrollTextWindows(float DeltaLines);
+
+	// Adds an enabled filter to every open file. Type is one of the filter type names shown in the UI.
+	// Option is "case" for a case sensitive text filter, or the verbosity name for a log category filter.
+	// Returns false if the type or option is not recognised.
+	bool AddFilter(const std::string& Type, const std::string& Value, const std::string& Option);
+
+	// Shows lines of context before and after the matches of the last filter added to every open file.
+	// Returns false if a file has no filters.
+	bool SetFilterContext(int Before, int After);
+
 }
@@ -26,6 +26,7 @@
 static ID3D10Device*            g_pd3dDevice = NULL;
 static IDXGISwapChain*          g_pSwapChain = NULL;
 static ID3D10RenderTargetView*  g_mainRenderTargetView = NULL;
+static HWND                     g_hWnd = NULL;
 
 // Forward declarations of helper functions
 bool CreateDeviceD3D(HWND hWnd);
@@ -52,6 +53,7 @@ int main(int argc, char** argv)
 	WNDCLASSEX wc = { sizeof(WNDCLASSEX), CS_CLASSDC, WndProc, 0L, 0L, GetModuleHandle(NULL), NULL, NULL, NULL, NULL, _T("ImGui Example"), NULL };
 	::RegisterClassEx(&wc);
 	HWND hwnd = ::CreateWindow(wc.lpszClassName, _T("Unreal Log Viewer"), WS_OVERLAPPEDWINDOW, 100, 100, 1280, 800, NULL, NULL, wc.hInstance, NULL);
+	g_hWnd = hwnd;
 
 	FDropTarget DropTarget;
 	OleInitialize(NULL);
@@ -102,6 +104,9 @@ int main(int argc, char** argv)
 	//ImFont* font = io.Fonts->AddFontFromFileTTF("c:\\Windows\\Fonts\\ArialUni.ttf", 18.0f, NULL, io.Fonts->GetGlyphRangesJapanese());
 	//IM_ASSERT(font != NULL);
     
+	// Redraw requests may come from worker threads, post an empty message to wake up the main loop
+	App::SetRedrawCallback([]() { ::PostMessage(g_hWnd, WM_NULL, 0, 0); });
+
     App::Startup(argc, argv);
 
 	// Main loop
@@ -110,17 +115,28 @@ int main(int argc, char** argv)
 	bool app_continue = true;
 	while (msg.message != WM_QUIT && app_continue)
 	{
+		// Sleep until there is input, a redraw request, or the app wants another frame
+		const double redraw_timeout = App::GetRedrawTimeout();
+		if (redraw_timeout != 0.0)
+		{
+			const DWORD timeout_ms = redraw_timeout < 0.0 ? INFINITE : (DWORD)(redraw_timeout * 1000.0);
+			::MsgWaitForMultipleObjectsEx(0, NULL, timeout_ms, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+		}
+
 		// Poll and handle messages (inputs, window resize, etc.)
 		// You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
 		// - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
 		// - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
 		// Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-		if (::PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE))
+		while (::PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE))
 		{
 			::TranslateMessage(&msg);
 			::DispatchMessage(&msg);
-			continue;
+			if (msg.message == WM_QUIT)
+				break;
 		}
+		if (msg.message == WM_QUIT)
+			break;
 
 		// Start the Dear ImGui frame
 		ImGui_ImplDX10_NewFrame();